@@ -0,0 +1,297 @@
+/*
+ *
+ * Tad ModeloAdaptativo
+ * Huffman adaptativo (algoritmo FGK): a árvore começa vazia e é atualizada a
+ * cada símbolo, igual no codificador e no decodificador, então a entrada é
+ * lida uma única vez e nenhuma tabela vai no cabeçalho
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "adaptativo.h"
+#include "huffman.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+// as folhas dos símbolos, o nó vazio, que nunca sai da árvore, e os nós
+// internos
+#define MAX_NOS (2 * NUM_SIMBOLOS + 1)
+#define RAIZ (MAX_NOS - 1)
+#define SEM_NO -1
+#define SIMBOLO_VAZIO -2 // folha dos símbolos ainda não vistos
+#define TAMANHO_BUFFER_SAIDA (64 * 1024)
+
+// o mesmo nó da Arvore, com a ligação para o pai que a atualização precisa;
+// os nós ficam em um vetor e as ligações são índices
+typedef struct {
+  uint64_t frequencia;
+  int caractere; // SEM_NO nos nós internos
+  int esquerda;
+  int direita;
+  int pai;
+} NoAdaptativo;
+
+// Propriedade dos irmãos: as frequências não diminuem com o índice, a raiz é
+// o último nó e os dois filhos de um nó interno ficam lado a lado. Os nós
+// novos são criados abaixo do nó vazio, que tem sempre o menor índice usado.
+struct modeloAdaptativo {
+  NoAdaptativo nos[MAX_NOS];
+  int folha[NUM_SIMBOLOS]; // nó de cada símbolo, ou SEM_NO
+  int vazio;               // folha dos símbolos ainda não vistos
+};
+
+ModeloAdaptativo *criaModeloAdaptativo(void) {
+  ModeloAdaptativo *m = malloc(sizeof(ModeloAdaptativo));
+  if (m == NULL) {
+    exit(1);
+  }
+  reiniciaModeloAdaptativo(m);
+  return m;
+}
+
+void reiniciaModeloAdaptativo(ModeloAdaptativo *m) {
+  for (int i = 0; i < NUM_SIMBOLOS; i++) {
+    m->folha[i] = SEM_NO;
+  }
+
+  NoAdaptativo *raiz = &m->nos[RAIZ];
+  raiz->frequencia = 0;
+  raiz->caractere = SIMBOLO_VAZIO;
+  raiz->esquerda = SEM_NO;
+  raiz->direita = SEM_NO;
+  raiz->pai = SEM_NO;
+  m->vazio = RAIZ;
+}
+
+// atualiza as ligações que apontam para o conteúdo que acabou de chegar ao nó
+static void ajustaLigacoes(ModeloAdaptativo *m, int no) {
+  NoAdaptativo *n = &m->nos[no];
+  if (n->esquerda != SEM_NO) {
+    m->nos[n->esquerda].pai = no;
+    m->nos[n->direita].pai = no;
+  } else if (n->caractere == SIMBOLO_VAZIO) {
+    m->vazio = no;
+  } else {
+    m->folha[n->caractere] = no;
+  }
+}
+
+// Troca o nó pelo último do seu bloco (o de maior índice com a mesma
+// frequência), que é encontrado por busca binária, já que as frequências
+// estão em ordem. As subárvores trocam de posição; cada posição mantém o
+// seu pai. Retorna a nova posição do nó.
+static int trocaComLider(ModeloAdaptativo *m, int no) {
+  uint64_t frequencia = m->nos[no].frequencia;
+
+  // caso mais comum: o nó já é o último do bloco
+  if (no == RAIZ || m->nos[no + 1].frequencia != frequencia) {
+    return no;
+  }
+
+  int inicio = no;
+  int fim = RAIZ;
+  while (inicio < fim) {
+    int meio = inicio + (fim - inicio + 1) / 2;
+    if (m->nos[meio].frequencia == frequencia) {
+      inicio = meio;
+    } else {
+      fim = meio - 1;
+    }
+  }
+
+  int lider = inicio;
+  if (lider == no || lider == m->nos[no].pai) {
+    return no;
+  }
+
+  NoAdaptativo *a = &m->nos[no];
+  NoAdaptativo *b = &m->nos[lider];
+  int caractere = a->caractere;
+  int esquerda = a->esquerda;
+  int direita = a->direita;
+  a->caractere = b->caractere;
+  a->esquerda = b->esquerda;
+  a->direita = b->direita;
+  b->caractere = caractere;
+  b->esquerda = esquerda;
+  b->direita = direita;
+  ajustaLigacoes(m, no);
+  ajustaLigacoes(m, lider);
+
+  return lider;
+}
+
+// incrementa a frequência do símbolo e dos seus ancestrais, trocando cada nó
+// com o líder do seu bloco antes do incremento para manter a propriedade
+// dos irmãos
+static void atualizaModelo(ModeloAdaptativo *m, int simbolo) {
+  NoAdaptativo *nos = m->nos;
+  int no;
+  int folhaPendente = SEM_NO;
+
+  if (m->folha[simbolo] == SEM_NO) {
+    // o nó vazio vira um nó interno com o novo vazio à esquerda e a folha do
+    // símbolo à direita
+    int pai = m->vazio;
+    int novoVazio = pai - 2;
+    int novaFolha = pai - 1;
+
+    nos[novaFolha].frequencia = 0;
+    nos[novaFolha].caractere = simbolo;
+    nos[novaFolha].esquerda = SEM_NO;
+    nos[novaFolha].direita = SEM_NO;
+    nos[novaFolha].pai = pai;
+
+    nos[novoVazio].frequencia = 0;
+    nos[novoVazio].caractere = SIMBOLO_VAZIO;
+    nos[novoVazio].esquerda = SEM_NO;
+    nos[novoVazio].direita = SEM_NO;
+    nos[novoVazio].pai = pai;
+
+    nos[pai].caractere = SEM_NO;
+    nos[pai].esquerda = novoVazio;
+    nos[pai].direita = novaFolha;
+
+    m->folha[simbolo] = novaFolha;
+    m->vazio = novoVazio;
+    no = pai;
+    folhaPendente = novaFolha;
+  } else {
+    no = trocaComLider(m, m->folha[simbolo]);
+    // irmã do nó vazio: a folha tem a mesma frequência do pai, então é
+    // incrementada só depois dele
+    if (nos[nos[no].pai].esquerda == m->vazio) {
+      folhaPendente = no;
+      no = nos[no].pai;
+    }
+  }
+
+  while (no != SEM_NO) {
+    no = trocaComLider(m, no);
+    nos[no].frequencia++;
+    no = nos[no].pai;
+  }
+
+  if (folhaPendente != SEM_NO) {
+    no = trocaComLider(m, folhaPendente);
+    nos[no].frequencia++;
+  }
+}
+
+// escreve o caminho da raiz até o nó; ele é montado de baixo para cima em
+// palavras de 64 bits, já que a árvore pode passar de 64 níveis
+static void escreveCaminho(const ModeloAdaptativo *m, EscritorBits *e,
+                           int no) {
+  uint64_t palavras[(MAX_NOS + 63) / 64] = {0};
+  unsigned int profundidade = 0;
+
+  while (no != RAIZ) {
+    int pai = m->nos[no].pai;
+    if (m->nos[pai].direita == no) {
+      palavras[profundidade / 64] |= (uint64_t)1 << (profundidade % 64);
+    }
+    profundidade++;
+    no = pai;
+  }
+
+  if (profundidade == 0) {
+    return;
+  }
+
+  // a palavra mais alta tem o início do caminho
+  int ultima = (int)((profundidade - 1) / 64);
+  unsigned int bitsUltima = profundidade - 64 * (unsigned int)ultima;
+  escreveCodigo(e, palavras[ultima], bitsUltima);
+  for (int i = ultima - 1; i >= 0; i--) {
+    escreveCodigo(e, palavras[i], 64);
+  }
+}
+
+void codificaAdaptativo(ModeloAdaptativo *m, EscritorBits *e, int simbolo) {
+  int folha = m->folha[simbolo];
+  if (folha != SEM_NO) {
+    escreveCaminho(m, e, folha);
+  } else {
+    escreveCaminho(m, e, m->vazio);
+    escreveCodigo(e, (uint64_t)simbolo, BITS_SIMBOLO_NOVO);
+  }
+  atualizaModelo(m, simbolo);
+}
+
+void codificaBytesAdaptativo(ModeloAdaptativo *m, EscritorBits *e,
+                             const unsigned char *dados, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    codificaAdaptativo(m, e, dados[i]);
+  }
+}
+
+int decodificaAdaptativo(ModeloAdaptativo *m, LeitorBits *l) {
+  const NoAdaptativo *nos = m->nos;
+  int no = RAIZ;
+
+  // desce a árvore consumindo até 32 bits por recarga do leitor
+  while (nos[no].esquerda != SEM_NO) {
+    recarregaLeitor(l);
+    uint32_t janela = espiaBits(l, 32);
+    unsigned int usados = 0;
+    while (nos[no].esquerda != SEM_NO && usados < 32) {
+      no = (janela >> (31 - usados)) & 1 ? nos[no].direita : nos[no].esquerda;
+      usados++;
+    }
+    consomeBits(l, usados);
+  }
+
+  int simbolo = nos[no].caractere;
+  if (simbolo == SIMBOLO_VAZIO) {
+    simbolo = (int)leBits(l, BITS_SIMBOLO_NOVO);
+    if (simbolo >= NUM_SIMBOLOS || m->folha[simbolo] != SEM_NO) {
+      return -1;
+    }
+  }
+
+  atualizaModelo(m, simbolo);
+  return simbolo;
+}
+
+int decodificaAdaptativoAteEOF(ModeloAdaptativo *m, LeitorBits *l,
+                               FILE *saida) {
+  unsigned char *buffer = malloc(TAMANHO_BUFFER_SAIDA);
+  if (buffer == NULL) {
+    exit(1);
+  }
+
+  size_t n = 0;
+  int resultado = 0;
+
+  for (;;) {
+    int simbolo = decodificaAdaptativo(m, l);
+    if (simbolo < 0) {
+      resultado = -1;
+      break;
+    }
+    if (simbolo == SIMBOLO_EOF) {
+      break;
+    }
+
+    buffer[n++] = (unsigned char)simbolo;
+    if (n == TAMANHO_BUFFER_SAIDA) {
+      fwrite(buffer, 1, n, saida);
+      n = 0;
+      // um fluxo sem EOF acabaria decodificando os zeros de preenchimento
+      if (leitorEstourou(l)) {
+        resultado = -1;
+        break;
+      }
+    }
+  }
+
+  if (leitorEstourou(l)) {
+    resultado = -1;
+  }
+  fwrite(buffer, 1, n, saida);
+  free(buffer);
+
+  return resultado;
+}
+
+void liberaModeloAdaptativo(ModeloAdaptativo *m) { free(m); }
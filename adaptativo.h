@@ -0,0 +1,87 @@
+/*
+ *
+ * Tad ModeloAdaptativo
+ * Huffman adaptativo (algoritmo FGK): a árvore começa vazia e é atualizada a
+ * cada símbolo, igual no codificador e no decodificador, então a entrada é
+ * lida uma única vez e nenhuma tabela vai no cabeçalho
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef ADAPTATIVO_H
+#define ADAPTATIVO_H
+
+#include "escritor.h"
+#include "leitor.h"
+#include <stddef.h>
+#include <stdio.h>
+
+// versão com o Huffman adaptativo: assinatura, versão e os códigos, sem
+// cabeçalho, terminados pelo símbolo EOF
+#define VERSAO_ADAPTATIVA 5
+
+// bits do símbolo gravado depois do código do nó vazio, na sua primeira
+// ocorrência (os 256 bytes e o EOF)
+#define BITS_SIMBOLO_NOVO 9
+
+typedef struct modeloAdaptativo ModeloAdaptativo;
+
+/**
+ * @brief Cria um modelo com a árvore vazia (só o nó dos símbolos ainda não
+ * vistos).
+ * @return Ponteiro para o novo ModeloAdaptativo.
+ */
+ModeloAdaptativo *criaModeloAdaptativo(void);
+
+/**
+ * @brief Volta o modelo à árvore vazia, para codificar outro fluxo.
+ * @param m Ponteiro para o modelo.
+ */
+void reiniciaModeloAdaptativo(ModeloAdaptativo *m);
+
+/**
+ * @brief Escreve o código atual do símbolo e atualiza a árvore. Na primeira
+ * ocorrência, escreve o código do nó vazio seguido do símbolo em
+ * BITS_SIMBOLO_NOVO bits.
+ * @param m Ponteiro para o modelo.
+ * @param e Escritor que recebe os bits.
+ * @param simbolo Byte (0 a 255) ou SIMBOLO_EOF.
+ */
+void codificaAdaptativo(ModeloAdaptativo *m, EscritorBits *e, int simbolo);
+
+/**
+ * @brief Codifica uma sequência de bytes.
+ * @param m Ponteiro para o modelo.
+ * @param e Escritor que recebe os bits.
+ * @param dados Bytes a codificar.
+ * @param n Quantidade de bytes.
+ */
+void codificaBytesAdaptativo(ModeloAdaptativo *m, EscritorBits *e,
+                             const unsigned char *dados, size_t n);
+
+/**
+ * @brief Lê um símbolo e atualiza a árvore, como o codificador fez.
+ * @param m Ponteiro para o modelo.
+ * @param l Leitor de bits.
+ * @return O símbolo (0 a 255 ou SIMBOLO_EOF), ou -1 se o fluxo for inválido.
+ */
+int decodificaAdaptativo(ModeloAdaptativo *m, LeitorBits *l);
+
+/**
+ * @brief Decodifica símbolos até o EOF, gravando os bytes no arquivo.
+ * @param m Ponteiro para o modelo.
+ * @param l Leitor de bits.
+ * @param saida Arquivo de destino.
+ * @return 0 em caso de sucesso, -1 se o fluxo estiver corrompido ou
+ * terminar antes do EOF.
+ */
+int decodificaAdaptativoAteEOF(ModeloAdaptativo *m, LeitorBits *l,
+                               FILE *saida);
+
+/**
+ * @brief Libera o modelo.
+ * @param m Ponteiro para o modelo.
+ */
+void liberaModeloAdaptativo(ModeloAdaptativo *m);
+
+#endif // ADAPTATIVO_H
@@ -0,0 +1,150 @@
+/*
+ *
+ * Tad ArquivoMapeado
+ * Acesso a arquivos inteiros como uma região de memória (mmap), com leitura
+ * para um buffer quando o arquivo não puder ser mapeado, e escrita
+ * posicional (pwrite)
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "arquivo.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TAMANHO_AREA_LEITURA (1024 * 1024)
+
+struct arquivoMapeado {
+  int fd;
+  unsigned char *dados;
+  uint64_t tamanho;
+  int mapeado; // 1 se dados vem do mmap, 0 se foi lido para um buffer
+};
+
+// lê tudo o que o descritor tiver até o fim, para o que não pode ser mapeado
+static int leTudo(ArquivoMapeado *a) {
+  size_t capacidade = 0;
+  a->dados = NULL;
+  a->tamanho = 0;
+
+  for (;;) {
+    if (a->tamanho == capacidade) {
+      capacidade = capacidade == 0 ? TAMANHO_AREA_LEITURA : 2 * capacidade;
+      unsigned char *novo = realloc(a->dados, capacidade);
+      if (novo == NULL) {
+        exit(1);
+      }
+      a->dados = novo;
+    }
+
+    ssize_t lidos = read(a->fd, a->dados + a->tamanho,
+                         capacidade - (size_t)a->tamanho);
+    if (lidos < 0) {
+      return -1;
+    }
+    if (lidos == 0) {
+      return 0;
+    }
+    a->tamanho += (uint64_t)lidos;
+  }
+}
+
+int ehArquivoRegular(const char *caminho) {
+  struct stat info;
+  return stat(caminho, &info) == 0 && S_ISREG(info.st_mode);
+}
+
+ArquivoMapeado *abreArquivoMapeado(const char *caminho) {
+  ArquivoMapeado *a = calloc(1, sizeof(ArquivoMapeado));
+  if (a == NULL) {
+    exit(1);
+  }
+
+  a->fd = open(caminho, O_RDONLY);
+  if (a->fd < 0) {
+    free(a);
+    return NULL;
+  }
+
+  struct stat info;
+  if (fstat(a->fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+      (uint64_t)info.st_size <= SIZE_MAX) {
+    void *p = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, a->fd,
+                   0);
+    if (p != MAP_FAILED) {
+      // as passagens sobre a entrada são sequenciais: o kernel pode ler
+      // adiante com mais folga
+      madvise(p, (size_t)info.st_size, MADV_SEQUENTIAL);
+      a->dados = p;
+      a->tamanho = (uint64_t)info.st_size;
+      a->mapeado = 1;
+      return a;
+    }
+  }
+
+  // não dá para mapear (pipe, arquivo especial, arquivo vazio): lê tudo
+  if (leTudo(a) != 0) {
+    fechaArquivoMapeado(a);
+    return NULL;
+  }
+
+  return a;
+}
+
+const unsigned char *dadosArquivoMapeado(ArquivoMapeado *a) {
+  return a->dados;
+}
+
+uint64_t tamanhoArquivoMapeado(ArquivoMapeado *a) { return a->tamanho; }
+
+void descartaTrechoMapeado(ArquivoMapeado *a, uint64_t inicio,
+                           uint64_t tamanho) {
+  if (!a->mapeado || inicio >= a->tamanho) {
+    return;
+  }
+
+  // o madvise só aceita trechos alinhados ao tamanho da página: descarta só
+  // as páginas inteiramente contidas no trecho
+  uint64_t pagina = (uint64_t)sysconf(_SC_PAGESIZE);
+  uint64_t fim = inicio + tamanho < a->tamanho ? inicio + tamanho : a->tamanho;
+  uint64_t primeira = (inicio + pagina - 1) / pagina * pagina;
+  uint64_t ultima = fim == a->tamanho ? fim : fim / pagina * pagina;
+  if (ultima > primeira) {
+    madvise(a->dados + primeira, (size_t)(ultima - primeira), MADV_DONTNEED);
+  }
+}
+
+void fechaArquivoMapeado(ArquivoMapeado *a) {
+  if (a == NULL) {
+    return;
+  }
+
+  if (a->mapeado) {
+    munmap(a->dados, (size_t)a->tamanho);
+  } else {
+    free(a->dados);
+  }
+  close(a->fd);
+  free(a);
+}
+
+int escreveNaPosicao(int fd, const unsigned char *origem, size_t n,
+                     uint64_t posicao) {
+  while (n > 0) {
+    ssize_t escritos = pwrite(fd, origem, n, (off_t)posicao);
+    if (escritos <= 0) {
+      return -1;
+    }
+    origem += escritos;
+    posicao += (uint64_t)escritos;
+    n -= (size_t)escritos;
+  }
+  return 0;
+}
+
+int criaArquivoSaida(const char *caminho) {
+  return open(caminho, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
@@ -0,0 +1,89 @@
+/*
+ *
+ * Tad ArquivoMapeado
+ * Acesso a arquivos inteiros como uma região de memória (mmap), com leitura
+ * para um buffer quando o arquivo não puder ser mapeado, e escrita
+ * posicional (pwrite)
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef ARQUIVO_H
+#define ARQUIVO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct arquivoMapeado ArquivoMapeado;
+
+/**
+ * @brief Diz se o caminho é um arquivo regular, o único tipo que pode ser
+ * mapeado. Pipes e outros arquivos especiais devem ser lidos em pedaços, sem
+ * passar por abreArquivoMapeado.
+ * @param caminho Caminho do arquivo.
+ * @return 1 se for um arquivo regular, 0 caso contrário ou se não existir.
+ */
+int ehArquivoRegular(const char *caminho);
+
+/**
+ * @brief Abre um arquivo para leitura e disponibiliza todo o seu conteúdo na
+ * memória. Arquivos regulares são mapeados com mmap e marcados para leitura
+ * sequencial; os que não podem ser mapeados (vazios ou especiais) são lidos
+ * por inteiro para um buffer, sem limite de tamanho, então a compactação e a
+ * descompactação só usam esta função com arquivos regulares.
+ * @param caminho Caminho do arquivo.
+ * @return Ponteiro para o novo ArquivoMapeado, ou NULL se não puder ser
+ * aberto.
+ */
+ArquivoMapeado *abreArquivoMapeado(const char *caminho);
+
+/**
+ * @brief Retorna o início do conteúdo do arquivo.
+ * @param a Ponteiro para o ArquivoMapeado.
+ * @return Ponteiro para o primeiro byte (NULL se o arquivo for vazio).
+ */
+const unsigned char *dadosArquivoMapeado(ArquivoMapeado *a);
+
+/**
+ * @brief Retorna o tamanho do arquivo em bytes.
+ * @param a Ponteiro para o ArquivoMapeado.
+ */
+uint64_t tamanhoArquivoMapeado(ArquivoMapeado *a);
+
+/**
+ * @brief Avisa que um trecho já foi usado e não será lido de novo, para que
+ * as suas páginas possam sair da memória do processo. Não faz nada quando o
+ * arquivo foi lido para um buffer.
+ * @param a Ponteiro para o ArquivoMapeado.
+ * @param inicio Posição do início do trecho.
+ * @param tamanho Tamanho do trecho em bytes.
+ */
+void descartaTrechoMapeado(ArquivoMapeado *a, uint64_t inicio,
+                           uint64_t tamanho);
+
+/**
+ * @brief Desfaz o mapeamento (ou libera o buffer) e fecha o arquivo.
+ * @param a Ponteiro para o ArquivoMapeado.
+ */
+void fechaArquivoMapeado(ArquivoMapeado *a);
+
+/**
+ * @brief Grava n bytes a partir de uma posição do arquivo, sem depender da
+ * posição corrente do descritor (pode ser usada por várias threads).
+ * @param fd Descritor do arquivo.
+ * @param origem Bytes a gravar.
+ * @param n Quantidade de bytes.
+ * @param posicao Posição do primeiro byte no arquivo.
+ * @return 0 em caso de sucesso, -1 se a escrita falhar.
+ */
+int escreveNaPosicao(int fd, const unsigned char *origem, size_t n,
+                     uint64_t posicao);
+
+/**
+ * @brief Cria (ou trunca) um arquivo de saída para escrita posicional.
+ * @param caminho Caminho do arquivo.
+ * @return O descritor do arquivo, ou -1 em caso de erro.
+ */
+int criaArquivoSaida(const char *caminho);
+
+#endif // ARQUIVO_H
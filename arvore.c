@@ -8,17 +8,24 @@
 
 #include "arvore.h"
 #include <stdlib.h>
+#include <string.h>
 
 struct arvore {
-  int frequencia;
+  uint64_t frequencia;
   int caractere; // Consegue armazenar mais que 256 caracteres
   Arvore *esquerda;
   Arvore *direita;
 };
 
+struct arenaArvore {
+  Arvore *nos;
+  int usados;
+  int capacidade;
+};
+
 int arvoreVazia(Arvore *a) { return a == NULL; }
 
-Arvore *criaNoFolha(int caractere, int frequencia) {
+Arvore *criaNoFolha(int caractere, uint64_t frequencia) {
   Arvore *a = (Arvore *)calloc(1, sizeof(Arvore));
 
   a->frequencia = frequencia;
@@ -37,13 +44,77 @@ Arvore *criaNoInterno(Arvore *esquerda, Arvore *direita) {
   return interno;
 };
 
-int getFrequencia(Arvore *a) { return a->frequencia; };
+ArenaArvore *criaArenaArvore(int capacidade) {
+  ArenaArvore *arena = malloc(sizeof(ArenaArvore));
+  if (arena == NULL) {
+    exit(1);
+  }
+
+  arena->nos = malloc(capacidade * sizeof(Arvore));
+  if (arena->nos == NULL) {
+    exit(1);
+  }
+  arena->usados = 0;
+  arena->capacidade = capacidade;
+
+  return arena;
+}
+
+// próximo nó livre da arena, já zerado
+static Arvore *alocaNaArena(ArenaArvore *arena) {
+  if (arena->usados >= arena->capacidade) {
+    exit(1);
+  }
+
+  Arvore *a = &arena->nos[arena->usados++];
+  a->frequencia = 0;
+  a->caractere = 0;
+  a->esquerda = NULL;
+  a->direita = NULL;
+
+  return a;
+}
+
+Arvore *criaNoFolhaNaArena(ArenaArvore *arena, int caractere,
+                           uint64_t frequencia) {
+  Arvore *a = alocaNaArena(arena);
+
+  a->frequencia = frequencia;
+  a->caractere = caractere;
+
+  return a;
+}
+
+Arvore *criaNoInternoNaArena(ArenaArvore *arena, Arvore *esquerda,
+                             Arvore *direita) {
+  Arvore *interno = alocaNaArena(arena);
+
+  interno->frequencia = esquerda->frequencia + direita->frequencia;
+  interno->esquerda = esquerda;
+  interno->direita = direita;
+
+  return interno;
+}
+
+void liberaArenaArvore(ArenaArvore *arena) {
+  if (arena != NULL) {
+    free(arena->nos);
+    free(arena);
+  }
+}
+
+void reiniciaArenaArvore(ArenaArvore *arena) { arena->usados = 0; }
+
+uint64_t getFrequencia(Arvore *a) { return a->frequencia; };
 
 int comparaFrequencia(void *arv1, void *arv2) {
   Arvore *arvore1 = arv1;
   Arvore *arvore2 = arv2;
 
-  return getFrequencia(arvore1) - getFrequencia(arvore2);
+  // as frequências são de 64 bits: a diferença não cabe em um int
+  uint64_t f1 = getFrequencia(arvore1);
+  uint64_t f2 = getFrequencia(arvore2);
+  return (f1 > f2) - (f1 < f2);
 };
 
 int getCaractere(Arvore *a) { return a->caractere; };
@@ -66,4 +137,41 @@ Arvore *liberaArvore(Arvore *a) {
     free(a);
   }
   return NULL;
-};
\ No newline at end of file
+};
+
+void ordenaEmLargura(ArvoreCompacta *a) {
+  if (ehFolhaCompacta(a->raiz)) {
+    return;
+  }
+
+  // percorre em largura: a posição de cada nó na fila é o seu novo índice
+  uint16_t fila[MAX_NOS_COMPACTOS];
+  uint16_t novoIndice[MAX_NOS_COMPACTOS];
+  int inicio = 0;
+  int fim = 0;
+
+  fila[fim++] = a->raiz;
+  while (inicio < fim) {
+    uint16_t no = fila[inicio];
+    novoIndice[no] = (uint16_t)inicio;
+    inicio++;
+    for (unsigned int bit = 0; bit < 2; bit++) {
+      uint16_t filho = filhoCompacto(a, no, bit);
+      if (!ehFolhaCompacta(filho)) {
+        fila[fim++] = filho;
+      }
+    }
+  }
+
+  NoCompacto novos[MAX_NOS_COMPACTOS];
+  for (int i = 0; i < fim; i++) {
+    for (unsigned int bit = 0; bit < 2; bit++) {
+      uint16_t filho = filhoCompacto(a, fila[i], bit);
+      novos[i].filhos[bit] = ehFolhaCompacta(filho) ? filho : novoIndice[filho];
+    }
+  }
+
+  memcpy(a->nos, novos, fim * sizeof(NoCompacto));
+  a->numNos = (uint16_t)fim;
+  a->raiz = 0;
+}
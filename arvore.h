@@ -10,7 +10,77 @@
 #ifndef ARVORE_H_
 #define ARVORE_H_
 
+#include <stdint.h>
+
 typedef struct arvore Arvore;
+typedef struct arenaArvore ArenaArvore;
+
+// uma referência com este bit ligado é uma folha, e os bits restantes são o
+// seu símbolo; sem ele, é o índice de um nó interno
+#define FOLHA_COMPACTA 0x8000u
+
+// com no máximo 257 folhas, a árvore tem no máximo 256 nós internos
+#define MAX_NOS_COMPACTOS 256
+
+/**
+ * @brief Nó interno da árvore compacta: só as referências dos dois filhos,
+ * em 16 bits cada.
+ */
+typedef struct {
+  uint16_t filhos[2]; // esquerdo (bit 0) e direito (bit 1)
+} NoCompacto;
+
+/**
+ * @brief Árvore usada pelo decodificador: os nós internos ficam num vetor, em
+ * ordem de largura (a raiz é o nó 0), e as folhas não ocupam nós, ficam
+ * marcadas na própria referência. Com 257 símbolos são no máximo 1 KiB.
+ *
+ * Diferente do Arvore, a estrutura é exposta para que os acessos possam ser
+ * expandidos inline.
+ */
+typedef struct arvoreCompacta {
+  uint16_t raiz;   // referência à raiz (uma folha se só há um símbolo)
+  uint16_t numNos; // nós internos usados
+  NoCompacto nos[MAX_NOS_COMPACTOS];
+} ArvoreCompacta;
+
+/**
+ * @brief Verifica se uma referência da árvore compacta é uma folha
+ * @param ref Referência a um nó
+ * @return 1 se for folha, 0 se for nó interno
+ */
+static inline int ehFolhaCompacta(uint16_t ref) {
+  return (ref & FOLHA_COMPACTA) != 0;
+}
+
+/**
+ * @brief Obtém o símbolo de uma folha da árvore compacta
+ * @param ref Referência a uma folha
+ * @return O símbolo da folha
+ */
+static inline int simboloCompacto(uint16_t ref) {
+  return ref & ~FOLHA_COMPACTA;
+}
+
+/**
+ * @brief Obtém um dos filhos de um nó interno da árvore compacta
+ * @param a Ponteiro para a árvore
+ * @param ref Referência a um nó interno
+ * @param bit 0 para o filho esquerdo, 1 para o direito
+ * @return A referência do filho
+ */
+static inline uint16_t filhoCompacto(const ArvoreCompacta *a, uint16_t ref,
+                                     unsigned int bit) {
+  return a->nos[ref].filhos[bit];
+}
+
+/**
+ * @brief Reorganiza os nós internos da árvore compacta em ordem de largura,
+ * com a raiz no índice 0, para que os primeiros níveis, os mais acessados,
+ * fiquem nas mesmas linhas de cache
+ * @param a Ponteiro para a árvore
+ */
+void ordenaEmLargura(ArvoreCompacta *a);
 
 /**
  * @brief Cria um nó folha da árvore
@@ -18,7 +88,7 @@ typedef struct arvore Arvore;
  * @param frequencia A frequência de ocorrência do caractere
  * @return Ponteiro para o novo nó folha criado
  */
-Arvore *criaNoFolha(int caractere, int frequencia);
+Arvore *criaNoFolha(int caractere, uint64_t frequencia);
 
 /**
  * @brief Cria um nó interno da árvore
@@ -28,12 +98,54 @@ Arvore *criaNoFolha(int caractere, int frequencia);
  */
 Arvore *criaNoInterno(Arvore *esquerda, Arvore *direita);
 
+/**
+ * @brief Cria uma arena com espaço para 'capacidade' nós contíguos. Os nós
+ * criados nela são liberados todos de uma vez, por liberaArenaArvore.
+ * @param capacidade Quantidade máxima de nós
+ * @return Ponteiro para a nova arena
+ */
+ArenaArvore *criaArenaArvore(int capacidade);
+
+/**
+ * @brief Cria um nó folha dentro da arena
+ * @param arena Arena que guarda o nó
+ * @param caractere O caractere a ser armazenado no nó folha
+ * @param frequencia A frequência de ocorrência do caractere
+ * @return Ponteiro para o novo nó folha criado
+ */
+Arvore *criaNoFolhaNaArena(ArenaArvore *arena, int caractere,
+                           uint64_t frequencia);
+
+/**
+ * @brief Cria um nó interno dentro da arena
+ * @param arena Arena que guarda o nó
+ * @param esquerda Ponteiro para a subárvore esquerda
+ * @param direita Ponteiro para a subárvore direita
+ * @return Ponteiro para o novo nó interno criado
+ */
+Arvore *criaNoInternoNaArena(ArenaArvore *arena, Arvore *esquerda,
+                             Arvore *direita);
+
+/**
+ * @brief Libera a arena e, de uma vez, todos os nós criados nela (que não
+ * devem ser passados para liberaArvore)
+ * @param arena Ponteiro para a arena
+ */
+void liberaArenaArvore(ArenaArvore *arena);
+
+/**
+ * @brief Descarta todos os nós da arena, que pode então ser usada para
+ * construir outra árvore sem uma nova alocação.
+ * @param arena Arena a ser reiniciada
+ */
+void reiniciaArenaArvore(ArenaArvore *arena);
+
 /**
  * @brief Obtém a frequência de um nó da árvore
  * @param a Ponteiro para o nó da árvore
  * @return A frequência armazenada no nó
  */
-int getFrequencia(Arvore *a);
+uint64_t getFrequencia(Arvore *a);
 
 /**
  * @brief Compara a frequência de dois nós da árvore
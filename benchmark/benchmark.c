@@ -0,0 +1,412 @@
+/*
+ *
+ * Medição de ponta a ponta
+ * Gera (ou reaproveita) o corpus, compacta e descompacta cada arquivo
+ * repetidas vezes pelas mesmas funções públicas usadas pelo programa e
+ * imprime uma linha JSON por caso com a vazão, a razão de compactação, o
+ * pico de memória e a conferência da ida e volta
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ * Compilação, a partir da raiz do repositório:
+ *   gcc -O2 -pthread -I. -o bench benchmark/benchmark.c benchmark/corpus.c \
+ *       $(ls *.c | grep -v main.c)
+ *
+ */
+
+#include "bwt.h"
+#include "compactador.h"
+#include "corpus.h"
+#include "descompactador.h"
+#include "lz77.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_REPETICOES 100
+#define SEMENTE_PADRAO 0x48554646ULL
+#define TAMANHO_PADRAO (16ULL * 1024 * 1024)
+#define TAMANHO_COMPARACAO (1024 * 1024)
+#define MAX_CAMINHO 4096
+
+typedef struct {
+  int limiteBits;
+  size_t tamanhoBloco;
+  int numThreads;
+  int numFluxos;
+  int adaptativo;
+  int contexto;
+  int nivelLZ;
+  size_t tamanhoBlocoBWT;
+} Opcoes;
+
+// resultado de uma execução medida em um processo filho
+typedef struct {
+  double segundos;
+  long picoRssKb;
+} Medida;
+
+static double agora(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+static int compacta(const char *caminho, const Opcoes *op) {
+  Compactador *c = criaCompactador(caminho);
+  defineLimiteBits(c, op->limiteBits);
+  if (op->tamanhoBloco > 0) {
+    defineTamanhoBloco(c, op->tamanhoBloco);
+  }
+  defineNumThreads(c, op->numThreads);
+  defineNumFluxos(c, op->numFluxos);
+  defineAdaptativo(c, op->adaptativo);
+  defineContexto(c, op->contexto);
+  defineNivelLZ(c, op->nivelLZ);
+  defineTamanhoBlocoBWT(c, op->tamanhoBlocoBWT);
+  int resultado = executaCompactacao(c);
+  liberaCompactador(c);
+  return resultado;
+}
+
+static int descompacta(const char *caminho, const Opcoes *op) {
+  Descompactador *d = criaDescompactador(caminho);
+  defineThreadsDescompactacao(d, op->numThreads);
+  int resultado = executaDescompactacao(d);
+  liberaDescompactador(d);
+  return resultado;
+}
+
+// Roda a operação em um processo filho, para que o pico de memória de cada
+// execução seja medido isoladamente (ru_maxrss só cresce dentro de um
+// processo) e para que um exit(1) do compactador não derrube a medição.
+// Retorna 0 se a operação deu certo no filho.
+static int medeEmFilho(int (*operacao)(const char *, const Opcoes *),
+                       const char *caminho, const Opcoes *op, Medida *m) {
+  int canal[2];
+  if (pipe(canal) != 0) {
+    return -1;
+  }
+
+  pid_t filho = fork();
+  if (filho < 0) {
+    close(canal[0]);
+    close(canal[1]);
+    return -1;
+  }
+
+  if (filho == 0) {
+    close(canal[0]);
+    double inicio = agora();
+    if (operacao(caminho, op) != 0) {
+      _exit(1);
+    }
+    double segundos = agora() - inicio;
+    ssize_t escritos = write(canal[1], &segundos, sizeof(segundos));
+    _exit(escritos == (ssize_t)sizeof(segundos) ? 0 : 1);
+  }
+
+  close(canal[1]);
+  double segundos = 0;
+  ssize_t lidos = read(canal[0], &segundos, sizeof(segundos));
+  close(canal[0]);
+
+  int status;
+  struct rusage uso;
+  if (wait4(filho, &status, 0, &uso) < 0 || !WIFEXITED(status) ||
+      WEXITSTATUS(status) != 0 || lidos != (ssize_t)sizeof(segundos)) {
+    return -1;
+  }
+
+  m->segundos = segundos;
+  m->picoRssKb = uso.ru_maxrss;
+  return 0;
+}
+
+static uint64_t tamanhoArquivo(const char *caminho) {
+  struct stat info;
+  return stat(caminho, &info) == 0 ? (uint64_t)info.st_size : 0;
+}
+
+// compara os dois arquivos byte a byte
+static int arquivosIguais(const char *a, const char *b) {
+  FILE *fa = fopen(a, "rb");
+  FILE *fb = fopen(b, "rb");
+  unsigned char *ba = malloc(TAMANHO_COMPARACAO);
+  unsigned char *bb = malloc(TAMANHO_COMPARACAO);
+  int iguais = fa != NULL && fb != NULL && ba != NULL && bb != NULL;
+
+  while (iguais) {
+    size_t na = fread(ba, 1, TAMANHO_COMPARACAO, fa);
+    size_t nb = fread(bb, 1, TAMANHO_COMPARACAO, fb);
+    if (na != nb || memcmp(ba, bb, na) != 0) {
+      iguais = 0;
+    }
+    if (na < TAMANHO_COMPARACAO) {
+      break;
+    }
+  }
+
+  free(ba);
+  free(bb);
+  if (fa != NULL) {
+    fclose(fa);
+  }
+  if (fb != NULL) {
+    fclose(fb);
+  }
+  return iguais;
+}
+
+// menor tempo entre as repetições: é o que menos sofre com ruído da máquina
+static double menorTempo(const Medida *m, int n) {
+  double menor = m[0].segundos;
+  for (int i = 1; i < n; i++) {
+    if (m[i].segundos < menor) {
+      menor = m[i].segundos;
+    }
+  }
+  return menor;
+}
+
+static long maiorPico(const Medida *m, int n) {
+  long maior = 0;
+  for (int i = 0; i < n; i++) {
+    if (m[i].picoRssKb > maior) {
+      maior = m[i].picoRssKb;
+    }
+  }
+  return maior;
+}
+
+static double megabytesPorSegundo(uint64_t bytes, double segundos) {
+  return segundos > 0 ? (double)bytes / (1024.0 * 1024.0) / segundos : 0;
+}
+
+static void imprimeFalha(const char *caso, const char *motivo) {
+  printf("{\"caso\":\"%s\",\"erro\":\"%s\"}\n", caso, motivo);
+  fflush(stdout);
+}
+
+// Compacta 'original' para 'original.comp', move o compactado para
+// 'trabalho/' e descompacta lá, para não sobrescrever o corpus. Retorna 0 se
+// a ida e volta foi correta.
+static int medeCaso(const char *diretorio, const char *caso, int repeticoes,
+                    const Opcoes *op) {
+  char original[MAX_CAMINHO], compactado[MAX_CAMINHO + 8];
+  char copia[MAX_CAMINHO + 32], restaurado[MAX_CAMINHO + 32];
+  snprintf(original, sizeof(original), "%s/%s", diretorio, caso);
+  snprintf(compactado, sizeof(compactado), "%s.comp", original);
+  snprintf(copia, sizeof(copia), "%s/trabalho/%s.comp", diretorio, caso);
+  snprintf(restaurado, sizeof(restaurado), "%s/trabalho/%s", diretorio, caso);
+
+  Medida medidasC[MAX_REPETICOES], medidasD[MAX_REPETICOES];
+
+  for (int i = 0; i < repeticoes; i++) {
+    if (medeEmFilho(compacta, original, op, &medidasC[i]) != 0) {
+      imprimeFalha(caso, "compactacao");
+      return -1;
+    }
+  }
+  if (rename(compactado, copia) != 0) {
+    imprimeFalha(caso, "rename");
+    return -1;
+  }
+  for (int i = 0; i < repeticoes; i++) {
+    if (medeEmFilho(descompacta, copia, op, &medidasD[i]) != 0) {
+      imprimeFalha(caso, "descompactacao");
+      return -1;
+    }
+  }
+
+  uint64_t tamOriginal = tamanhoArquivo(original);
+  uint64_t tamCompactado = tamanhoArquivo(copia);
+  int correto = arquivosIguais(original, restaurado);
+  double tc = menorTempo(medidasC, repeticoes);
+  double td = menorTempo(medidasD, repeticoes);
+
+  printf("{\"caso\":\"%s\",\"tamanho\":%llu,\"tamanho_compactado\":%llu,"
+         "\"razao\":%.4f,\"repeticoes\":%d,"
+         "\"compactacao_s\":%.6f,\"compactacao_mb_s\":%.2f,"
+         "\"descompactacao_s\":%.6f,\"descompactacao_mb_s\":%.2f,"
+         "\"pico_rss_compactacao_kb\":%ld,\"pico_rss_descompactacao_kb\":%ld,"
+         "\"ida_e_volta\":%s}\n",
+         caso, (unsigned long long)tamOriginal,
+         (unsigned long long)tamCompactado,
+         tamOriginal > 0 ? (double)tamCompactado / (double)tamOriginal : 0,
+         repeticoes, tc, megabytesPorSegundo(tamOriginal, tc), td,
+         megabytesPorSegundo(tamOriginal, td), maiorPico(medidasC, repeticoes),
+         maiorPico(medidasD, repeticoes), correto ? "true" : "false");
+  fflush(stdout);
+
+  remove(copia);
+  remove(restaurado);
+  return correto ? 0 : -1;
+}
+
+// aceita sufixos K, M e G (potências de 1024)
+static uint64_t leTamanho(const char *texto) {
+  char *fim;
+  unsigned long long valor = strtoull(texto, &fim, 10);
+  switch (*fim) {
+  case 'k':
+  case 'K':
+    valor <<= 10;
+    break;
+  case 'm':
+  case 'M':
+    valor <<= 20;
+    break;
+  case 'g':
+  case 'G':
+    valor <<= 30;
+    break;
+  }
+  return valor;
+}
+
+static void imprimeUso(const char *programa) {
+  fprintf(stderr,
+          "Uso: %s [-d diretorio] [-t tamanho] [-g tamanhoGrande] "
+          "[-r repeticoes] [-s semente] [-C caso] [-l bits] [-b bloco] "
+          "[-T threads] [-f fluxos] [-a] [-o] [-z nivel] [-w bloco]\n"
+          "  -t  tamanho de cada caso (padrao 16M)\n"
+          "  -g  inclui o caso 'grande' (texto sintetico), ex.: -g 5G para\n"
+          "      conferir a ida e volta de um arquivo maior que 4 GiB\n"
+          "  -C  mede so o caso indicado (pode repetir)\n"
+          "  -a  Huffman adaptativo, em uma unica passada\n"
+          "  -o  modelo de contexto de ordem 1 (tabela pelo byte anterior)\n"
+          "  -z  etapa LZ77 antes do Huffman, com o esforco de 1 a 9\n"
+          "  -w  etapa BWT antes do Huffman, em blocos desse tamanho\n"
+          "      (ex.: -w 900K, ate 8M)\n",
+          programa);
+}
+
+int main(int argc, char *argv[]) {
+  const char *diretorio = "corpus_bench";
+  uint64_t tamanho = TAMANHO_PADRAO;
+  uint64_t tamanhoGrande = 0;
+  uint64_t semente = SEMENTE_PADRAO;
+  int repeticoes = 3;
+  Opcoes op = {0, 0, 1, 1, 0, 0, 0, 0};
+  const char *casos[NUM_TIPOS_CORPUS + 1];
+  int numCasos = 0;
+
+  int opcao;
+  while ((opcao = getopt(argc, argv, "d:t:g:r:s:C:l:b:T:f:aoz:w:h")) != -1) {
+    switch (opcao) {
+    case 'd':
+      diretorio = optarg;
+      break;
+    case 't':
+      tamanho = leTamanho(optarg);
+      break;
+    case 'g':
+      tamanhoGrande = leTamanho(optarg);
+      break;
+    case 'r':
+      repeticoes = atoi(optarg);
+      break;
+    case 's':
+      semente = strtoull(optarg, NULL, 0);
+      break;
+    case 'C':
+      if (numCasos > NUM_TIPOS_CORPUS ||
+          (tipoCorpusDoNome(optarg) < 0 && strcmp(optarg, "grande") != 0)) {
+        imprimeUso(argv[0]);
+        return 1;
+      }
+      casos[numCasos++] = optarg;
+      break;
+    case 'l':
+      op.limiteBits = atoi(optarg);
+      break;
+    case 'b':
+      op.tamanhoBloco = (size_t)leTamanho(optarg);
+      break;
+    case 'T':
+      op.numThreads = atoi(optarg);
+      break;
+    case 'f':
+      op.numFluxos = atoi(optarg);
+      break;
+    case 'a':
+      op.adaptativo = 1;
+      break;
+    case 'o':
+      op.contexto = 1;
+      break;
+    case 'z':
+      op.nivelLZ = atoi(optarg);
+      if (op.nivelLZ < NIVEL_LZ_MINIMO || op.nivelLZ > NIVEL_LZ_MAXIMO) {
+        imprimeUso(argv[0]);
+        return 1;
+      }
+      break;
+    case 'w':
+      op.tamanhoBlocoBWT = (size_t)leTamanho(optarg);
+      if (op.tamanhoBlocoBWT < TAMANHO_BLOCO_BWT_MINIMO ||
+          op.tamanhoBlocoBWT > TAMANHO_BLOCO_BWT_MAXIMO) {
+        imprimeUso(argv[0]);
+        return 1;
+      }
+      break;
+    default:
+      imprimeUso(argv[0]);
+      return 1;
+    }
+  }
+  if (optind != argc || repeticoes < 1 || repeticoes > MAX_REPETICOES) {
+    imprimeUso(argv[0]);
+    return 1;
+  }
+
+  if (numCasos == 0) {
+    for (int i = 0; i < NUM_TIPOS_CORPUS; i++) {
+      casos[numCasos++] = nomeCorpus(i);
+    }
+    if (tamanhoGrande > 0) {
+      casos[numCasos++] = "grande";
+    }
+  }
+
+  char caminho[MAX_CAMINHO];
+  snprintf(caminho, sizeof(caminho), "%s/trabalho", diretorio);
+  if ((mkdir(diretorio, 0755) != 0 && errno != EEXIST) ||
+      (mkdir(caminho, 0755) != 0 && errno != EEXIST)) {
+    fprintf(stderr, "Erro ao criar o diretorio %s\n", caminho);
+    return 1;
+  }
+
+  int falhas = 0;
+  for (int i = 0; i < numCasos; i++) {
+    // o caso grande é texto sintético: exercita os caminhos de mais de 4 GiB
+    // sem precisar de um arquivo real desse tamanho
+    int grande = strcmp(casos[i], "grande") == 0;
+    TipoCorpus tipo = grande ? CORPUS_TEXTO : tipoCorpusDoNome(casos[i]);
+    uint64_t bytes = grande ? (tamanhoGrande ? tamanhoGrande : tamanho)
+                            : tamanho;
+
+    snprintf(caminho, sizeof(caminho), "%s/%s", diretorio, casos[i]);
+    fprintf(stderr, "gerando %s (%llu bytes)\n", caminho,
+            (unsigned long long)bytes);
+    if (geraCorpus(caminho, tipo, bytes, semente + (uint64_t)tipo) != 0) {
+      imprimeFalha(casos[i], "corpus");
+      falhas++;
+      continue;
+    }
+
+    fprintf(stderr, "medindo %s\n", casos[i]);
+    if (medeCaso(diretorio, casos[i], repeticoes, &op) != 0) {
+      falhas++;
+    }
+  }
+
+  return falhas ? 1 : 0;
+}
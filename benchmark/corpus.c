@@ -0,0 +1,189 @@
+/*
+ *
+ * Gerador do corpus de medição
+ * Arquivos sintéticos reprodutíveis (a mesma semente sempre gera os mesmos
+ * bytes) que cobrem os casos típicos e os extremos do compactador
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "corpus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define TAMANHO_PEDACO (1024 * 1024)
+#define TAMANHO_VOCABULARIO 4096
+#define MAX_PALAVRA 12
+
+static const char *nomes[NUM_TIPOS_CORPUS] = {
+    "texto", "binario", "aleatorio", "byte_unico", "enviesado"};
+
+// xorshift64*: rápido e com o mesmo resultado em qualquer plataforma
+typedef struct {
+  uint64_t estado;
+} Gerador;
+
+static uint64_t proximo(Gerador *g) {
+  g->estado ^= g->estado >> 12;
+  g->estado ^= g->estado << 25;
+  g->estado ^= g->estado >> 27;
+  return g->estado * 0x2545F4914F6CDD1DULL;
+}
+
+// estado de cada tipo entre um pedaço e o seguinte
+typedef struct {
+  Gerador g;
+  char vocabulario[TAMANHO_VOCABULARIO][MAX_PALAVRA + 1];
+  uint32_t registro;     // contador dos registros binários
+  unsigned char pendente[64]; // bytes gerados que não couberam no pedaço
+  size_t numPendentes;
+  int palavrasNaLinha;
+} EstadoCorpus;
+
+static void montaVocabulario(EstadoCorpus *e) {
+  for (int i = 0; i < TAMANHO_VOCABULARIO; i++) {
+    // palavras mais usadas são mais curtas, como em um texto de verdade
+    int tamanho = 1 + (int)(proximo(&e->g) % 4) + i * (MAX_PALAVRA - 4) /
+                                                      TAMANHO_VOCABULARIO;
+    for (int j = 0; j < tamanho; j++) {
+      e->vocabulario[i][j] = (char)('a' + proximo(&e->g) % 26);
+    }
+    e->vocabulario[i][tamanho] = '\0';
+  }
+}
+
+// gera a próxima unidade do tipo (uma palavra, um registro...) em 'destino'
+// e retorna quantos bytes ela tem
+static size_t geraUnidade(EstadoCorpus *e, TipoCorpus tipo,
+                          unsigned char *destino) {
+  uint64_t r = proximo(&e->g);
+
+  switch (tipo) {
+  case CORPUS_TEXTO: {
+    // escolhe palavras de posição baixa com muito mais frequência
+    uint64_t a = r % TAMANHO_VOCABULARIO;
+    uint64_t b = (r >> 20) % TAMANHO_VOCABULARIO;
+    const char *palavra = e->vocabulario[a * b / TAMANHO_VOCABULARIO];
+    size_t n = strlen(palavra);
+    memcpy(destino, palavra, n);
+    if (++e->palavrasNaLinha >= 12 + (int)((r >> 40) % 6)) {
+      destino[n++] = '.';
+      destino[n++] = '\n';
+      e->palavrasNaLinha = 0;
+    } else {
+      destino[n++] = ((r >> 50) % 16) == 0 ? ',' : ' ';
+    }
+    return n;
+  }
+  case CORPUS_BINARIO: {
+    // registro de 16 bytes: contador, valor pequeno, identificador de
+    // poucos valores e preenchimento zerado
+    uint32_t valor = (uint32_t)(r % 1000);
+    uint32_t id = (uint32_t)((r >> 32) % 8) * 0x01010101u;
+    uint32_t campos[4] = {e->registro++, valor, id, 0};
+    for (int i = 0; i < 4; i++) {
+      destino[4 * i] = (unsigned char)(campos[i] & 0xFF);
+      destino[4 * i + 1] = (unsigned char)((campos[i] >> 8) & 0xFF);
+      destino[4 * i + 2] = (unsigned char)((campos[i] >> 16) & 0xFF);
+      destino[4 * i + 3] = (unsigned char)(campos[i] >> 24);
+    }
+    return 16;
+  }
+  case CORPUS_ALEATORIO:
+    memcpy(destino, &r, sizeof(r));
+    return sizeof(r);
+  case CORPUS_BYTE_UNICO:
+    memset(destino, 'a', 8);
+    return 8;
+  case CORPUS_ENVIESADO: {
+    // o byte k aparece com probabilidade 2^-(k+1)
+    for (int i = 0; i < 8; i++) {
+      uint64_t s = proximo(&e->g);
+      destino[i] = (unsigned char)(s == 0 ? 64 : __builtin_ctzll(s));
+    }
+    return 8;
+  }
+  default:
+    return 0;
+  }
+}
+
+static void preenchePedaco(EstadoCorpus *e, TipoCorpus tipo,
+                           unsigned char *pedaco, size_t n) {
+  size_t usados = 0;
+
+  // primeiro o que sobrou do pedaço anterior
+  size_t deSobra = e->numPendentes < n ? e->numPendentes : n;
+  memcpy(pedaco, e->pendente, deSobra);
+  memmove(e->pendente, e->pendente + deSobra, e->numPendentes - deSobra);
+  e->numPendentes -= deSobra;
+  usados += deSobra;
+
+  unsigned char unidade[64];
+  while (usados < n) {
+    size_t k = geraUnidade(e, tipo, unidade);
+    size_t cabe = n - usados < k ? n - usados : k;
+    memcpy(pedaco + usados, unidade, cabe);
+    usados += cabe;
+    memcpy(e->pendente + e->numPendentes, unidade + cabe, k - cabe);
+    e->numPendentes += k - cabe;
+  }
+}
+
+const char *nomeCorpus(TipoCorpus tipo) {
+  return tipo < NUM_TIPOS_CORPUS ? nomes[tipo] : "?";
+}
+
+int tipoCorpusDoNome(const char *nome) {
+  for (int i = 0; i < NUM_TIPOS_CORPUS; i++) {
+    if (strcmp(nomes[i], nome) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int geraCorpus(const char *caminho, TipoCorpus tipo, uint64_t tamanho,
+               uint64_t semente) {
+  // o conteúdo só depende do tipo, do tamanho e da semente, então um arquivo
+  // com o tamanho certo já é o corpus pedido
+  struct stat info;
+  if (stat(caminho, &info) == 0 && (uint64_t)info.st_size == tamanho) {
+    return 0;
+  }
+
+  FILE *arq = fopen(caminho, "wb");
+  if (arq == NULL) {
+    return -1;
+  }
+
+  EstadoCorpus *e = calloc(1, sizeof(EstadoCorpus));
+  unsigned char *pedaco = malloc(TAMANHO_PEDACO);
+  if (e == NULL || pedaco == NULL) {
+    exit(1);
+  }
+  e->g.estado = semente ? semente : 1;
+  montaVocabulario(e);
+
+  int resultado = 0;
+  for (uint64_t gerados = 0; gerados < tamanho;) {
+    size_t n = tamanho - gerados < TAMANHO_PEDACO ? (size_t)(tamanho - gerados)
+                                                   : TAMANHO_PEDACO;
+    preenchePedaco(e, tipo, pedaco, n);
+    if (fwrite(pedaco, 1, n, arq) != n) {
+      resultado = -1;
+      break;
+    }
+    gerados += n;
+  }
+
+  free(pedaco);
+  free(e);
+  if (fclose(arq) != 0) {
+    resultado = -1;
+  }
+
+  return resultado;
+}
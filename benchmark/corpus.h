@@ -0,0 +1,53 @@
+/*
+ *
+ * Gerador do corpus de medição
+ * Arquivos sintéticos reprodutíveis (a mesma semente sempre gera os mesmos
+ * bytes) que cobrem os casos típicos e os extremos do compactador
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stdint.h>
+
+typedef enum {
+  CORPUS_TEXTO,      // palavras de um vocabulário fixo, com frequências
+                     // desiguais, pontuação e quebras de linha
+  CORPUS_BINARIO,    // registros binários de tamanho fixo, com contadores,
+                     // campos pequenos e preenchimento
+  CORPUS_ALEATORIO,  // bytes uniformes, incompressíveis
+  CORPUS_BYTE_UNICO, // um único byte repetido
+  CORPUS_ENVIESADO,  // distribuição geométrica: poucos bytes dominam
+  NUM_TIPOS_CORPUS
+} TipoCorpus;
+
+/**
+ * @brief Retorna o nome de um tipo de corpus, usado também como nome do
+ * arquivo gerado.
+ * @param tipo Tipo do corpus.
+ * @return O nome (string estática).
+ */
+const char *nomeCorpus(TipoCorpus tipo);
+
+/**
+ * @brief Converte um nome no tipo de corpus correspondente.
+ * @param nome Nome do corpus.
+ * @return O tipo, ou -1 se o nome não existir.
+ */
+int tipoCorpusDoNome(const char *nome);
+
+/**
+ * @brief Gera um arquivo do corpus. Se ele já existir com o tamanho pedido,
+ * é reaproveitado.
+ * @param caminho Caminho do arquivo.
+ * @param tipo Tipo do conteúdo.
+ * @param tamanho Tamanho em bytes (pode passar de 4 GiB).
+ * @param semente Semente do gerador pseudoaleatório.
+ * @return 0 em caso de sucesso, -1 se o arquivo não puder ser gravado.
+ */
+int geraCorpus(const char *caminho, TipoCorpus tipo, uint64_t tamanho,
+               uint64_t semente);
+
+#endif // CORPUS_H
@@ -10,10 +10,10 @@
 #include "bitmap.h"
 
 struct map {
-    unsigned int max_size;        ///< tamanho maximo em bits
-    unsigned int length;         ///< tamanho atual em bits
+    uint64_t max_size;           ///< tamanho maximo em bits
+    uint64_t length;             ///< tamanho atual em bits
     unsigned char* contents;     ///< conteudo do mapa de bits
-	unsigned int capacity;      ///< capacidade alocada em bits
+	uint64_t capacity;          ///< capacidade alocada em bits
 };
 
 /**
@@ -42,7 +42,7 @@ unsigned char* bitmapGetContents(bitmap* bm) {
  * @param bm O mapa de bits.
  * @return O tamanho maximo do mapa de bits.
  */
-unsigned int bitmapGetMaxSize(bitmap* bm) {
+uint64_t bitmapGetMaxSize(bitmap* bm) {
 	return bm->max_size;
 }
 
@@ -51,7 +51,7 @@ unsigned int bitmapGetMaxSize(bitmap* bm) {
  * @param bm O mapa de bits.
  * @return O tamanho atual do mapa de bits.
  */
-unsigned int bitmapGetLength(bitmap* bm) {
+uint64_t bitmapGetLength(bitmap* bm) {
 	return bm->length;
 }
 
@@ -60,11 +60,26 @@ unsigned int bitmapGetLength(bitmap* bm) {
  * @param max_size O tamanho maximo para o mapa de bits.
  * @return O mapa de bits inicializado.
  */
-bitmap* bitmapInit(unsigned int initial_capacity) {
+bitmap* bitmapInit(uint64_t initial_capacity) {
+    bitmap* bm = bitmapTentaInit(initial_capacity);
+    assert(bm != NULL, "Erro de alocacao de memoria.");
+    return bm;
+}
+
+/**
+ * Constroi um novo mapa de bits como bitmapInit, mas sem abortar o programa.
+ * @param initial_capacity A capacidade inicial em bits.
+ * @return O mapa de bits inicializado, ou NULL se faltar memoria.
+ */
+bitmap* bitmapTentaInit(uint64_t initial_capacity) {
     bitmap* bm = (bitmap*)malloc(sizeof(bitmap));
-    unsigned int capacityInBytes = (initial_capacity + 7) / 8;
+    if (bm == NULL) return NULL;
+    size_t capacityInBytes = (size_t)((initial_capacity + 7) / 8);
     bm->contents = calloc(capacityInBytes, sizeof(char));
-    assert(bm->contents != NULL, "Erro de alocacao de memoria.");
+    if (bm->contents == NULL) {
+        free(bm);
+        return NULL;
+    }
     bm->capacity = initial_capacity;
     bm->length = 0;
     bm->max_size = initial_capacity; // pode remover se não for mais usar
@@ -78,7 +93,7 @@ bitmap* bitmapInit(unsigned int initial_capacity) {
  * @pre index<bitmapGetLength(bm)
  * @return O valor do bit.
  */
-unsigned char bitmapGetBit(bitmap* bm, unsigned int index) // index in bits
+unsigned char bitmapGetBit(bitmap* bm, uint64_t index) // index in bits
 {
 	// verificar se index<bm.length, pois caso contrario, index e' invalido
 	assert(index<bm->length, "Acesso a posicao inexistente no mapa de bits.");
@@ -94,7 +109,7 @@ unsigned char bitmapGetBit(bitmap* bm, unsigned int index) // index in bits
  * @param bit O novo valor do bit.
  * @post bitmapGetBit(bm,index)==bit
  */
-static void bitmapSetBit(bitmap* bm, unsigned int index, unsigned char bit) {
+static void bitmapSetBit(bitmap* bm, uint64_t index, unsigned char bit) {
     // verificar se index<bm->length, pois caso contrario, index e' invalido
     assert(index<bm->length, "Acesso a posicao inexistente no mapa de bits.");
     // index/8 e' o indice do byte que contem o bit em questao
@@ -105,17 +120,17 @@ static void bitmapSetBit(bitmap* bm, unsigned int index, unsigned char bit) {
 }
 
 
-static void bitmapEnsureCapacity(bitmap* bm, unsigned int min_capacity) {
+static void bitmapEnsureCapacity(bitmap* bm, uint64_t min_capacity) {
     if (bm->capacity >= min_capacity) return;
-    unsigned int new_capacity = bm->capacity ? bm->capacity * 2 : 1024;
+    uint64_t new_capacity = bm->capacity ? bm->capacity * 2 : 1024;
     while (new_capacity < min_capacity) {
         new_capacity *= 2;
     }
-    unsigned int new_bytes = (new_capacity + 7) / 8;
+    size_t new_bytes = (size_t)((new_capacity + 7) / 8);
     bm->contents = realloc(bm->contents, new_bytes);
     assert(bm->contents != NULL, "Erro de realocacao de memoria.");
     // zera a nova área alocada
-    unsigned int old_bytes = (bm->capacity + 7) / 8;
+    size_t old_bytes = (size_t)((bm->capacity + 7) / 8);
     if (new_bytes > old_bytes) {
         memset(bm->contents + old_bytes, 0, new_bytes - old_bytes);
     }
@@ -135,6 +150,55 @@ void bitmapAppendLeastSignificantBit(bitmap* bm, unsigned char bit) {
     bm->length++;
     bitmapSetBit(bm, bm->length-1, bit);
 }
+/**
+ * Adiciona varios bits de uma vez no final do mapa de bits.
+ * @param bm O mapa de bits.
+ * @param bits Valor cujos n bits menos significativos serao adicionados, do mais
+ * significativo para o menos significativo.
+ * @param n Quantidade de bits (0 a 64).
+ * @post bitmapGetLength(bm) == bitmapGetLength(bm) @ pre+n
+ */
+void bitmapAppendBits(bitmap* bm, uint64_t bits, unsigned int n) {
+    if (n == 0) return;
+    // no maximo 32 bits por vez, para que caibam junto com o byte parcial
+    if (n > 32) {
+        bitmapAppendBits(bm, bits >> 32, n - 32);
+        n = 32;
+    }
+    bits &= (n == 32) ? 0xFFFFFFFFu : ((1u << n) - 1);
+
+    bitmapEnsureCapacity(bm, bm->length + n);
+
+    // bits ja ocupados no ultimo byte
+    unsigned int ocupados = bm->length % 8;
+    unsigned char* p = bm->contents + bm->length / 8;
+
+    // alinha os novos bits logo depois dos ja ocupados, a partir do bit mais
+    // significativo de v, e copia byte a byte (a area livre ja esta zerada)
+    uint64_t v = (bits << (64 - n)) >> ocupados;
+    unsigned int bytes = (ocupados + n + 7) / 8;
+    for (unsigned int i = 0; i < bytes; i++) {
+        p[i] |= (unsigned char)(v >> (56 - 8 * i));
+    }
+
+    bm->length += n;
+}
+
+/**
+ * Adiciona bytes inteiros no final do mapa de bits, copiados de uma vez.
+ * @param bm O mapa de bits.
+ * @param bytes Os bytes a adicionar.
+ * @param n Quantidade de bytes.
+ * @pre bitmapGetLength(bm) % 8 == 0
+ * @post bitmapGetLength(bm) == bitmapGetLength(bm) @ pre+8*n
+ */
+void bitmapAppendBytes(bitmap* bm, const unsigned char* bytes, uint64_t n) {
+    assert(bm->length % 8 == 0, "Mapa de bits nao alinhado ao byte.");
+    bitmapEnsureCapacity(bm, bm->length + 8 * n);
+    memcpy(bm->contents + bm->length / 8, bytes, (size_t)n);
+    bm->length += 8 * n;
+}
+
 /**
  * Libera a memória dinâmica alocada para o mapa de bits.
  * @param bm O mapa de bits.
@@ -152,7 +216,7 @@ void bitmapLibera (bitmap* bm){
 void bitmapRemoveLastBit(bitmap* bm) {
     if (bm->length > 0) {
         //encontra a posiçao do ultimo bit antes de decrementar o length
-        unsigned int byte_index = (bm->length - 1) / 8;
+        uint64_t byte_index = (bm->length - 1) / 8;
         unsigned int bit_offset = 7 - ((bm->length - 1) % 8);
         
         //zera o bit na posiçao do antigo ultimo bit
@@ -161,4 +225,34 @@ void bitmapRemoveLastBit(bitmap* bm) {
         //decrementa
         bm->length--;
     }
-}
\ No newline at end of file
+}
+
+/**
+ * Esvazia o mapa de bits sem liberar a memória, para que possa ser reusado.
+ * @param bm O mapa de bits.
+ * @post bitmapGetLength(bm) == 0
+ */
+void bitmapReinicia(bitmap* bm) {
+    // os bits sao escritos com OR, entao a area usada precisa voltar a zero
+    memset(bm->contents, 0, (size_t)((bm->length + 7) / 8));
+    bm->length = 0;
+}
+
+/**
+ * Remove os n primeiros bytes do mapa de bits, que ja foram aproveitados
+ * (gravados em um arquivo, por exemplo), e move o restante para o inicio.
+ * Permite escrever um fluxo de bits maior que a memoria em pedacos.
+ * @param bm O mapa de bits.
+ * @param n Quantidade de bytes completos a remover.
+ * @pre n <= bitmapGetLength(bm) / 8
+ * @post bitmapGetLength(bm) == bitmapGetLength(bm) @ pre - 8 * n
+ */
+void bitmapDescartaBytes(bitmap* bm, uint64_t n) {
+    assert(n <= bm->length / 8, "Descarte maior que o mapa de bits.");
+    size_t usados = (size_t)((bm->length + 7) / 8);
+    size_t restantes = usados - (size_t)n;
+    memmove(bm->contents, bm->contents + n, restantes);
+    // a area liberada volta a zero, pois os bits sao escritos com OR
+    memset(bm->contents + restantes, 0, (size_t)n);
+    bm->length -= 8 * n;
+}
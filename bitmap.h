@@ -6,19 +6,31 @@
 #ifndef BITMAP_H_
 #define BITMAP_H_
 
+#include <stdint.h>
+
 /**
  * Estrutura para representar um mapa de bits.
  */
 typedef struct map bitmap;
 
 unsigned char* bitmapGetContents(bitmap* bm);
-unsigned int bitmapGetMaxSize(bitmap* bm);
-unsigned int bitmapGetLength(bitmap* bm);
-bitmap* bitmapInit(unsigned int max_size);
-unsigned char bitmapGetBit(bitmap* bm, unsigned int index);
+uint64_t bitmapGetMaxSize(bitmap* bm);
+uint64_t bitmapGetLength(bitmap* bm);
+bitmap* bitmapInit(uint64_t max_size);
+//como bitmapInit, mas retorna NULL em vez de abortar se faltar memoria
+bitmap* bitmapTentaInit(uint64_t max_size);
+unsigned char bitmapGetBit(bitmap* bm, uint64_t index);
 void bitmapAppendLeastSignificantBit(bitmap* bm, unsigned char bit);
+//adiciona os n bits menos significativos de bits, do mais significativo para o menos
+void bitmapAppendBits(bitmap* bm, uint64_t bits, unsigned int n);
+//adiciona n bytes inteiros a partir de um tamanho alinhado ao byte
+void bitmapAppendBytes(bitmap* bm, const unsigned char* bytes, uint64_t n);
 void bitmapLibera (bitmap* bm);
 //remove o ultimo bit do mapa de bits, decrementando o tamanho
 void bitmapRemoveLastBit(bitmap* bm);
+//esvazia o mapa de bits mantendo a memoria alocada, para reaproveita-lo
+void bitmapReinicia(bitmap* bm);
+//remove os n primeiros bytes completos, movendo o restante para o inicio
+void bitmapDescartaBytes(bitmap* bm, uint64_t n);
 
 #endif /*BITMAP_H_*/
@@ -0,0 +1,424 @@
+/*
+ *
+ * Compactação em blocos
+ * Cada bloco tem o seu próprio histograma e os seus próprios códigos, e é
+ * compactado e descompactado de forma independente dos demais
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "bloco.h"
+#include "decodificador.h"
+#include "escritor.h"
+#include "histograma.h"
+#include "huffman.h"
+#include <stdlib.h>
+#include <string.h>
+
+// assinatura, versão, tamanho do bloco, quantidade de blocos e tamanho
+// original
+#define TAMANHO_CABECALHO_FIXO (4 + 1 + 4 + 4 + 8)
+#define TAMANHO_ENTRADA_INDICE (8 + 4 + 4)
+
+uint64_t tamanhoCabecalhoIndexado(uint32_t numBlocos) {
+  return TAMANHO_CABECALHO_FIXO + (uint64_t)numBlocos * TAMANHO_ENTRADA_INDICE;
+}
+
+// grava o valor em big-endian e retorna a posição seguinte
+static unsigned char *escreveInteiro(unsigned char *p, uint64_t valor,
+                                     int bytes) {
+  for (int i = bytes - 1; i >= 0; i--) {
+    *p++ = (unsigned char)((valor >> (8 * i)) & 0xFF);
+  }
+  return p;
+}
+
+void montaCabecalhoBlocos(unsigned char *destino, uint32_t tamanhoBloco) {
+  unsigned char *p = destino;
+  p = escreveInteiro(p, ASSINATURA_FORMATO, 4);
+  p = escreveInteiro(p, VERSAO_BLOCOS, 1);
+  escreveInteiro(p, tamanhoBloco, 4);
+}
+
+void montaPrefixoBloco(unsigned char *destino, uint32_t tamanhoOriginal,
+                       uint32_t tamanhoCompactado) {
+  unsigned char *p = escreveInteiro(destino, tamanhoOriginal, 4);
+  escreveInteiro(p, tamanhoCompactado, 4);
+}
+
+void montaCabecalhoIndexado(unsigned char *destino, int versao,
+                            uint32_t tamanhoBloco, const EntradaIndice *indice,
+                            uint32_t numBlocos, uint64_t tamanhoOriginal) {
+  unsigned char *p = destino;
+  p = escreveInteiro(p, ASSINATURA_FORMATO, 4);
+  p = escreveInteiro(p, (uint64_t)versao, 1);
+  p = escreveInteiro(p, tamanhoBloco, 4);
+  p = escreveInteiro(p, numBlocos, 4);
+  escreveInteiro(p, tamanhoOriginal, 8);
+
+  if (indice != NULL) {
+    for (uint32_t i = 0; i < numBlocos; i++) {
+      montaEntradaIndice(destino, i, &indice[i]);
+    }
+  }
+}
+
+void montaEntradaIndice(unsigned char *cabecalho, uint32_t i,
+                        const EntradaIndice *e) {
+  unsigned char *p = cabecalho + tamanhoCabecalhoIndexado(i);
+  p = escreveInteiro(p, e->deslocamento, 8);
+  p = escreveInteiro(p, e->tamanhoCompactado, 4);
+  escreveInteiro(p, e->tamanhoOriginal, 4);
+}
+
+static uint64_t leInteiro64(LeitorBits *l) {
+  uint64_t alto = leBits(l, 32);
+  return (alto << 32) | leBits(l, 32);
+}
+
+int leCabecalhoIndexadoFixo(LeitorBits *l, uint64_t tamanhoArquivo,
+                            uint32_t *tamanhoBloco, uint32_t *numBlocos,
+                            uint64_t *tamanhoOriginal) {
+  *tamanhoBloco = leBits(l, 32);
+  *numBlocos = leBits(l, 32);
+  *tamanhoOriginal = leInteiro64(l);
+
+  if (*tamanhoBloco < TAMANHO_BLOCO_MINIMO ||
+      *tamanhoBloco > TAMANHO_BLOCO_MAXIMO ||
+      tamanhoCabecalhoIndexado(*numBlocos) > tamanhoArquivo ||
+      leitorEstourou(l)) {
+    return -1;
+  }
+
+  // o compactador divide o original em blocos cheios e um último parcial:
+  // qualquer outra quantidade é um cabeçalho corrompido
+  uint64_t esperados = *tamanhoOriginal / *tamanhoBloco +
+                       (*tamanhoOriginal % *tamanhoBloco != 0);
+  if (*numBlocos != esperados) {
+    return -1;
+  }
+
+  return 0;
+}
+
+int leEntradaIndice(LeitorBits *l, uint64_t tamanhoArquivo,
+                    uint32_t tamanhoBloco, uint32_t numBlocos,
+                    uint64_t posicaoOriginal, EntradaIndice *e) {
+  e->deslocamento = leInteiro64(l);
+  e->tamanhoCompactado = leBits(l, 32);
+  e->tamanhoOriginal = leBits(l, 32);
+  e->posicaoOriginal = posicaoOriginal;
+
+  // cada bloco precisa estar inteiro dentro do arquivo, depois do cabeçalho
+  if (e->tamanhoOriginal == 0 || e->tamanhoOriginal > tamanhoBloco ||
+      e->tamanhoCompactado > (uint64_t)tamanhoBloco + FOLGA_BLOCO_COMPACTADO ||
+      e->deslocamento < tamanhoCabecalhoIndexado(numBlocos) ||
+      e->deslocamento > tamanhoArquivo ||
+      e->tamanhoCompactado > tamanhoArquivo - e->deslocamento ||
+      leitorEstourou(l)) {
+    return -1;
+  }
+
+  return 0;
+}
+
+EntradaIndice *leCabecalhoIndexado(LeitorBits *l, uint64_t tamanhoArquivo,
+                                   uint32_t *tamanhoBloco,
+                                   uint32_t *numBlocos,
+                                   uint64_t *tamanhoOriginal) {
+  if (leCabecalhoIndexadoFixo(l, tamanhoArquivo, tamanhoBloco, numBlocos,
+                              tamanhoOriginal) != 0) {
+    return NULL;
+  }
+
+  EntradaIndice *indice = malloc(((size_t)*numBlocos + 1) * sizeof(EntradaIndice));
+  if (indice == NULL) {
+    return NULL;
+  }
+
+  uint64_t posicao = 0;
+  for (uint32_t i = 0; i < *numBlocos; i++) {
+    if (leEntradaIndice(l, tamanhoArquivo, *tamanhoBloco, *numBlocos,
+                        posicao, &indice[i]) != 0) {
+      free(indice);
+      return NULL;
+    }
+    posicao += indice[i].tamanhoOriginal;
+  }
+
+  if (posicao != *tamanhoOriginal) {
+    free(indice);
+    return NULL;
+  }
+
+  return indice;
+}
+
+// histograma, comprimentos (com o limite) e códigos canônicos de um bloco,
+// com o tamanho dos códigos em bits; retorna -1 se os bytes do bloco não
+// couberem no limite
+static int calculaCodigosBloco(const unsigned char *dados, size_t n,
+                               int limiteBits, unsigned char comprimentos[],
+                               CodigoHuffman tabela[], uint64_t *bits,
+                               Estatisticas *est, Cronometro *cronometro) {
+  uint64_t frequencias[NUM_SIMBOLOS] = {0};
+  contaBytes(dados, n, frequencias);
+  marcaFase(est, FASE_CONTAGEM, cronometro);
+
+  // os comprimentos saem direto das frequências, sem alocar os nós: cada
+  // bloco é compactado só com áreas na pilha
+  int maior =
+      calculaComprimentosDeFrequencias(frequencias, NUM_SIMBOLOS, comprimentos);
+
+  est->bitsSemLimite +=
+      calculaBitsCodificados(frequencias, comprimentos, NUM_SIMBOLOS);
+  if (aplicaLimiteComprimentos(frequencias, NUM_SIMBOLOS, limiteBits, maior,
+                               comprimentos) != 0) {
+    return -1;
+  }
+  *bits = calculaBitsCodificados(frequencias, comprimentos, NUM_SIMBOLOS);
+  est->bitsComLimite += *bits;
+  acumulaEntropia(est, frequencias, NUM_SIMBOLOS);
+  registraComprimentos(est, comprimentos, NUM_SIMBOLOS);
+  marcaFase(est, FASE_ARVORE, cronometro);
+
+  if (montaTabelaCodigos(comprimentos, NUM_SIMBOLOS, tabela) != 0) {
+    return -1;
+  }
+  marcaFase(est, FASE_TABELA, cronometro);
+
+  return 0;
+}
+
+// Troca o que já foi escrito no mapa pelo bloco armazenado (a marca e os
+// bytes originais), quando o cabeçalho mais os códigos não ficariam menores
+// que isso. Retorna 1 se o bloco foi armazenado.
+static int armazenaSeNaoCompensa(const unsigned char *dados, size_t n,
+                                 uint64_t bitsCompactado, bitmap *bm) {
+  if ((bitsCompactado + 7) / 8 < (uint64_t)n + 1) {
+    return 0;
+  }
+
+  bitmapReinicia(bm);
+  bitmapAppendBits(bm, MARCA_BLOCO_ARMAZENADO, 8);
+  bitmapAppendBytes(bm, dados, n);
+  return 1;
+}
+
+// copia um bloco armazenado; retorna 1 se o bloco não for armazenado, para
+// seguir pela descompactação, e -1 se estiver corrompido
+static int copiaBlocoArmazenado(const unsigned char *dados, size_t tamanho,
+                                unsigned char *saida, size_t n) {
+  if (tamanho < 1 || dados[0] != MARCA_BLOCO_ARMAZENADO) {
+    return 1;
+  }
+  if (tamanho - 1 < n) {
+    return -1;
+  }
+  memcpy(saida, dados + 1, n);
+  return 0;
+}
+
+int compactaBloco(const unsigned char *dados, size_t n, int limiteBits,
+                  bitmap *bm, Estatisticas *est) {
+  Cronometro cronometro;
+  iniciaCronometro(&cronometro);
+
+  unsigned char comprimentos[NUM_SIMBOLOS];
+  CodigoHuffman tabela[NUM_SIMBOLOS];
+  uint64_t bits;
+  if (calculaCodigosBloco(dados, n, limiteBits, comprimentos, tabela, &bits,
+                          est, &cronometro) != 0) {
+    return -1;
+  }
+
+  escreveComprimentos(bm, comprimentos, NUM_SIMBOLOS);
+  marcaFase(est, FASE_CABECALHO, &cronometro);
+
+  // o tamanho já é conhecido antes de codificar: dados que não diminuem
+  // (já compactados, aleatórios) são só copiados
+  if (armazenaSeNaoCompensa(dados, n, bitmapGetLength(bm) + bits, bm)) {
+    marcaFase(est, FASE_CODIFICACAO, &cronometro);
+    return 0;
+  }
+
+  EscritorBits escritor;
+  iniciaEscritor(&escritor, bm);
+  for (size_t i = 0; i < n; i++) {
+    escreveCodigo(&escritor, tabela[dados[i]].codigo,
+                  tabela[dados[i]].comprimento);
+  }
+  finalizaEscritor(&escritor);
+  marcaFase(est, FASE_CODIFICACAO, &cronometro);
+
+  return 0;
+}
+
+// completa o último byte do mapa com zeros
+static void alinhaBitmap(bitmap *bm) {
+  bitmapAppendBits(bm, 0, (8 - bitmapGetLength(bm) % 8) % 8);
+}
+
+int compactaBlocoIntercalado(const unsigned char *dados, size_t n,
+                             int limiteBits, int numFluxos, bitmap *bm,
+                             Estatisticas *est) {
+  Cronometro cronometro;
+  iniciaCronometro(&cronometro);
+
+  unsigned char comprimentos[NUM_SIMBOLOS];
+  CodigoHuffman tabela[NUM_SIMBOLOS];
+  uint64_t bits;
+  if (calculaCodigosBloco(dados, n, limiteBits, comprimentos, tabela, &bits,
+                          est, &cronometro) != 0) {
+    return -1;
+  }
+
+  // a tabela de saltos é reservada agora e preenchida no fim
+  bitmapAppendBits(bm, (uint64_t)numFluxos, 8);
+  for (int j = 0; j < numFluxos; j++) {
+    bitmapAppendBits(bm, 0, 32);
+  }
+
+  escreveComprimentos(bm, comprimentos, NUM_SIMBOLOS);
+  alinhaBitmap(bm);
+  marcaFase(est, FASE_CABECALHO, &cronometro);
+
+  // cada fluxo pode perder até 7 bits no alinhamento
+  if (armazenaSeNaoCompensa(dados, n,
+                            bitmapGetLength(bm) + bits + 7 * (uint64_t)numFluxos,
+                            bm)) {
+    marcaFase(est, FASE_CODIFICACAO, &cronometro);
+    return 0;
+  }
+
+  uint32_t inicios[MAX_FLUXOS];
+  for (int j = 0; j < numFluxos; j++) {
+    inicios[j] = (uint32_t)(bitmapGetLength(bm) / 8);
+
+    EscritorBits escritor;
+    iniciaEscritor(&escritor, bm);
+    for (size_t i = (size_t)j; i < n; i += (size_t)numFluxos) {
+      escreveCodigo(&escritor, tabela[dados[i]].codigo,
+                    tabela[dados[i]].comprimento);
+    }
+    finalizaEscritor(&escritor);
+    alinhaBitmap(bm);
+  }
+
+  unsigned char *p = bitmapGetContents(bm) + 1;
+  for (int j = 0; j < numFluxos; j++) {
+    p = escreveInteiro(p, inicios[j], 4);
+  }
+  marcaFase(est, FASE_CODIFICACAO, &cronometro);
+
+  return 0;
+}
+
+int descompactaBloco(const unsigned char *dados, size_t tamanho,
+                     unsigned char *saida, size_t n,
+                     TabelaDecodificacao *tabela, Estatisticas *est) {
+  Cronometro cronometro;
+  iniciaCronometro(&cronometro);
+
+  int armazenado = copiaBlocoArmazenado(dados, tamanho, saida, n);
+  if (armazenado <= 0) {
+    marcaFase(est, FASE_DECODIFICACAO, &cronometro);
+    return armazenado;
+  }
+
+  LeitorBits leitor;
+  iniciaLeitorMemoria(&leitor, dados, tamanho);
+
+  // o EOF não pode aparecer dentro de um bloco
+  unsigned char comprimentos[NUM_SIMBOLOS];
+  if (leComprimentos(&leitor, comprimentos, NUM_SIMBOLOS) != 0 ||
+      comprimentos[SIMBOLO_EOF] != 0) {
+    return -1;
+  }
+  registraComprimentos(est, comprimentos, NUM_SIMBOLOS);
+  marcaFase(est, FASE_CABECALHO, &cronometro);
+
+  if (remontaTabelaDosComprimentos(tabela, comprimentos, 256) != 0) {
+    return -1;
+  }
+  marcaFase(est, FASE_TABELA, &cronometro);
+
+  int resultado = decodificaSimbolos(tabela, &leitor, saida, n);
+  marcaFase(est, FASE_DECODIFICACAO, &cronometro);
+
+  finalizaLeitor(&leitor);
+
+  return resultado;
+}
+
+int descompactaBlocoIntercalado(const unsigned char *dados, size_t tamanho,
+                                unsigned char *saida, size_t n,
+                                TabelaDecodificacao *tabela,
+                                Estatisticas *est) {
+  Cronometro cronometro;
+  iniciaCronometro(&cronometro);
+
+  int armazenado = copiaBlocoArmazenado(dados, tamanho, saida, n);
+  if (armazenado <= 0) {
+    marcaFase(est, FASE_DECODIFICACAO, &cronometro);
+    return armazenado;
+  }
+  if (tamanho < 1) {
+    return -1;
+  }
+
+  int numFluxos = dados[0];
+  size_t tamanhoSaltos = 1 + 4 * (size_t)numFluxos;
+  if (numFluxos < 1 || numFluxos > MAX_FLUXOS || tamanho < tamanhoSaltos) {
+    return -1;
+  }
+
+  // cada fluxo vai do seu início até o início do seguinte
+  size_t inicios[MAX_FLUXOS + 1];
+  for (int j = 0; j < numFluxos; j++) {
+    const unsigned char *p = dados + 1 + 4 * j;
+    inicios[j] = ((size_t)p[0] << 24) | ((size_t)p[1] << 16) |
+                 ((size_t)p[2] << 8) | (size_t)p[3];
+  }
+  inicios[numFluxos] = tamanho;
+  for (int j = 0; j < numFluxos; j++) {
+    if (inicios[j] < tamanhoSaltos || inicios[j] > inicios[j + 1]) {
+      return -1;
+    }
+  }
+
+  // os comprimentos ficam entre a tabela de saltos e o primeiro fluxo
+  LeitorBits leitor;
+  iniciaLeitorMemoria(&leitor, dados + tamanhoSaltos,
+                      inicios[0] - tamanhoSaltos);
+  unsigned char comprimentos[NUM_SIMBOLOS];
+  int invalido = leComprimentos(&leitor, comprimentos, NUM_SIMBOLOS) != 0 ||
+                 leitorEstourou(&leitor) || comprimentos[SIMBOLO_EOF] != 0;
+  finalizaLeitor(&leitor);
+  if (invalido) {
+    return -1;
+  }
+  registraComprimentos(est, comprimentos, NUM_SIMBOLOS);
+  marcaFase(est, FASE_CABECALHO, &cronometro);
+
+  if (remontaTabelaDosComprimentos(tabela, comprimentos, 256) != 0) {
+    return -1;
+  }
+  marcaFase(est, FASE_TABELA, &cronometro);
+
+  LeitorBits leitores[MAX_FLUXOS];
+  for (int j = 0; j < numFluxos; j++) {
+    iniciaLeitorMemoria(&leitores[j], dados + inicios[j],
+                        inicios[j + 1] - inicios[j]);
+  }
+
+  int resultado =
+      decodificaSimbolosIntercalados(tabela, leitores, numFluxos, saida, n);
+  marcaFase(est, FASE_DECODIFICACAO, &cronometro);
+
+  for (int j = 0; j < numFluxos; j++) {
+    finalizaLeitor(&leitores[j]);
+  }
+
+  return resultado;
+}
@@ -0,0 +1,241 @@
+/*
+ *
+ * Compactação em blocos
+ * Cada bloco tem o seu próprio histograma e os seus próprios códigos, e é
+ * compactado e descompactado de forma independente dos demais
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef BLOCO_H
+#define BLOCO_H
+
+#include "bitmap.h"
+#include "decodificador.h"
+#include "estatisticas.h"
+#include "leitor.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// versão do formato dividido em blocos, com os tamanhos antes de cada bloco;
+// como não precisa de índice, é gravada em uma única passada (entrada e saída
+// padrão)
+#define VERSAO_BLOCOS 2
+
+// assinatura, versão e tamanho do bloco do formato sem índice
+#define TAMANHO_CABECALHO_BLOCOS 9
+
+// tamanho original e compactado antes de cada bloco do formato sem índice
+#define TAMANHO_PREFIXO_BLOCO 8
+
+// versão em blocos com um índice no cabeçalho, que permite descompactar os
+// blocos em qualquer ordem
+#define VERSAO_BLOCOS_INDEXADOS 3
+
+// versão indexada em que cada bloco é dividido em fluxos intercalados que
+// compartilham a mesma tabela de códigos
+#define VERSAO_BLOCOS_INTERCALADOS 4
+
+#define NUM_FLUXOS_PADRAO 4
+#define MAX_FLUXOS 16
+
+#define TAMANHO_BLOCO_PADRAO (1024 * 1024)
+#define TAMANHO_BLOCO_MINIMO 1024
+#define TAMANHO_BLOCO_MAXIMO (256 * 1024 * 1024)
+
+// folga sobre o tamanho original para o maior bloco compactado possível: o
+// cabeçalho dos comprimentos nunca chega a 1 KiB e os códigos ótimos nunca
+// são piores que os 8 bits de cada byte
+#define FOLGA_BLOCO_COMPACTADO 4096
+
+// primeiro byte de um bloco armazenado sem compactação, seguido dos bytes
+// originais. Nenhum bloco compactado começa com ele: o de um fluxo começa
+// pelos comprimentos, cujos 5 primeiros bits nunca passam de 16, e o
+// intercalado pela quantidade de fluxos.
+#define MARCA_BLOCO_ARMAZENADO 0xFF
+
+/**
+ * @brief Entrada do índice de blocos do formato indexado.
+ */
+typedef struct {
+  uint64_t deslocamento;      // posição do bloco compactado no arquivo
+  uint32_t tamanhoCompactado; // bytes do bloco compactado
+  uint32_t tamanhoOriginal;   // bytes do bloco descompactado
+  uint64_t posicaoOriginal;   // início do bloco no arquivo original (não é
+                              // gravada: é a soma dos tamanhos anteriores)
+} EntradaIndice;
+
+/**
+ * @brief Monta o cabeçalho do formato em blocos sem índice: assinatura,
+ * versão e tamanho do bloco.
+ * @param destino Área com TAMANHO_CABECALHO_BLOCOS bytes.
+ * @param tamanhoBloco Tamanho dos blocos.
+ */
+void montaCabecalhoBlocos(unsigned char *destino, uint32_t tamanhoBloco);
+
+/**
+ * @brief Monta o prefixo de um bloco do formato sem índice. Um prefixo com
+ * tamanho original zero marca o fim do arquivo.
+ * @param destino Área com TAMANHO_PREFIXO_BLOCO bytes.
+ * @param tamanhoOriginal Bytes do bloco descompactado.
+ * @param tamanhoCompactado Bytes do bloco compactado.
+ */
+void montaPrefixoBloco(unsigned char *destino, uint32_t tamanhoOriginal,
+                       uint32_t tamanhoCompactado);
+
+/**
+ * @brief Calcula o tamanho do cabeçalho do formato indexado, incluindo a
+ * assinatura, a versão e o índice.
+ * @param numBlocos Quantidade de blocos.
+ * @return O tamanho em bytes.
+ */
+uint64_t tamanhoCabecalhoIndexado(uint32_t numBlocos);
+
+/**
+ * @brief Monta o cabeçalho do formato indexado: assinatura, versão,
+ * tamanho do bloco, quantidade de blocos, tamanho original e o índice.
+ * @param destino Área com tamanhoCabecalhoIndexado(numBlocos) bytes.
+ * @param versao VERSAO_BLOCOS_INDEXADOS ou VERSAO_BLOCOS_INTERCALADOS.
+ * @param tamanhoBloco Tamanho dos blocos.
+ * @param indice Entradas do índice (podem estar zeradas, para reservar o
+ * espaço antes de os blocos serem compactados), ou NULL para montar só a
+ * parte fixa e gravar as entradas depois, com montaEntradaIndice.
+ * @param numBlocos Quantidade de blocos.
+ * @param tamanhoOriginal Tamanho do arquivo original.
+ */
+void montaCabecalhoIndexado(unsigned char *destino, int versao,
+                            uint32_t tamanhoBloco, const EntradaIndice *indice,
+                            uint32_t numBlocos, uint64_t tamanhoOriginal);
+
+/**
+ * @brief Grava uma entrada do índice na sua posição do cabeçalho indexado.
+ * @param cabecalho Início do cabeçalho.
+ * @param i Número do bloco.
+ * @param e Entrada do bloco.
+ */
+void montaEntradaIndice(unsigned char *cabecalho, uint32_t i,
+                        const EntradaIndice *e);
+
+/**
+ * @brief Lê a parte fixa do cabeçalho do formato indexado, depois da
+ * assinatura e da versão, sem ler o índice.
+ * @param l Leitor posicionado logo após a versão.
+ * @param tamanhoArquivo Tamanho do arquivo compactado.
+ * @param tamanhoBloco Saída com o tamanho dos blocos.
+ * @param numBlocos Saída com a quantidade de blocos.
+ * @param tamanhoOriginal Saída com o tamanho do arquivo original.
+ * @return 0 em caso de sucesso, -1 se o cabeçalho for inválido (inclusive
+ * se numBlocos não for o tamanho original dividido em blocos, arredondado
+ * para cima).
+ */
+int leCabecalhoIndexadoFixo(LeitorBits *l, uint64_t tamanhoArquivo,
+                            uint32_t *tamanhoBloco, uint32_t *numBlocos,
+                            uint64_t *tamanhoOriginal);
+
+/**
+ * @brief Lê e valida a próxima entrada do índice.
+ * @param l Leitor posicionado na entrada.
+ * @param tamanhoArquivo Tamanho do arquivo compactado.
+ * @param tamanhoBloco Tamanho dos blocos, lido do cabeçalho.
+ * @param numBlocos Quantidade de blocos, lida do cabeçalho.
+ * @param posicaoOriginal Início do bloco no arquivo original.
+ * @param e Saída com a entrada lida.
+ * @return 0 em caso de sucesso, -1 se a entrada for inválida.
+ */
+int leEntradaIndice(LeitorBits *l, uint64_t tamanhoArquivo,
+                    uint32_t tamanhoBloco, uint32_t numBlocos,
+                    uint64_t posicaoOriginal, EntradaIndice *e);
+
+/**
+ * @brief Lê o restante do cabeçalho do formato indexado, depois da
+ * assinatura e da versão, e valida o índice.
+ * @param l Leitor posicionado logo após a versão.
+ * @param tamanhoArquivo Tamanho do arquivo compactado, para validar os
+ * deslocamentos.
+ * @param tamanhoBloco Saída com o tamanho dos blocos.
+ * @param numBlocos Saída com a quantidade de blocos.
+ * @param tamanhoOriginal Saída com o tamanho do arquivo original.
+ * @return O índice alocado dinamicamente, ou NULL se o cabeçalho for
+ * inválido ou não houver memória para o índice.
+ */
+EntradaIndice *leCabecalhoIndexado(LeitorBits *l, uint64_t tamanhoArquivo,
+                                   uint32_t *tamanhoBloco,
+                                   uint32_t *numBlocos,
+                                   uint64_t *tamanhoOriginal);
+
+/**
+ * @brief Compacta um bloco: os comprimentos dos códigos canônicos seguidos
+ * dos códigos de cada byte. O fim do bloco vem do seu tamanho, então o
+ * símbolo EOF não é usado. Se os códigos não deixariam o bloco menor, ele é
+ * armazenado: MARCA_BLOCO_ARMAZENADO seguida dos bytes originais.
+ * @param dados Bytes do bloco.
+ * @param n Quantidade de bytes (maior que zero).
+ * @param limiteBits Comprimento máximo dos códigos (0 = sem limite).
+ * @param bm Mapa de bits vazio que recebe o bloco compactado.
+ * @param est Acumula os tempos das fases, a entropia e o tamanho dos códigos
+ * (com e sem o limite).
+ * @return 0 em caso de sucesso, -1 se os bytes do bloco não couberem no
+ * limite de bits.
+ */
+int compactaBloco(const unsigned char *dados, size_t n, int limiteBits,
+                  bitmap *bm, Estatisticas *est);
+
+/**
+ * @brief Descompacta um bloco gerado por compactaBloco.
+ * @param dados Bytes do bloco compactado.
+ * @param tamanho Quantidade de bytes compactados.
+ * @param saida Área que recebe os bytes originais.
+ * @param n Quantidade de bytes originais do bloco.
+ * @param tabela Tabela criada por criaTabelaDecodificacao, remontada com os
+ * códigos do bloco; quem descompacta vários blocos reaproveita a mesma.
+ * @param est Acumula os tempos das fases e o tamanho dos códigos.
+ * @return 0 em caso de sucesso, -1 se o bloco estiver corrompido (ou se
+ * faltar memória para aumentar a tabela).
+ */
+int descompactaBloco(const unsigned char *dados, size_t tamanho,
+                     unsigned char *saida, size_t n,
+                     TabelaDecodificacao *tabela, Estatisticas *est);
+
+/**
+ * @brief Compacta um bloco dividindo os seus bytes entre numFluxos fluxos
+ * intercalados (o byte i vai para o fluxo i % numFluxos), todos com a mesma
+ * tabela de códigos.
+ *
+ * O bloco começa com a quantidade de fluxos (1 byte) e uma tabela de saltos
+ * com a posição de início de cada fluxo (4 bytes cada, big-endian, a partir
+ * do início do bloco), seguida dos comprimentos dos códigos e dos fluxos,
+ * cada um alinhado ao byte. Como em compactaBloco, o bloco é armazenado se
+ * não ficaria menor.
+ *
+ * @param dados Bytes do bloco.
+ * @param n Quantidade de bytes.
+ * @param limiteBits Comprimento máximo dos códigos (0 = sem limite).
+ * @param numFluxos Quantidade de fluxos (1 a MAX_FLUXOS).
+ * @param bm Mapa de bits vazio que recebe o bloco compactado.
+ * @param est Acumula os tempos das fases, a entropia e o tamanho dos códigos
+ * (com e sem o limite).
+ * @return 0 em caso de sucesso, -1 se os bytes do bloco não couberem no
+ * limite de bits.
+ */
+int compactaBlocoIntercalado(const unsigned char *dados, size_t n,
+                             int limiteBits, int numFluxos, bitmap *bm,
+                             Estatisticas *est);
+
+/**
+ * @brief Descompacta um bloco gerado por compactaBlocoIntercalado.
+ * @param dados Bytes do bloco compactado.
+ * @param tamanho Quantidade de bytes compactados.
+ * @param saida Área que recebe os bytes originais.
+ * @param n Quantidade de bytes originais a decodificar (pode ser menor que o
+ * bloco, para decodificar só o seu início).
+ * @param tabela Tabela reaproveitada, como em descompactaBloco.
+ * @param est Acumula os tempos das fases e o tamanho dos códigos.
+ * @return 0 em caso de sucesso, -1 se o bloco estiver corrompido (ou se
+ * faltar memória para aumentar a tabela).
+ */
+int descompactaBlocoIntercalado(const unsigned char *dados, size_t tamanho,
+                                unsigned char *saida, size_t n,
+                                TabelaDecodificacao *tabela,
+                                Estatisticas *est);
+
+#endif // BLOCO_H
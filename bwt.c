@@ -0,0 +1,351 @@
+/*
+ *
+ * Transformada de Burrows-Wheeler
+ * Etapa em blocos que agrupa bytes de contextos parecidos: a transformada,
+ * pelo vetor de sufixos montado com o SA-IS em tempo linear, seguida do
+ * move-to-front e da codificação das corridas de zeros
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "bwt.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Cadeia ordenada pelo SA-IS. No primeiro nível são os bytes do bloco
+// somados de 1, com o sentinela 0 no fim; nos níveis seguintes, os nomes das
+// subcadeias LMS, cuja última é sempre o sentinela.
+typedef struct {
+  const unsigned char *bytes; // primeiro nível
+  const int32_t *nomes;       // níveis seguintes
+  int32_t n;                  // inclui o sentinela
+} Cadeia;
+
+static inline int32_t caractere(const Cadeia *s, int32_t i) {
+  if (s->bytes == NULL) {
+    return s->nomes[i];
+  }
+  return i == s->n - 1 ? 0 : (int32_t)s->bytes[i] + 1;
+}
+
+// tipo de cada sufixo, um bit por posição: S (1) se é menor que o sufixo
+// seguinte, L (0) se é maior
+static inline int ehTipoS(const unsigned char *tipos, int32_t i) {
+  return (tipos[i >> 3] >> (i & 7)) & 1;
+}
+
+// um sufixo S logo depois de um L (leftmost S)
+static inline int ehLMS(const unsigned char *tipos, int32_t i) {
+  return i > 0 && ehTipoS(tipos, i) && !ehTipoS(tipos, i - 1);
+}
+
+// início (fim = 0) ou fim (fim = 1) do balde de cada caractere, de 0 a k,
+// pela quantidade de cada um
+static void calculaBaldes(const int32_t *contagem, int32_t *baldes, int32_t k,
+                          int fim) {
+  int32_t soma = 0;
+  for (int32_t c = 0; c <= k; c++) {
+    soma += contagem[c];
+    baldes[c] = fim ? soma : soma - contagem[c];
+  }
+}
+
+// induz a ordem dos sufixos L, da esquerda para a direita, a partir dos que
+// já estão no vetor
+static void induzTipoL(const Cadeia *s, const unsigned char *tipos,
+                       int32_t *sa, const int32_t *contagem, int32_t *baldes,
+                       int32_t k) {
+  calculaBaldes(contagem, baldes, k, 0);
+  for (int32_t i = 0; i < s->n; i++) {
+    int32_t j = sa[i] - 1;
+    if (sa[i] > 0 && !ehTipoS(tipos, j)) {
+      sa[baldes[caractere(s, j)]++] = j;
+    }
+  }
+}
+
+// induz a ordem dos sufixos S, da direita para a esquerda
+static void induzTipoS(const Cadeia *s, const unsigned char *tipos,
+                       int32_t *sa, const int32_t *contagem, int32_t *baldes,
+                       int32_t k) {
+  calculaBaldes(contagem, baldes, k, 1);
+  for (int32_t i = s->n - 1; i >= 0; i--) {
+    int32_t j = sa[i] - 1;
+    if (sa[i] > 0 && ehTipoS(tipos, j)) {
+      sa[--baldes[caractere(s, j)]] = j;
+    }
+  }
+}
+
+// SA-IS (Nong, Zhang e Chan): ordena as subcadeias LMS por indução, dá a
+// cada uma um nome, ordena recursivamente a cadeia dos nomes quando eles se
+// repetem e induz a ordem final a partir dos sufixos LMS já ordenados. Os
+// caracteres vão de 0 a k, e a cadeia reduzida fica no fim do próprio vetor.
+static void ordenaSufixos(const Cadeia *s, int32_t *sa, int32_t k) {
+  int32_t n = s->n;
+  unsigned char *tipos = calloc(((size_t)n + 7) / 8, 1);
+  int32_t *contagem = calloc((size_t)k + 1, sizeof(int32_t));
+  int32_t *baldes = malloc(((size_t)k + 1) * sizeof(int32_t));
+  if (tipos == NULL || contagem == NULL || baldes == NULL) {
+    exit(1);
+  }
+  for (int32_t i = 0; i < n; i++) {
+    contagem[caractere(s, i)]++;
+  }
+
+  // o sentinela é S; cada sufixo é S se o caractere for menor que o
+  // seguinte, ou igual e o seguinte for S
+  tipos[(n - 1) >> 3] |= (unsigned char)(1u << ((n - 1) & 7));
+  for (int32_t i = n - 2; i >= 0; i--) {
+    int32_t a = caractere(s, i);
+    int32_t b = caractere(s, i + 1);
+    if (a < b || (a == b && ehTipoS(tipos, i + 1))) {
+      tipos[i >> 3] |= (unsigned char)(1u << (i & 7));
+    }
+  }
+
+  // etapa 1: os sufixos LMS no fim dos seus baldes, em qualquer ordem, e a
+  // indução ordena as subcadeias LMS
+  calculaBaldes(contagem, baldes, k, 1);
+  for (int32_t i = 0; i < n; i++) {
+    sa[i] = -1;
+  }
+  for (int32_t i = 1; i < n; i++) {
+    if (ehLMS(tipos, i)) {
+      sa[--baldes[caractere(s, i)]] = i;
+    }
+  }
+  induzTipoL(s, tipos, sa, contagem, baldes, k);
+  induzTipoS(s, tipos, sa, contagem, baldes, k);
+
+  // as subcadeias LMS ordenadas vão para o início do vetor
+  int32_t n1 = 0;
+  for (int32_t i = 0; i < n; i++) {
+    if (ehLMS(tipos, sa[i])) {
+      sa[n1++] = sa[i];
+    }
+  }
+
+  // subcadeias iguais recebem o mesmo nome, guardado na metade da posição
+  // (duas LMS nunca são vizinhas)
+  for (int32_t i = n1; i < n; i++) {
+    sa[i] = -1;
+  }
+  int32_t nome = 0;
+  int32_t anterior = -1;
+  for (int32_t i = 0; i < n1; i++) {
+    int32_t pos = sa[i];
+    int diferente = 0;
+    for (int32_t d = 0; d < n; d++) {
+      if (anterior < 0 || caractere(s, pos + d) != caractere(s, anterior + d) ||
+          ehTipoS(tipos, pos + d) != ehTipoS(tipos, anterior + d)) {
+        diferente = 1;
+        break;
+      }
+      if (d > 0 && (ehLMS(tipos, pos + d) || ehLMS(tipos, anterior + d))) {
+        break;
+      }
+    }
+    if (diferente) {
+      nome++;
+      anterior = pos;
+    }
+    sa[n1 + pos / 2] = nome - 1;
+  }
+  for (int32_t i = n - 1, j = n - 1; i >= n1; i--) {
+    if (sa[i] >= 0) {
+      sa[j--] = sa[i];
+    }
+  }
+
+  // etapa 2: ordena os sufixos da cadeia reduzida, recursivamente se algum
+  // nome se repete
+  int32_t *reduzida = sa + n - n1;
+  if (nome < n1) {
+    Cadeia s1 = {NULL, reduzida, n1};
+    ordenaSufixos(&s1, sa, nome - 1);
+  } else {
+    for (int32_t i = 0; i < n1; i++) {
+      sa[reduzida[i]] = i;
+    }
+  }
+
+  // etapa 3: os sufixos LMS, agora em ordem, voltam ao fim dos seus baldes
+  // e induzem a ordem de todos os outros
+  calculaBaldes(contagem, baldes, k, 1);
+  for (int32_t i = 1, j = 0; i < n; i++) {
+    if (ehLMS(tipos, i)) {
+      reduzida[j++] = i;
+    }
+  }
+  for (int32_t i = 0; i < n1; i++) {
+    sa[i] = reduzida[sa[i]];
+  }
+  for (int32_t i = n1; i < n; i++) {
+    sa[i] = -1;
+  }
+  for (int32_t i = n1 - 1; i >= 0; i--) {
+    int32_t j = sa[i];
+    sa[i] = -1;
+    sa[--baldes[caractere(s, j)]] = j;
+  }
+  induzTipoL(s, tipos, sa, contagem, baldes, k);
+  induzTipoS(s, tipos, sa, contagem, baldes, k);
+
+  free(tipos);
+  free(contagem);
+  free(baldes);
+}
+
+// posição em que começa o trecho k do bloco (k = NUM_TRECHOS_BWT é o fim)
+static inline uint32_t inicioTrecho(uint32_t n, int k) {
+  return (uint32_t)((uint64_t)n * (uint64_t)k / NUM_TRECHOS_BWT);
+}
+
+uint32_t transformaBWT(const unsigned char *dados, uint32_t n,
+                       unsigned char *saida, int32_t *sa, uint32_t linhas[]) {
+  Cadeia s = {dados, NULL, (int32_t)n + 1};
+  ordenaSufixos(&s, sa, 256);
+
+  // em blocos menores que a quantidade de trechos, alguns trechos começam
+  // na posição 0, cuja linha é a primária
+  uint32_t inicios[NUM_TRECHOS_BWT - 1];
+  for (int k = 1; k < NUM_TRECHOS_BWT; k++) {
+    inicios[k - 1] = inicioTrecho(n, k);
+  }
+
+  // a primeira linha é a do sufixo vazio, precedido pelo último byte; a
+  // linha do bloco inteiro seria precedida pelo sentinela, que fica de fora
+  uint32_t primario = 0;
+  unsigned char *p = saida;
+  *p++ = dados[n - 1];
+  for (uint32_t i = 1; i <= n; i++) {
+    uint32_t pos = (uint32_t)sa[i];
+    if (pos == 0) {
+      primario = i;
+    } else {
+      *p++ = dados[pos - 1];
+    }
+    for (int k = 0; k < NUM_TRECHOS_BWT - 1; k++) {
+      if (pos == inicios[k]) {
+        linhas[k] = i;
+      }
+    }
+  }
+
+  return primario;
+}
+
+int desfazBWT(const unsigned char *bwt, uint32_t n, uint32_t primario,
+              const uint32_t linhas[], uint32_t *vetor, unsigned char *saida) {
+  if (primario == 0 || primario > n) {
+    return -1;
+  }
+  for (int k = 0; k < NUM_TRECHOS_BWT - 1; k++) {
+    if (linhas[k] > n) {
+      return -1;
+    }
+  }
+
+  // primeira linha de cada byte na primeira coluna; a linha 0 é a do
+  // sentinela
+  uint32_t linha[256] = {0};
+  for (uint32_t i = 0; i < n; i++) {
+    linha[bwt[i]]++;
+  }
+  uint32_t soma = 1;
+  for (int c = 0; c < 256; c++) {
+    uint32_t quantidade = linha[c];
+    linha[c] = soma;
+    soma += quantidade;
+  }
+
+  // cada linha guarda a linha da rotação que começa no seu último byte e o
+  // próprio byte; a linha primária (do sentinela) não é visitada
+  for (uint32_t r = 0; r < primario; r++) {
+    unsigned char c = bwt[r];
+    vetor[r] = (linha[c]++ << 8) | c;
+  }
+  vetor[primario] = 0;
+  for (uint32_t r = primario + 1; r <= n; r++) {
+    unsigned char c = bwt[r - 1];
+    vetor[r] = (linha[c]++ << 8) | c;
+  }
+
+  // cada passo recua um byte no bloco; o último trecho parte da linha do
+  // sufixo vazio e os outros da linha em que começa o trecho seguinte. Os
+  // trechos têm o mesmo tamanho, a menos de um byte, e as cadeias andam
+  // juntas até o tamanho do menor.
+  uint32_t atual[NUM_TRECHOS_BWT]; // linha de cada cadeia
+  uint32_t pos[NUM_TRECHOS_BWT];   // próximo byte de cada trecho, mais um
+  for (int k = 0; k < NUM_TRECHOS_BWT; k++) {
+    atual[k] = k < NUM_TRECHOS_BWT - 1 ? linhas[k] : 0;
+    pos[k] = inicioTrecho(n, k + 1);
+  }
+  uint32_t passos = n / NUM_TRECHOS_BWT;
+  for (uint32_t i = 0; i < passos; i++) {
+    for (int k = 0; k < NUM_TRECHOS_BWT; k++) {
+      uint32_t v = vetor[atual[k]];
+      saida[--pos[k]] = (unsigned char)v;
+      atual[k] = v >> 8;
+    }
+  }
+  for (int k = 0; k < NUM_TRECHOS_BWT; k++) {
+    for (uint32_t fim = inicioTrecho(n, k); pos[k] > fim;) {
+      uint32_t v = vetor[atual[k]];
+      saida[--pos[k]] = (unsigned char)v;
+      atual[k] = v >> 8;
+    }
+  }
+
+  return 0;
+}
+
+// escreve uma corrida de zeros em base 2 bijetiva
+static size_t escreveCorrida(uint16_t simbolos[], size_t k, uint32_t corrida,
+                             uint64_t frequencias[]) {
+  while (corrida > 0) {
+    corrida--;
+    uint16_t digito = (corrida & 1) ? CORRIDA_B : CORRIDA_A;
+    simbolos[k++] = digito;
+    frequencias[digito]++;
+    corrida >>= 1;
+  }
+  return k;
+}
+
+size_t codificaMTF(const unsigned char *bwt, uint32_t n, uint16_t simbolos[],
+                   uint64_t frequencias[]) {
+  unsigned char ordem[256];
+  for (int c = 0; c < 256; c++) {
+    ordem[c] = (unsigned char)c;
+  }
+
+  size_t k = 0;
+  uint32_t corrida = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    unsigned char c = bwt[i];
+    if (ordem[0] == c) {
+      corrida++;
+      continue;
+    }
+    k = escreveCorrida(simbolos, k, corrida, frequencias);
+    corrida = 0;
+
+    // o byte vai para a frente da lista, e a sua posição anterior é o
+    // símbolo
+    unsigned int j = 1;
+    while (ordem[j] != c) {
+      j++;
+    }
+    memmove(ordem + 1, ordem, j);
+    ordem[0] = c;
+    simbolos[k++] = (uint16_t)(j + 1);
+    frequencias[j + 1]++;
+  }
+  k = escreveCorrida(simbolos, k, corrida, frequencias);
+
+  simbolos[k++] = FIM_BLOCO_BWT;
+  frequencias[FIM_BLOCO_BWT]++;
+  return k;
+}
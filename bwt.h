@@ -0,0 +1,92 @@
+/*
+ *
+ * Transformada de Burrows-Wheeler
+ * Etapa em blocos que agrupa bytes de contextos parecidos: a transformada,
+ * pelo vetor de sufixos montado com o SA-IS em tempo linear, seguida do
+ * move-to-front e da codificação das corridas de zeros
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef BWT_H
+#define BWT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// versão com a etapa BWT: assinatura, versão, tamanho máximo dos blocos em
+// 32 bits e os blocos, terminados por um bloco de tamanho 0. Cada bloco tem
+// o tamanho em 32 bits e o tipo em 2 bits, seguidos do índice primário, das
+// linhas iniciais dos trechos, dos comprimentos e dos códigos até
+// FIM_BLOCO_BWT (transformado), dos comprimentos e dos códigos dos bytes
+// (direto) ou dos bytes alinhados (armazenado)
+#define VERSAO_BWT 10
+
+// a volta da transformada guarda a próxima linha e o byte em uma palavra de
+// 32 bits, então as linhas do bloco (tamanho + 1) precisam caber em 24 bits
+#define TAMANHO_BLOCO_BWT_MINIMO ((uint32_t)1024)
+#define TAMANHO_BLOCO_BWT_MAXIMO ((uint32_t)8 * 1024 * 1024)
+
+// A volta da transformada segue uma cadeia de linhas, cada passo um acesso
+// fora da cache. O bloco é dividido em trechos, cada um desfeito a partir da
+// sua própria linha inicial, e as cadeias dos trechos andam juntas.
+#define NUM_TRECHOS_BWT 4
+
+// cada bloco escolhe a forma mais curta: a etapa inteira, o Huffman direto
+// dos bytes (quando não há contexto a aproveitar) ou os bytes sem
+// compactação
+#define BLOCO_BWT_TRANSFORMADO 0
+#define BLOCO_BWT_DIRETO 1
+#define BLOCO_BWT_ARMAZENADO 2
+
+// Alfabeto dos blocos transformados: as corridas de zeros do move-to-front
+// são escritas em base 2 bijetiva com os dígitos CORRIDA_A (1) e CORRIDA_B
+// (2), do menos significativo para o mais; as posições de 1 a 255 viram os
+// símbolos de 2 a 256, e o último símbolo encerra o bloco
+#define CORRIDA_A 0
+#define CORRIDA_B 1
+#define FIM_BLOCO_BWT 257
+#define NUM_SIMBOLOS_BWT 258
+
+/**
+ * @brief Aplica a transformada a um bloco: a última coluna das rotações do
+ * bloco com um sentinela no fim, menor que todos os bytes, sem o sentinela.
+ * @param dados Bytes do bloco.
+ * @param n Tamanho do bloco (1 a TAMANHO_BLOCO_BWT_MAXIMO).
+ * @param saida Recebe os n bytes transformados.
+ * @param sa Área de trabalho para o vetor de sufixos, com n + 1 posições.
+ * @param linhas Recebe, para cada trecho a partir do segundo, a linha da
+ * rotação que começa nele (NUM_TRECHOS_BWT - 1 posições).
+ * @return A linha do sentinela (índice primário), de 1 a n.
+ */
+uint32_t transformaBWT(const unsigned char *dados, uint32_t n,
+                       unsigned char *saida, int32_t *sa, uint32_t linhas[]);
+
+/**
+ * @brief Desfaz a transformada.
+ * @param bwt Bytes transformados.
+ * @param n Tamanho do bloco.
+ * @param primario Índice primário devolvido por transformaBWT.
+ * @param linhas Linhas iniciais dos trechos devolvidas por transformaBWT.
+ * @param vetor Área de trabalho com n + 1 posições.
+ * @param saida Recebe os n bytes originais.
+ * @return 0 em caso de sucesso, -1 se alguma linha for inválida.
+ */
+int desfazBWT(const unsigned char *bwt, uint32_t n, uint32_t primario,
+              const uint32_t linhas[], uint32_t *vetor, unsigned char *saida);
+
+/**
+ * @brief Passa os bytes transformados pelo move-to-front e troca as
+ * corridas de zeros pelos dígitos CORRIDA_A e CORRIDA_B.
+ * @param bwt Bytes transformados.
+ * @param n Quantidade de bytes.
+ * @param simbolos Recebe os símbolos, terminados por FIM_BLOCO_BWT (no
+ * máximo n + 1).
+ * @param frequencias Vetor com NUM_SIMBOLOS_BWT posições, acumulado (não é
+ * zerado).
+ * @return Quantidade de símbolos.
+ */
+size_t codificaMTF(const unsigned char *bwt, uint32_t n, uint16_t simbolos[],
+                   uint64_t frequencias[]);
+
+#endif // BWT_H
@@ -7,213 +7,1384 @@
  */
 
 #include "compactador.h"
+#include "adaptativo.h"
+#include "arquivo.h"
 #include "arvore.h"
 #include "bitmap.h"
-#include "lista.h"
+#include "bloco.h"
+#include "bwt.h"
+#include "contexto.h"
+#include "dicionario.h"
+#include "escritor.h"
+#include "estatisticas.h"
+#include "histograma.h"
+#include "huffman.h"
+#include "lz77.h"
+#include "pool.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+// o modo de fluxo único percorre a entrada nestes pedaços: as páginas já
+// lidas são devolvidas ao sistema e a saída é gravada a cada pedaço, então a
+// memória não cresce com o tamanho do arquivo
+#define TAMANHO_PEDACO_SEQUENCIAL ((size_t)4 * 1024 * 1024)
 
 struct compactador {
   char *arqEntrada;
   char *arqSaida;
-  int frequencias[256];
+  ArquivoMapeado *entrada; // aberto uma vez e usado por todas as passadas
+  uint64_t frequencias[NUM_SIMBOLOS];
+  int limiteBits; // 0 = sem limite para o comprimento dos códigos
+  size_t tamanhoBloco; // 0 = arquivo inteiro em um único fluxo
+  int numThreads;
+  int numFluxos; // fluxos intercalados por bloco (0 ou 1 = um único fluxo)
+  int adaptativo; // Huffman adaptativo, em uma única passada
+  ModeloAdaptativo *modelo;
+  int contexto; // modelo de contexto de ordem 1
+  uint64_t (*frequenciasContexto)[NUM_SIMBOLOS]; // um histograma por contexto
+  int numTabelas;
+  unsigned char grupoContexto[NUM_CONTEXTOS]; // tabela de cada contexto
+  unsigned char comprimentosContexto[MAX_TABELAS_CONTEXTO][NUM_SIMBOLOS];
+  CodigoHuffman tabelasContexto[MAX_TABELAS_CONTEXTO][NUM_SIMBOLOS];
+  const CodigoHuffman *tabelaDoContexto[NUM_CONTEXTOS];
+  const Dicionario *dicionario; // tabela treinada: sem árvore nem cabeçalho
+  int nivelLZ; // esforço da etapa LZ77 (0 = sem a etapa)
+  BuscadorLZ *buscador; // cadeias de hash, reaproveitadas entre arquivos
+  size_t tamanhoBlocoBWT; // blocos da etapa BWT (0 = sem a etapa)
+  Estatisticas est;
+  Cronometro cronometro; // marca o fim da última fase medida
+  ArenaArvore *arena; // guarda todos os nós da árvore
   Arvore *arvore;
-  char *tabelaCodigos[257];
+  bitmap *bm; // saída do modo de fluxo único, reaproveitada entre arquivos
+  unsigned char comprimentos[NUM_SIMBOLOS];
+  CodigoHuffman tabelaCodigos[NUM_SIMBOLOS];
 };
 
 static void contaFrequencia(Compactador *c) {
+  const unsigned char *dados = dadosArquivoMapeado(c->entrada);
+  uint64_t tamanho = tamanhoArquivoMapeado(c->entrada);
 
-  // le o arquivo em modo read binary
-  FILE *arq = fopen(c->arqEntrada, "rb");
-
-  if (arq == NULL) {
-    exit(1);
+  // calcula a frequencia de todos os caracteres direto na entrada mapeada
+  unsigned char anterior = 0;
+  for (uint64_t inicio = 0; inicio < tamanho;
+       inicio += TAMANHO_PEDACO_SEQUENCIAL) {
+    size_t n = tamanho - inicio < TAMANHO_PEDACO_SEQUENCIAL
+                   ? (size_t)(tamanho - inicio)
+                   : TAMANHO_PEDACO_SEQUENCIAL;
+    if (c->contexto && c->dicionario == NULL) {
+      contaBytesContexto(dados + inicio, n, &anterior,
+                         c->frequenciasContexto);
+    } else {
+      contaBytes(dados + inicio, n, c->frequencias);
+    }
+    descartaTrechoMapeado(c->entrada, inicio, n);
   }
 
-  // calcula a frequencia de todos os caracteres
-  int caractere;
-  while ((caractere = fgetc(arq)) != EOF) {
-    c->frequencias[caractere]++;
+  // no modelo de contexto, o EOF vem depois do último byte
+  if (c->contexto && c->dicionario == NULL) {
+    c->frequenciasContexto[anterior][SIMBOLO_EOF] = 1;
   }
+  marcaFase(&c->est, FASE_CONTAGEM, &c->cronometro);
+}
 
-  fclose(arq);
+// tamanho em bits dos códigos do dicionário para o histograma dado
+static uint64_t bitsDoDicionario(Compactador *c,
+                                 const uint64_t frequencias[]) {
+  const CodigoHuffman *tabela = codigosDicionario(c->dicionario);
+  uint64_t total = 0;
+  for (int s = 0; s < NUM_SIMBOLOS; s++) {
+    total += frequencias[s] * tabela[s].comprimento;
+  }
+  return total;
 }
 
 static void constroiArvoreHuffman(Compactador *c) {
+  // criação do nó "end of file" para o descompactador saber quando parar
+  c->frequencias[SIMBOLO_EOF] = 1;
 
-  Lista *listaPrioridade = criaLista();
+  // armazena o nó raiz no compactador; a arena é reaproveitada quando o
+  // compactador é usado para vários arquivos
+  if (c->arena == NULL) {
+    c->arena = criaArenaArvore(2 * NUM_SIMBOLOS - 1);
+  } else {
+    reiniciaArenaArvore(c->arena);
+  }
+  c->arvore =
+      constroiArvoreDeFrequencias(c->frequencias, NUM_SIMBOLOS, c->arena);
+}
 
-  // Cria nós folhas pra cada caractere e insere em uma lista
-  for (int i = 0; i < 256; i++) {
-    if (c->frequencias[i] > 0) {
-      Arvore *no = criaNoFolha(i, c->frequencias[i]);
-      insereItemOrdenado(listaPrioridade, no, comparaFrequencia);
-    }
+// retorna -1 se os símbolos não couberem no limite de bits
+static int geraTabelaCodigos(Compactador *c) {
+  // da árvore só interessa a profundidade de cada folha: os códigos em si são
+  // atribuídos de forma canônica, e o descompactador refaz a mesma atribuição
+  // só com os comprimentos
+  int maior = calculaComprimentos(c->arvore, c->comprimentos, NUM_SIMBOLOS);
+
+  c->est.bitsSemLimite =
+      calculaBitsCodificados(c->frequencias, c->comprimentos, NUM_SIMBOLOS);
+
+  // se a árvore passou do limite, refaz os comprimentos pelo package-merge
+  if (aplicaLimiteComprimentos(c->frequencias, NUM_SIMBOLOS, c->limiteBits,
+                               maior, c->comprimentos) != 0) {
+    return -1;
   }
+  c->est.bitsComLimite =
+      calculaBitsCodificados(c->frequencias, c->comprimentos, NUM_SIMBOLOS);
+  acumulaEntropia(&c->est, c->frequencias, NUM_SIMBOLOS);
+  registraComprimentos(&c->est, c->comprimentos, NUM_SIMBOLOS);
+  marcaFase(&c->est, FASE_ARVORE, &c->cronometro);
 
-  // criação do nó "end of file" para o descompactador saber quando parar
-  Arvore *eof = criaNoFolha(256, 1);
-  insereItemOrdenado(listaPrioridade, eof, comparaFrequencia);
+  if (montaTabelaCodigos(c->comprimentos, NUM_SIMBOLOS, c->tabelaCodigos) !=
+      0) {
+    return -1;
+  }
+  marcaFase(&c->est, FASE_TABELA, &c->cronometro);
 
-  int qntdLista = getQuantidadeItemsLista(listaPrioridade);
-  // cria nós internos até sobrar o nó raiz
-  while (qntdLista > 1) {
-    // remove os dois primeiros itens da lista
-    Arvore *noEsquerdo = removePrimeiroItem(listaPrioridade);
-    Arvore *noDireito = removePrimeiroItem(listaPrioridade);
+  return 0;
+}
 
-    // cria nó interno e reinsere na lista
-    Arvore *interno = criaNoInterno(noEsquerdo, noDireito);
-    insereItemOrdenado(listaPrioridade, interno, comparaFrequencia);
+// modelo de contexto: agrupa os contextos e monta uma tabela de códigos por
+// grupo, com o histograma somado dos seus contextos; retorna -1 se os
+// símbolos de algum grupo não couberem no limite de bits
+static int geraTabelasContexto(Compactador *c) {
+  c->numTabelas = agrupaContextos(c->frequenciasContexto, c->grupoContexto);
 
-    // retira 2 itens e adiciona 1
-    qntdLista--;
+  if (c->arena == NULL) {
+    c->arena = criaArenaArvore(2 * NUM_SIMBOLOS - 1);
   }
 
-  // armazena o nó raiz no compactador
-  c->arvore = removePrimeiroItem(listaPrioridade);
+  for (int t = 0; t < c->numTabelas; t++) {
+    uint64_t soma[NUM_SIMBOLOS] = {0};
+    for (int ctx = 0; ctx < NUM_CONTEXTOS; ctx++) {
+      if (c->grupoContexto[ctx] == t) {
+        for (int s = 0; s < NUM_SIMBOLOS; s++) {
+          soma[s] += c->frequenciasContexto[ctx][s];
+        }
+      }
+    }
 
-  liberaLista(listaPrioridade, NULL);
+    reiniciaArenaArvore(c->arena);
+    Arvore *arvore = constroiArvoreDeFrequencias(soma, NUM_SIMBOLOS, c->arena);
+    unsigned char *comprimentos = c->comprimentosContexto[t];
+    int maior = calculaComprimentos(arvore, comprimentos, NUM_SIMBOLOS);
+
+    c->est.bitsSemLimite +=
+        calculaBitsCodificados(soma, comprimentos, NUM_SIMBOLOS);
+    if (aplicaLimiteComprimentos(soma, NUM_SIMBOLOS, c->limiteBits, maior,
+                                 comprimentos) != 0) {
+      return -1;
+    }
+    c->est.bitsComLimite +=
+        calculaBitsCodificados(soma, comprimentos, NUM_SIMBOLOS);
+    registraComprimentos(&c->est, comprimentos, NUM_SIMBOLOS);
+
+    if (montaTabelaCodigos(comprimentos, NUM_SIMBOLOS,
+                           c->tabelasContexto[t]) != 0) {
+      return -1;
+    }
+  }
+
+  // a entropia de ordem 1: cada contexto com o seu próprio histograma
+  for (int ctx = 0; ctx < NUM_CONTEXTOS; ctx++) {
+    acumulaEntropia(&c->est, c->frequenciasContexto[ctx], NUM_SIMBOLOS);
+    c->tabelaDoContexto[ctx] = c->tabelasContexto[c->grupoContexto[ctx]];
+  }
+  marcaFase(&c->est, FASE_ARVORE, &c->cronometro);
+
+  return 0;
 }
 
-void encontraCaminho(Arvore *noAtual, char caminhoTemporario[],
-                     int profundidade, char *tabelaFinal[]) {
-  // se for nó folha
-  if (ehNoFolha(noAtual)) {
-    int caractere = getCaractere(noAtual);
-    // adiciona um terminador de string na posição atual
-    caminhoTemporario[profundidade] = '\0';
-    // copia o caminho para o array de endereços
-    tabelaFinal[caractere] = strdup(caminhoTemporario);
+static void escreveCabecalho(Compactador *c, bitmap *bm) {
+  // assinatura e versão do formato
+  bitmapAppendBits(bm, ASSINATURA_FORMATO, 32);
+
+  if (c->dicionario != NULL) {
+    // a tabela fica no dicionário; só o identificador dele vai no arquivo
+    bitmapAppendBits(bm, VERSAO_DICIONARIO, 8);
+    bitmapAppendBits(bm, identificadorDicionario(c->dicionario), 32);
     return;
-  } else {
-    caminhoTemporario[profundidade] = '0';
-    encontraCaminho(getEsquerda(noAtual), caminhoTemporario, profundidade + 1,
-                    tabelaFinal);
-    caminhoTemporario[profundidade] = '1';
-    encontraCaminho(getDireita(noAtual), caminhoTemporario, profundidade + 1,
-                    tabelaFinal);
   }
-};
 
-static void geraTabelaCodigos(Compactador *c) {
-  // buffer temporario pra armazenar o codigo binario
-  char caminhoTemporario[257];
-  for (int i = 0; i < 257; i++) {
-    c->tabelaCodigos[i] = NULL;
+  if (c->contexto) {
+    // o mapa dos contextos e os comprimentos de cada tabela
+    bitmapAppendBits(bm, VERSAO_CONTEXTO, 8);
+    escreveMapaContextos(bm, c->grupoContexto, c->numTabelas);
+    for (int t = 0; t < c->numTabelas; t++) {
+      escreveComprimentos(bm, c->comprimentosContexto[t], NUM_SIMBOLOS);
+    }
+    return;
+  }
+
+  bitmapAppendBits(bm, VERSAO_CANONICA, 8);
+
+  // só os comprimentos dos códigos, já que eles são canônicos
+  escreveComprimentos(bm, c->comprimentos, NUM_SIMBOLOS);
+}
+
+// grava os bytes completos do mapa e os tira dele; o último byte, ainda
+// incompleto, continua no mapa para receber os próximos bits
+static int gravaBytesCompletos(Compactador *c, bitmap *bm, int arqSaida,
+                               uint64_t *posicao) {
+  uint64_t completos = bitmapGetLength(bm) / 8;
+  if (escreveNaPosicao(arqSaida, bitmapGetContents(bm), (size_t)completos,
+                       *posicao) != 0) {
+    return -1;
   }
+  bitmapDescartaBytes(bm, completos);
+  *posicao += completos;
+  marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
+  return 0;
+}
+
+// codifica cada byte com a tabela do contexto dado pelo byte anterior
+static void codificaComContexto(Compactador *c, EscritorBits *e,
+                                const unsigned char *dados, size_t n,
+                                unsigned char *anterior) {
+  const CodigoHuffman *tabela = c->tabelaDoContexto[*anterior];
+  for (size_t i = 0; i < n; i++) {
+    escreveCodigo(e, tabela[dados[i]].codigo, tabela[dados[i]].comprimento);
+    tabela = c->tabelaDoContexto[dados[i]];
+  }
+  if (n > 0) {
+    *anterior = dados[n - 1];
+  }
+}
 
-  // percorre a árvore e encontra os caminhos para preencher a tabela de códigos
-  encontraCaminho(c->arvore, caminhoTemporario, 0, c->tabelaCodigos);
+// o histograma já dá o tamanho dos códigos: se o cabeçalho, já no mapa, e
+// os códigos não deixariam o arquivo menor, a entrada é só copiada
+static int compensaCompactar(Compactador *c, bitmap *bm, uint64_t tamanho) {
+  return (bitmapGetLength(bm) + c->est.bitsComLimite + 7) / 8 < tamanho + 5;
 }
 
-static void escreveCabecalho(Arvore *a, bitmap *bm) {
-  if (ehNoFolha(a)) {
-    // escreve 1 para indicar nó folha
-    bitmapAppendLeastSignificantBit(bm, 1);
+// grava a assinatura, a versão sem compactação e a entrada como está, em
+// pedaços tirados direto da entrada mapeada
+static int escreveArquivoArmazenado(Compactador *c, int arqSaida) {
+  const unsigned char *dados = dadosArquivoMapeado(c->entrada);
+  uint64_t tamanho = tamanhoArquivoMapeado(c->entrada);
+
+  bitmap *bm = c->bm;
+  bitmapReinicia(bm);
+  bitmapAppendBits(bm, ASSINATURA_FORMATO, 32);
+  bitmapAppendBits(bm, VERSAO_ARMAZENADA, 8);
+  uint64_t posicao = 0;
+  if (gravaBytesCompletos(c, bm, arqSaida, &posicao) != 0) {
+    return -1;
+  }
+
+  for (uint64_t inicio = 0; inicio < tamanho;
+       inicio += TAMANHO_PEDACO_SEQUENCIAL) {
+    size_t n = tamanho - inicio < TAMANHO_PEDACO_SEQUENCIAL
+                   ? (size_t)(tamanho - inicio)
+                   : TAMANHO_PEDACO_SEQUENCIAL;
+    if (escreveNaPosicao(arqSaida, dados + inicio, n, posicao) != 0) {
+      return -1;
+    }
+    descartaTrechoMapeado(c->entrada, inicio, n);
+    posicao += n;
+  }
+  marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
 
-    int caractere = getCaractere(a);
-    // se é o EOF
-    if (caractere == 256) {
-      // escreve 1 para indicar o EOF
-      bitmapAppendLeastSignificantBit(bm, 1);
+  c->est.bytesSaida = posicao;
+  return 0;
+}
+
+static int escreveArquivoCompactado(Compactador *c) {
+  const unsigned char *dados = dadosArquivoMapeado(c->entrada);
+  uint64_t tamanhoArquivoBytes = tamanhoArquivoMapeado(c->entrada);
+
+  int arqSaida = criaArquivoSaida(c->arqSaida);
+  if (arqSaida < 0) {
+    return -1;
+  }
+
+  // o mapa só guarda um pedaço da saída por vez: cada byte da entrada gera
+  // no máximo um código de 8 bits quando a distribuição é plana, e o mapa
+  // cresce sozinho nos raros pedaços em que os códigos são maiores
+  if (c->bm == NULL) {
+    c->bm = bitmapInit(((uint64_t)TAMANHO_PEDACO_SEQUENCIAL + 512) * 8);
+  }
+  bitmap *bm = c->bm;
+  bitmapReinicia(bm);
+  uint64_t posicao = 0;
+  int resultado = 0;
+
+  escreveCabecalho(c, bm);
+  marcaFase(&c->est, FASE_CABECALHO, &c->cronometro);
+
+  if (!compensaCompactar(c, bm, tamanhoArquivoBytes)) {
+    resultado = escreveArquivoArmazenado(c, arqSaida);
+    if (close(arqSaida) != 0) {
+      resultado = -1;
+    }
+    return resultado;
+  }
+
+  // percorre a entrada de novo, agora escrevendo o código de cada caractere
+  // no bitmap, juntando os bits em palavras antes de passá-los adiante
+  EscritorBits escritor;
+  iniciaEscritor(&escritor, bm);
+  unsigned char anterior = 0;
+  int comContexto = c->contexto && c->dicionario == NULL;
+
+  for (uint64_t inicio = 0; inicio < tamanhoArquivoBytes;
+       inicio += TAMANHO_PEDACO_SEQUENCIAL) {
+    size_t n = tamanhoArquivoBytes - inicio < TAMANHO_PEDACO_SEQUENCIAL
+                   ? (size_t)(tamanhoArquivoBytes - inicio)
+                   : TAMANHO_PEDACO_SEQUENCIAL;
+    const unsigned char *pedaco = dados + inicio;
+    if (comContexto) {
+      codificaComContexto(c, &escritor, pedaco, n, &anterior);
     } else {
-      // escreve 0 para indicar caractere normal
-      bitmapAppendLeastSignificantBit(bm, 0);
-      // escreve os 8 bits do caractere
-      for (int i = 7; i >= 0; i--) {
-        bitmapAppendLeastSignificantBit(bm, (caractere >> i) & 1);
+      for (size_t i = 0; i < n; i++) {
+        escreveCodigo(&escritor, c->tabelaCodigos[pedaco[i]].codigo,
+                      c->tabelaCodigos[pedaco[i]].comprimento);
+      }
+    }
+    finalizaEscritor(&escritor);
+    descartaTrechoMapeado(c->entrada, inicio, n);
+    marcaFase(&c->est, FASE_CODIFICACAO, &c->cronometro);
+
+    if (gravaBytesCompletos(c, bm, arqSaida, &posicao) != 0) {
+      close(arqSaida);
+      return -1;
+    }
+  }
+
+  // escreve o eof no final
+  const CodigoHuffman *tabela =
+      comContexto ? c->tabelaDoContexto[anterior] : c->tabelaCodigos;
+  escreveCodigo(&escritor, tabela[SIMBOLO_EOF].codigo,
+                tabela[SIMBOLO_EOF].comprimento);
+  finalizaEscritor(&escritor);
+  marcaFase(&c->est, FASE_CODIFICACAO, &c->cronometro);
+
+  // completa o último byte com zeros e o grava junto com o resto
+  bitmapAppendBits(bm, 0, (8 - bitmapGetLength(bm) % 8) % 8);
+  resultado = gravaBytesCompletos(c, bm, arqSaida, &posicao);
+
+  if (close(arqSaida) != 0) {
+    resultado = -1;
+  }
+  c->est.bytesSaida = posicao;
+  return resultado;
+}
+
+// comprimentos e códigos de um alfabeto das etapas LZ77 e BWT, somando os
+// bits dos códigos às estimativas; um alfabeto sem nenhum símbolo fica com
+// todos os comprimentos zerados. Retorna -1 se os símbolos não couberem no
+// limite de bits.
+static int geraCodigosDoAlfabeto(Compactador *c, const uint64_t frequencias[],
+                                 int n, unsigned char comprimentos[],
+                                 CodigoHuffman tabela[],
+                                 uint64_t *bitsSemLimite,
+                                 uint64_t *bitsComLimite) {
+  // como nos blocos, os comprimentos saem direto das frequências, só com
+  // áreas na pilha: nada é alocado a cada bloco
+  int maior = calculaComprimentosDeFrequencias(frequencias, n, comprimentos);
+  if (maior == 0) {
+    return 0;
+  }
+
+  *bitsSemLimite += calculaBitsCodificados(frequencias, comprimentos, n);
+  if (aplicaLimiteComprimentos(frequencias, n, c->limiteBits, maior,
+                               comprimentos) != 0 ||
+      montaTabelaCodigos(comprimentos, n, tabela) != 0) {
+    return -1;
+  }
+  *bitsComLimite += calculaBitsCodificados(frequencias, comprimentos, n);
+
+  return 0;
+}
+
+// escreve o código de uma classe de comprimento ou distância e os bits que
+// completam o valor
+static inline void escreveClasseLZ(EscritorBits *e, const CodigoHuffman *codigo,
+                                   unsigned int classe, uint32_t valor) {
+  escreveCodigo(e, codigo->codigo, codigo->comprimento);
+  unsigned int extras = bitsExtrasDaClasse(classe);
+  if (extras > 0) {
+    escreveCodigo(e, valor - baseDaClasse(classe), extras);
+  }
+}
+
+// Um bloco da etapa LZ77: os bytes do bloco viram sequências de literais e
+// cópias, e os literais com as classes de comprimento e as classes de
+// distância recebem cada um a sua tabela de códigos. Como na etapa BWT, o
+// bloco sai com o Huffman direto dos bytes se as cópias não compensarem, ou
+// sem compactação se nem isso o deixar menor. Retorna -1 se os símbolos não
+// couberem no limite de bits.
+static int escreveBlocoLZ(Compactador *c, EscritorBits *e,
+                          const unsigned char *dados, uint64_t inicio,
+                          size_t n) {
+  // o histograma dos bytes dá o custo dos literais na análise e o tamanho
+  // do Huffman direto, para a comparação
+  uint64_t frequenciasBytes[256] = {0};
+  contaBytes(dados + inicio, n, frequenciasBytes);
+  size_t numSequencias;
+  const SequenciaLZ *seq = analisaLZ(c->buscador, dados, inicio, inicio + n,
+                                     frequenciasBytes, &numSequencias);
+
+  uint64_t frequenciasLiterais[NUM_LITERAIS_LZ] = {0};
+  uint64_t frequenciasDistancias[NUM_DISTANCIAS_LZ] = {0};
+  uint64_t bitsExtras = 0;
+  const unsigned char *p = dados + inicio;
+  for (size_t i = 0; i < numSequencias; i++) {
+    for (uint32_t j = 0; j < seq[i].literais; j++) {
+      frequenciasLiterais[p[j]]++;
+    }
+    p += seq[i].literais;
+    if (seq[i].comprimento > 0) {
+      unsigned int classe =
+          classeDoValor(seq[i].comprimento - COMPRIMENTO_MINIMO_LZ);
+      unsigned int classeDistancia = classeDoValor(seq[i].distancia - 1);
+      frequenciasLiterais[PRIMEIRO_COMPRIMENTO_LZ + classe]++;
+      frequenciasDistancias[classeDistancia]++;
+      bitsExtras +=
+          bitsExtrasDaClasse(classe) + bitsExtrasDaClasse(classeDistancia);
+      p += seq[i].comprimento;
+    }
+  }
+  frequenciasLiterais[SIMBOLO_EOF] = 1;
+  marcaFase(&c->est, FASE_CONTAGEM, &c->cronometro);
+
+  // os cabeçalhos têm tamanhos parecidos e ficam fora da comparação
+  unsigned char comprimentosLiterais[NUM_LITERAIS_LZ];
+  unsigned char comprimentosDistancias[NUM_DISTANCIAS_LZ];
+  CodigoHuffman literais[NUM_LITERAIS_LZ];
+  CodigoHuffman distancias[NUM_DISTANCIAS_LZ];
+  uint64_t bitsSemLimite = bitsExtras;
+  uint64_t bitsComLimite = bitsExtras;
+  unsigned char comprimentosBytes[256];
+  CodigoHuffman tabelaBytes[256];
+  uint64_t bitsSemLimiteBytes = 0;
+  uint64_t bitsComLimiteBytes = 0;
+  if (geraCodigosDoAlfabeto(c, frequenciasLiterais, NUM_LITERAIS_LZ,
+                            comprimentosLiterais, literais, &bitsSemLimite,
+                            &bitsComLimite) != 0 ||
+      geraCodigosDoAlfabeto(c, frequenciasDistancias, NUM_DISTANCIAS_LZ,
+                            comprimentosDistancias, distancias,
+                            &bitsSemLimite, &bitsComLimite) != 0 ||
+      geraCodigosDoAlfabeto(c, frequenciasBytes, 256, comprimentosBytes,
+                            tabelaBytes, &bitsSemLimiteBytes,
+                            &bitsComLimiteBytes) != 0) {
+    return -1;
+  }
+  for (int s = 0; s < 256; s++) {
+    c->frequencias[s] += frequenciasBytes[s];
+  }
+  marcaFase(&c->est, FASE_ARVORE, &c->cronometro);
+
+  int tipo = BLOCO_LZ_COPIAS;
+  if (bitsComLimiteBytes <= bitsComLimite) {
+    tipo = BLOCO_LZ_DIRETO;
+    bitsSemLimite = bitsSemLimiteBytes;
+    bitsComLimite = bitsComLimiteBytes;
+  }
+  if (bitsComLimite >= (uint64_t)n * 8) {
+    tipo = BLOCO_LZ_ARMAZENADO;
+    bitsSemLimite = bitsComLimite = (uint64_t)n * 8;
+  }
+  c->est.bitsSemLimite += bitsSemLimite;
+  c->est.bitsComLimite += bitsComLimite;
+
+  bitmap *bm = e->bm;
+  escreveCodigo(e, n, 32);
+  escreveCodigo(e, tipo, 2);
+  if (tipo == BLOCO_LZ_ARMAZENADO) {
+    finalizaEscritor(e);
+    bitmapAppendBits(bm, 0, (8 - bitmapGetLength(bm) % 8) % 8);
+    bitmapAppendBytes(bm, dados + inicio, n);
+  } else if (tipo == BLOCO_LZ_DIRETO) {
+    finalizaEscritor(e);
+    escreveComprimentos(bm, comprimentosBytes, 256);
+    registraComprimentos(&c->est, comprimentosBytes, 256);
+    for (size_t i = 0; i < n; i++) {
+      escreveCodigo(e, tabelaBytes[dados[inicio + i]].codigo,
+                    tabelaBytes[dados[inicio + i]].comprimento);
+    }
+    finalizaEscritor(e);
+  } else {
+    finalizaEscritor(e);
+    // um alfabeto para os literais e comprimentos, outro para as distâncias
+    escreveComprimentos(bm, comprimentosLiterais, NUM_LITERAIS_LZ);
+    escreveComprimentos(bm, comprimentosDistancias, NUM_DISTANCIAS_LZ);
+    registraComprimentos(&c->est, comprimentosLiterais, NUM_LITERAIS_LZ);
+    registraComprimentos(&c->est, comprimentosDistancias, NUM_DISTANCIAS_LZ);
+
+    p = dados + inicio;
+    for (size_t i = 0; i < numSequencias; i++) {
+      for (uint32_t j = 0; j < seq[i].literais; j++) {
+        escreveCodigo(e, literais[p[j]].codigo, literais[p[j]].comprimento);
+      }
+      p += seq[i].literais;
+
+      if (seq[i].comprimento > 0) {
+        uint32_t valor = seq[i].comprimento - COMPRIMENTO_MINIMO_LZ;
+        unsigned int classe = classeDoValor(valor);
+        escreveClasseLZ(e, &literais[PRIMEIRO_COMPRIMENTO_LZ + classe], classe,
+                        valor);
+        valor = seq[i].distancia - 1;
+        classe = classeDoValor(valor);
+        escreveClasseLZ(e, &distancias[classe], classe, valor);
+        p += seq[i].comprimento;
       }
     }
+    escreveCodigo(e, literais[SIMBOLO_EOF].codigo,
+                  literais[SIMBOLO_EOF].comprimento);
+    finalizaEscritor(e);
+  }
+  marcaFase(&c->est, FASE_CODIFICACAO, &c->cronometro);
+
+  return 0;
+}
+
+// Etapa LZ77: a entrada é analisada e gravada um bloco por vez, com as
+// cópias alcançando os blocos anteriores; a memória depende só do tamanho
+// do bloco e da janela, e as páginas da entrada que saíram da janela são
+// devolvidas ao sistema.
+static int escreveArquivoLZ(Compactador *c) {
+  const unsigned char *dados = dadosArquivoMapeado(c->entrada);
+  uint64_t tamanho = tamanhoArquivoMapeado(c->entrada);
+  if (c->buscador == NULL) {
+    c->buscador = criaBuscadorLZ(c->nivelLZ);
+  }
+
+  int arqSaida = criaArquivoSaida(c->arqSaida);
+  if (arqSaida < 0) {
+    return -1;
+  }
+
+  if (c->bm == NULL) {
+    c->bm = bitmapInit(((uint64_t)TAMANHO_PEDACO_SEQUENCIAL + 512) * 8);
+  }
+  bitmap *bm = c->bm;
+  bitmapReinicia(bm);
+
+  bitmapAppendBits(bm, ASSINATURA_FORMATO, 32);
+  bitmapAppendBits(bm, VERSAO_LZ77, 8);
+  bitmapAppendBits(bm, TAMANHO_BLOCO_LZ, 32);
+  marcaFase(&c->est, FASE_CABECALHO, &c->cronometro);
+
+  EscritorBits escritor;
+  iniciaEscritor(&escritor, bm);
+  uint64_t posicao = 0;
+  uint64_t descartados = 0;
+  int resultado = 0;
+
+  for (uint64_t inicio = 0; inicio < tamanho && resultado == 0;
+       inicio += TAMANHO_BLOCO_LZ) {
+    size_t n = tamanho - inicio < TAMANHO_BLOCO_LZ
+                   ? (size_t)(tamanho - inicio)
+                   : TAMANHO_BLOCO_LZ;
+    resultado = escreveBlocoLZ(c, &escritor, dados, inicio, n);
+    if (resultado == 0) {
+      resultado = gravaBytesCompletos(c, bm, arqSaida, &posicao);
+    }
+
+    // o que ficou antes da janela não é mais alcançado pelas cópias
+    if (inicio + n > JANELA_LZ) {
+      uint64_t fimDescarte = inicio + n - JANELA_LZ;
+      descartaTrechoMapeado(c->entrada, descartados, fimDescarte - descartados);
+      descartados = fimDescarte;
+    }
+  }
+
+  // um bloco vazio marca o fim
+  escreveCodigo(&escritor, 0, 32);
+  finalizaEscritor(&escritor);
+  c->frequencias[SIMBOLO_EOF] = 1;
+  acumulaEntropia(&c->est, c->frequencias, NUM_SIMBOLOS);
+
+  bitmapAppendBits(bm, 0, (8 - bitmapGetLength(bm) % 8) % 8);
+  if (resultado == 0) {
+    resultado = gravaBytesCompletos(c, bm, arqSaida, &posicao);
+  }
+
+  if (close(arqSaida) != 0) {
+    resultado = -1;
+  }
+  c->est.bytesSaida = posicao;
+  return resultado;
+}
+
+// um bloco da entrada, com o seu resultado compactado
+typedef struct {
+  const unsigned char *dados; // aponta para dentro da entrada mapeada
+  size_t tamanho;
+  bitmap *bm;
+  Estatisticas est;
+  int resultado; // -1 se os bytes do bloco não couberem no limite de bits
+} BlocoEmAndamento;
+
+typedef struct {
+  BlocoEmAndamento *blocos;
+  int limiteBits;
+  int numFluxos;
+} LoteBlocos;
+
+// tarefa executada pelas threads: compacta o i-ésimo bloco do lote
+static void compactaBlocoDoLote(void *contexto, int i) {
+  LoteBlocos *lote = contexto;
+  BlocoEmAndamento *b = &lote->blocos[i];
+
+  bitmapReinicia(b->bm);
+  memset(&b->est, 0, sizeof(Estatisticas));
+  if (lote->numFluxos > 1) {
+    b->resultado = compactaBlocoIntercalado(
+        b->dados, b->tamanho, lote->limiteBits, lote->numFluxos, b->bm,
+        &b->est);
   } else {
-    // escreve 0 indicando nó externo
-    bitmapAppendLeastSignificantBit(bm, 0);
-    escreveCabecalho(getEsquerda(a), bm);
-    escreveCabecalho(getDireita(a), bm);
+    b->resultado =
+        compactaBloco(b->dados, b->tamanho, lote->limiteBits, b->bm, &b->est);
   }
 }
 
-static void escreveArquivoCompactado(Compactador *c) {
-  FILE *arqSaida = fopen(c->arqSaida, "wb"); // abre binario
-  if (arqSaida == NULL) {
+// modo em blocos: o arquivo é compactado e gravado um lote de blocos por
+// vez, e as páginas da entrada já compactadas são devolvidas ao sistema, então
+// a memória usada depende só do tamanho do bloco e do número de threads. Os
+// blocos do lote são compactados em paralelo e gravados na ordem original,
+// então a saída não depende do número de threads.
+static int escreveArquivoEmBlocos(Compactador *c, size_t tamanhoBloco) {
+  const unsigned char *dados = dadosArquivoMapeado(c->entrada);
+  uint64_t tamanhoOriginal = tamanhoArquivoMapeado(c->entrada);
+
+  // o tamanho do arquivo define quantos blocos o índice terá
+  uint32_t numBlocos =
+      (uint32_t)((tamanhoOriginal + tamanhoBloco - 1) / tamanhoBloco);
+
+  int arqSaida = criaArquivoSaida(c->arqSaida);
+  if (arqSaida < 0) {
+    return -1;
+  }
+
+  // os blocos são gravados logo depois do espaço do cabeçalho; ele só é
+  // gravado no fim, quando os tamanhos compactados forem conhecidos
+  EntradaIndice *indice = calloc((size_t)numBlocos + 1, sizeof(EntradaIndice));
+  if (indice == NULL) {
     exit(1);
   }
+  uint64_t deslocamento = tamanhoCabecalhoIndexado(numBlocos);
 
-  // abre o arquivo pra saber o tamanho dele
-  FILE *arqParaMedir = fopen(c->arqEntrada, "rb");
-  if (arqParaMedir == NULL) {
+  // dois blocos por thread para que nenhuma fique parada no fim do lote
+  int capacidade = c->numThreads > 1 ? 2 * c->numThreads : 1;
+  Pool *pool = c->numThreads > 1 ? criaPool(c->numThreads) : NULL;
+
+  LoteBlocos lote;
+  lote.limiteBits = c->limiteBits;
+  lote.numFluxos = c->numFluxos;
+  lote.blocos = calloc(capacidade, sizeof(BlocoEmAndamento));
+  if (lote.blocos == NULL) {
     exit(1);
   }
+  // arquivos menores que um bloco não precisam de um mapa do tamanho do bloco
+  size_t maiorBloco =
+      tamanhoOriginal < tamanhoBloco ? (size_t)tamanhoOriginal : tamanhoBloco;
+  for (int i = 0; i < capacidade; i++) {
+    lote.blocos[i].bm =
+        bitmapInit(((uint64_t)maiorBloco + FOLGA_BLOCO_COMPACTADO) * 8);
+  }
 
-  // busca o final do arquivo e conta quantos bytes tem
-  fseek(arqParaMedir, 0, SEEK_END);
-  long tamanhoArquivoBytes = ftell(arqParaMedir);
+  int resultado = 0;
+  uint32_t blocosLidos = 0;
+  while (blocosLidos < numBlocos && resultado == 0) {
+    int n = 0;
+    uint64_t inicioLote = (uint64_t)blocosLidos * tamanhoBloco;
+    while (n < capacidade && blocosLidos < numBlocos) {
+      // o último bloco pode ser menor
+      uint64_t inicio = (uint64_t)blocosLidos * tamanhoBloco;
+      uint64_t restante = tamanhoOriginal - inicio;
+      lote.blocos[n].dados = dados + inicio;
+      lote.blocos[n].tamanho =
+          restante < tamanhoBloco ? (size_t)restante : tamanhoBloco;
+      blocosLidos++;
+      n++;
+    }
 
-  fclose(arqParaMedir);
+    executaNoPool(pool, n, compactaBlocoDoLote, &lote);
+    for (int i = 0; i < n; i++) {
+      somaEstatisticas(&c->est, &lote.blocos[i].est);
+    }
+    iniciaCronometro(&c->cronometro);
 
-  // descobre o tamanho máximo do bitmap
-  unsigned int tamanhoMaxBits = (tamanhoArquivoBytes * 8) + (512 * 8);
-  bitmap *bm = bitmapInit(tamanhoMaxBits);
+    uint64_t tamanhoLote = 0;
+    for (int i = 0; i < n; i++) {
+      BlocoEmAndamento *b = &lote.blocos[i];
+      uint32_t totalBytes = (uint32_t)((bitmapGetLength(b->bm) + 7) / 8);
+      if (b->resultado != 0 ||
+          escreveNaPosicao(arqSaida, bitmapGetContents(b->bm), totalBytes,
+                           deslocamento) != 0) {
+        resultado = -1;
+        break;
+      }
 
-  escreveCabecalho(c->arvore, bm);
+      EntradaIndice *e = &indice[blocosLidos - n + i];
+      e->deslocamento = deslocamento;
+      e->tamanhoCompactado = totalBytes;
+      e->tamanhoOriginal = (uint32_t)b->tamanho;
+      deslocamento += totalBytes;
+      tamanhoLote += b->tamanho;
+    }
 
-  FILE *arqOriginal = fopen(c->arqEntrada, "rb");
-  if (arqOriginal == NULL) {
+    descartaTrechoMapeado(c->entrada, inicioLote, tamanhoLote);
+    marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
+  }
+
+  // grava o cabeçalho com o índice completo no espaço reservado
+  size_t tamanhoCabecalho = (size_t)tamanhoCabecalhoIndexado(numBlocos);
+  unsigned char *cabecalho = malloc(tamanhoCabecalho);
+  if (cabecalho == NULL) {
     exit(1);
   }
+  montaCabecalhoIndexado(cabecalho,
+                         c->numFluxos > 1 ? VERSAO_BLOCOS_INTERCALADOS
+                                          : VERSAO_BLOCOS_INDEXADOS,
+                         (uint32_t)tamanhoBloco, indice, numBlocos,
+                         tamanhoOriginal);
+  if (resultado == 0 &&
+      escreveNaPosicao(arqSaida, cabecalho, tamanhoCabecalho, 0) != 0) {
+    resultado = -1;
+  }
+  c->est.bytesSaida = deslocamento;
+  marcaFase(&c->est, FASE_CABECALHO, &c->cronometro);
+
+  for (int i = 0; i < capacidade; i++) {
+    bitmapLibera(lote.blocos[i].bm);
+  }
+  free(lote.blocos);
+  free(cabecalho);
+  free(indice);
+  liberaPool(pool);
+  if (close(arqSaida) != 0) {
+    resultado = -1;
+  }
+
+  return resultado;
+}
+
+// grava no fluxo de saída; os erros ficam registrados no FILE e são
+// conferidos no fim por ferror
+static void gravaNoFluxo(const unsigned char *dados, size_t n, FILE *saida) {
+  fwrite(dados, 1, n, saida);
+}
+
+// Huffman adaptativo: a entrada é lida uma única vez, em pedaços, e cada
+// byte é codificado e entra no modelo na mesma passada. Os bytes completos
+// do mapa vão para a saída ao fim de cada pedaço.
+static int escreveFluxoAdaptativo(Compactador *c, FILE *entrada,
+                                  FILE *saida) {
+  if (c->modelo == NULL) {
+    c->modelo = criaModeloAdaptativo();
+  } else {
+    reiniciaModeloAdaptativo(c->modelo);
+  }
+  if (c->bm == NULL) {
+    c->bm = bitmapInit(((uint64_t)TAMANHO_PEDACO_SEQUENCIAL + 512) * 8);
+  }
+  bitmap *bm = c->bm;
+  bitmapReinicia(bm);
 
-  // le cada caractere do arquivo original e escreve seu código binário no
-  // bitmap
-  int caractere;
-  while ((caractere = fgetc(arqOriginal)) != EOF) {
-    char *codigo = c->tabelaCodigos[caractere];
-    for (int i = 0; codigo[i] != '\0'; i++) {
-      bitmapAppendLeastSignificantBit(bm, codigo[i] - '0');
+  unsigned char *pedaco = malloc(TAMANHO_PEDACO_SEQUENCIAL);
+  if (pedaco == NULL) {
+    exit(1);
+  }
+
+  bitmapAppendBits(bm, ASSINATURA_FORMATO, 32);
+  bitmapAppendBits(bm, VERSAO_ADAPTATIVA, 8);
+  marcaFase(&c->est, FASE_CABECALHO, &c->cronometro);
+
+  EscritorBits escritor;
+  iniciaEscritor(&escritor, bm);
+  uint64_t gravados = 0;
+
+  size_t n;
+  while ((n = fread(pedaco, 1, TAMANHO_PEDACO_SEQUENCIAL, entrada)) > 0) {
+    // o histograma só serve para a entropia das estatísticas
+    contaBytes(pedaco, n, c->frequencias);
+    c->est.bytesEntrada += n;
+    marcaFase(&c->est, FASE_CONTAGEM, &c->cronometro);
+
+    codificaBytesAdaptativo(c->modelo, &escritor, pedaco, n);
+    finalizaEscritor(&escritor);
+    marcaFase(&c->est, FASE_CODIFICACAO, &c->cronometro);
+
+    uint64_t completos = bitmapGetLength(bm) / 8;
+    gravaNoFluxo(bitmapGetContents(bm), (size_t)completos, saida);
+    bitmapDescartaBytes(bm, completos);
+    gravados += completos;
+    marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
+  }
+
+  codificaAdaptativo(c->modelo, &escritor, SIMBOLO_EOF);
+  finalizaEscritor(&escritor);
+  c->frequencias[SIMBOLO_EOF] = 1;
+  acumulaEntropia(&c->est, c->frequencias, NUM_SIMBOLOS);
+
+  // os bits dos códigos, sem a assinatura e a versão
+  c->est.bitsSemLimite = gravados * 8 + bitmapGetLength(bm) - 40;
+  c->est.bitsComLimite = c->est.bitsSemLimite;
+  marcaFase(&c->est, FASE_CODIFICACAO, &c->cronometro);
+
+  bitmapAppendBits(bm, 0, (8 - bitmapGetLength(bm) % 8) % 8);
+  uint64_t completos = bitmapGetLength(bm) / 8;
+  gravaNoFluxo(bitmapGetContents(bm), (size_t)completos, saida);
+  bitmapDescartaBytes(bm, completos);
+  c->est.bytesSaida = gravados + completos;
+  free(pedaco);
+
+  int resultado = fflush(saida) != 0 || ferror(saida) || ferror(entrada)
+                      ? -1
+                      : 0;
+  marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
+
+  return resultado;
+}
+
+// Etapa BWT: a entrada é lida em blocos, e cada bloco passa pela
+// transformada, pelo move-to-front e pela codificação das corridas de zeros
+// antes de receber a sua própria tabela de códigos. A memória depende só do
+// tamanho do bloco; os blocos sem contexto a aproveitar ficam só com o
+// Huffman dos bytes, e os que não diminuiriam vão armazenados.
+static int escreveFluxoBWT(Compactador *c, FILE *entrada, FILE *saida) {
+  uint32_t tamanhoBloco = (uint32_t)c->tamanhoBlocoBWT;
+  unsigned char *dados = malloc(tamanhoBloco);
+  unsigned char *transformados = malloc(tamanhoBloco);
+  int32_t *sa = malloc(((size_t)tamanhoBloco + 1) * sizeof(int32_t));
+  uint16_t *simbolos = malloc(((size_t)tamanhoBloco + 1) * sizeof(uint16_t));
+  if (dados == NULL || transformados == NULL || sa == NULL ||
+      simbolos == NULL) {
+    exit(1);
+  }
+  if (c->bm == NULL) {
+    c->bm = bitmapInit(((uint64_t)TAMANHO_PEDACO_SEQUENCIAL + 512) * 8);
+  }
+  bitmap *bm = c->bm;
+  bitmapReinicia(bm);
+
+  bitmapAppendBits(bm, ASSINATURA_FORMATO, 32);
+  bitmapAppendBits(bm, VERSAO_BWT, 8);
+  bitmapAppendBits(bm, tamanhoBloco, 32);
+  marcaFase(&c->est, FASE_CABECALHO, &c->cronometro);
+
+  EscritorBits escritor;
+  iniciaEscritor(&escritor, bm);
+  uint64_t gravados = 0;
+
+  int resultado = 0;
+  size_t n;
+  while ((n = fread(dados, 1, tamanhoBloco, entrada)) > 0) {
+    uint64_t frequenciasBytes[256] = {0};
+    contaBytes(dados, n, frequenciasBytes);
+    c->est.bytesEntrada += n;
+    uint32_t linhas[NUM_TRECHOS_BWT - 1];
+    uint32_t primario =
+        transformaBWT(dados, (uint32_t)n, transformados, sa, linhas);
+    uint64_t frequencias[NUM_SIMBOLOS_BWT] = {0};
+    size_t numSimbolos =
+        codificaMTF(transformados, (uint32_t)n, simbolos, frequencias);
+    marcaFase(&c->est, FASE_CONTAGEM, &c->cronometro);
+
+    // os códigos da etapa e os do Huffman direto dos bytes, para a escolha
+    // do tipo do bloco
+    unsigned char comprimentos[NUM_SIMBOLOS_BWT];
+    CodigoHuffman tabela[NUM_SIMBOLOS_BWT];
+    uint64_t bitsSemLimite = 0;
+    uint64_t bitsComLimite = 0;
+    unsigned char comprimentosBytes[256];
+    CodigoHuffman tabelaBytes[256];
+    uint64_t bitsSemLimiteBytes = 0;
+    uint64_t bitsComLimiteBytes = 0;
+    if (geraCodigosDoAlfabeto(c, frequencias, NUM_SIMBOLOS_BWT, comprimentos,
+                              tabela, &bitsSemLimite, &bitsComLimite) != 0 ||
+        geraCodigosDoAlfabeto(c, frequenciasBytes, 256, comprimentosBytes,
+                              tabelaBytes, &bitsSemLimiteBytes,
+                              &bitsComLimiteBytes) != 0) {
+      resultado = -1;
+      break;
+    }
+    int distintos = 0;
+    for (int s = 0; s < 256; s++) {
+      c->frequencias[s] += frequenciasBytes[s];
+      distintos += frequenciasBytes[s] > 0;
+    }
+    marcaFase(&c->est, FASE_ARVORE, &c->cronometro);
+
+    // um único byte repetido sai sempre transformado: o código direto dele
+    // não teria bits
+    int tipo = BLOCO_BWT_TRANSFORMADO;
+    if (distintos > 1 && bitsComLimiteBytes < bitsComLimite) {
+      tipo = BLOCO_BWT_DIRETO;
+      bitsSemLimite = bitsSemLimiteBytes;
+      bitsComLimite = bitsComLimiteBytes;
+    }
+    if (bitsComLimite >= (uint64_t)n * 8) {
+      tipo = BLOCO_BWT_ARMAZENADO;
+      bitsSemLimite = bitsComLimite = (uint64_t)n * 8;
+    }
+    c->est.bitsSemLimite += bitsSemLimite;
+    c->est.bitsComLimite += bitsComLimite;
+
+    escreveCodigo(&escritor, n, 32);
+    escreveCodigo(&escritor, tipo, 2);
+    if (tipo == BLOCO_BWT_ARMAZENADO) {
+      finalizaEscritor(&escritor);
+      bitmapAppendBits(bm, 0, (8 - bitmapGetLength(bm) % 8) % 8);
+      bitmapAppendBytes(bm, dados, n);
+    } else if (tipo == BLOCO_BWT_DIRETO) {
+      finalizaEscritor(&escritor);
+      escreveComprimentos(bm, comprimentosBytes, 256);
+      registraComprimentos(&c->est, comprimentosBytes, 256);
+      for (size_t i = 0; i < n; i++) {
+        escreveCodigo(&escritor, tabelaBytes[dados[i]].codigo,
+                      tabelaBytes[dados[i]].comprimento);
+      }
+      finalizaEscritor(&escritor);
+    } else {
+      escreveCodigo(&escritor, primario, 32);
+      for (int k = 0; k < NUM_TRECHOS_BWT - 1; k++) {
+        escreveCodigo(&escritor, linhas[k], 32);
+      }
+      finalizaEscritor(&escritor);
+      escreveComprimentos(bm, comprimentos, NUM_SIMBOLOS_BWT);
+      registraComprimentos(&c->est, comprimentos, NUM_SIMBOLOS_BWT);
+      for (size_t i = 0; i < numSimbolos; i++) {
+        escreveCodigo(&escritor, tabela[simbolos[i]].codigo,
+                      tabela[simbolos[i]].comprimento);
+      }
+      finalizaEscritor(&escritor);
     }
+    marcaFase(&c->est, FASE_CODIFICACAO, &c->cronometro);
+
+    uint64_t completos = bitmapGetLength(bm) / 8;
+    gravaNoFluxo(bitmapGetContents(bm), (size_t)completos, saida);
+    bitmapDescartaBytes(bm, completos);
+    gravados += completos;
+    marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
   }
-  fclose(arqOriginal);
 
-  // escreve o eof no final
-  char *eofCodigo = c->tabelaCodigos[256];
-  for (int i = 0; eofCodigo[i] != '\0'; i++) {
-    bitmapAppendLeastSignificantBit(bm, eofCodigo[i] - '0');
+  // um bloco vazio marca o fim
+  escreveCodigo(&escritor, 0, 32);
+  finalizaEscritor(&escritor);
+  c->frequencias[SIMBOLO_EOF] = 1;
+  acumulaEntropia(&c->est, c->frequencias, NUM_SIMBOLOS);
+
+  bitmapAppendBits(bm, 0, (8 - bitmapGetLength(bm) % 8) % 8);
+  uint64_t completos = bitmapGetLength(bm) / 8;
+  gravaNoFluxo(bitmapGetContents(bm), (size_t)completos, saida);
+  bitmapDescartaBytes(bm, completos);
+  c->est.bytesSaida = gravados + completos;
+  free(dados);
+  free(transformados);
+  free(sa);
+  free(simbolos);
+
+  if (fflush(saida) != 0 || ferror(saida) || ferror(entrada)) {
+    resultado = -1;
+  }
+  marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
+
+  return resultado;
+}
+
+// com um dicionário a tabela já é conhecida, então a entrada também é lida
+// uma única vez e codificada à medida que chega
+static int escreveFluxoDicionario(Compactador *c, FILE *entrada,
+                                  FILE *saida) {
+  const CodigoHuffman *tabela = codigosDicionario(c->dicionario);
+  if (c->bm == NULL) {
+    c->bm = bitmapInit(((uint64_t)TAMANHO_PEDACO_SEQUENCIAL + 512) * 8);
+  }
+  bitmap *bm = c->bm;
+  bitmapReinicia(bm);
+
+  unsigned char *pedaco = malloc(TAMANHO_PEDACO_SEQUENCIAL);
+  if (pedaco == NULL) {
+    exit(1);
+  }
+
+  escreveCabecalho(c, bm);
+  marcaFase(&c->est, FASE_CABECALHO, &c->cronometro);
+
+  // Uma entrada que cabe inteira no primeiro pedaço tem o histograma
+  // conhecido antes de qualquer código: se o dicionário, treinado em outros
+  // dados, não a deixaria menor, ela é só copiada. Nas maiores o fluxo já
+  // precisa sair antes do fim da entrada.
+  size_t n = fread(pedaco, 1, TAMANHO_PEDACO_SEQUENCIAL, entrada);
+  if (n < TAMANHO_PEDACO_SEQUENCIAL && !ferror(entrada)) {
+    uint64_t frequencias[NUM_SIMBOLOS] = {0};
+    contaBytes(pedaco, n, frequencias);
+    frequencias[SIMBOLO_EOF] = 1;
+    c->est.bitsSemLimite = c->est.bitsComLimite =
+        bitsDoDicionario(c, frequencias);
+    marcaFase(&c->est, FASE_CONTAGEM, &c->cronometro);
+
+    if (!compensaCompactar(c, bm, n)) {
+      bitmapReinicia(bm);
+      bitmapAppendBits(bm, ASSINATURA_FORMATO, 32);
+      bitmapAppendBits(bm, VERSAO_ARMAZENADA, 8);
+      gravaNoFluxo(bitmapGetContents(bm), 5, saida);
+      gravaNoFluxo(pedaco, n, saida);
+      bitmapReinicia(bm);
+      c->est.bytesEntrada = n;
+      c->est.bytesSaida = 5 + n;
+      free(pedaco);
+
+      int resultado = fflush(saida) != 0 || ferror(saida) ? -1 : 0;
+      marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
+      return resultado;
+    }
   }
 
-  // calcula quantos bytes completos precisam ser escritos
-  unsigned int totalBytes = (bitmapGetLength(bm) + 7) / 8;
-  fwrite(bitmapGetContents(bm), sizeof(unsigned char), totalBytes, arqSaida);
+  EscritorBits escritor;
+  iniciaEscritor(&escritor, bm);
+  uint64_t gravados = 0;
 
-  bitmapLibera(bm);
-  fclose(arqSaida);
+  for (; n > 0; n = fread(pedaco, 1, TAMANHO_PEDACO_SEQUENCIAL, entrada)) {
+    c->est.bytesEntrada += n;
+    for (size_t i = 0; i < n; i++) {
+      escreveCodigo(&escritor, tabela[pedaco[i]].codigo,
+                    tabela[pedaco[i]].comprimento);
+    }
+    finalizaEscritor(&escritor);
+    marcaFase(&c->est, FASE_CODIFICACAO, &c->cronometro);
+
+    uint64_t completos = bitmapGetLength(bm) / 8;
+    gravaNoFluxo(bitmapGetContents(bm), (size_t)completos, saida);
+    bitmapDescartaBytes(bm, completos);
+    gravados += completos;
+    marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
+  }
+
+  escreveCodigo(&escritor, tabela[SIMBOLO_EOF].codigo,
+                tabela[SIMBOLO_EOF].comprimento);
+  finalizaEscritor(&escritor);
+  marcaFase(&c->est, FASE_CODIFICACAO, &c->cronometro);
+
+  bitmapAppendBits(bm, 0, (8 - bitmapGetLength(bm) % 8) % 8);
+  uint64_t completos = bitmapGetLength(bm) / 8;
+  gravaNoFluxo(bitmapGetContents(bm), (size_t)completos, saida);
+  bitmapDescartaBytes(bm, completos);
+  c->est.bytesSaida = gravados + completos;
+  free(pedaco);
+
+  int resultado = fflush(saida) != 0 || ferror(saida) || ferror(entrada)
+                      ? -1
+                      : 0;
+  marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
+
+  return resultado;
+}
+
+int executaCompactacaoFluxo(Compactador *c, FILE *entrada, FILE *saida) {
+  Cronometro inicio;
+  iniciaCronometroProcesso(&inicio);
+  memset(&c->est, 0, sizeof(Estatisticas));
+
+  if (c->adaptativo) {
+    memset(c->frequencias, 0, sizeof(c->frequencias));
+    iniciaCronometro(&c->cronometro);
+    int resultado = escreveFluxoAdaptativo(c, entrada, saida);
+    finalizaEstatisticas(&c->est, &inicio);
+    return resultado;
+  }
+
+  if (c->tamanhoBlocoBWT > 0) {
+    memset(c->frequencias, 0, sizeof(c->frequencias));
+    iniciaCronometro(&c->cronometro);
+    int resultado = escreveFluxoBWT(c, entrada, saida);
+    finalizaEstatisticas(&c->est, &inicio);
+    return resultado;
+  }
+
+  if (c->dicionario != NULL) {
+    iniciaCronometro(&c->cronometro);
+    int resultado = escreveFluxoDicionario(c, entrada, saida);
+    finalizaEstatisticas(&c->est, &inicio);
+    return resultado;
+  }
+
+  // sem tamanho definido, os blocos do fluxo usam o padrão
+  size_t tamanhoBloco =
+      c->tamanhoBloco > 0 ? c->tamanhoBloco : TAMANHO_BLOCO_PADRAO;
+
+  // o formato sem índice tem os tamanhos antes de cada bloco, então cada
+  // lote pode ser gravado assim que é compactado, sem voltar ao início
+  unsigned char cabecalho[TAMANHO_CABECALHO_BLOCOS];
+  montaCabecalhoBlocos(cabecalho, (uint32_t)tamanhoBloco);
+  gravaNoFluxo(cabecalho, sizeof(cabecalho), saida);
+  c->est.bytesSaida = sizeof(cabecalho);
+
+  int capacidade = c->numThreads > 1 ? 2 * c->numThreads : 1;
+  Pool *pool = c->numThreads > 1 ? criaPool(c->numThreads) : NULL;
+
+  // cada bloco tem a sua própria área de leitura, reaproveitada a cada lote;
+  // os blocos desse formato têm sempre um único fluxo
+  LoteBlocos lote;
+  lote.limiteBits = c->limiteBits;
+  lote.numFluxos = 1;
+  lote.blocos = calloc(capacidade, sizeof(BlocoEmAndamento));
+  unsigned char **areas = calloc(capacidade, sizeof(unsigned char *));
+  if (lote.blocos == NULL || areas == NULL) {
+    exit(1);
+  }
+  for (int i = 0; i < capacidade; i++) {
+    areas[i] = malloc(tamanhoBloco);
+    if (areas[i] == NULL) {
+      exit(1);
+    }
+    lote.blocos[i].dados = areas[i];
+    lote.blocos[i].bm =
+        bitmapInit((tamanhoBloco + FOLGA_BLOCO_COMPACTADO) * 8);
+  }
+
+  int resultado = 0;
+  int fimDaEntrada = 0;
+  while (!fimDaEntrada && !ferror(saida) && resultado == 0) {
+    int n = 0;
+    while (n < capacidade && !fimDaEntrada) {
+      size_t lidos = fread(areas[n], 1, tamanhoBloco, entrada);
+      if (lidos < tamanhoBloco) {
+        fimDaEntrada = 1;
+      }
+      if (lidos > 0) {
+        lote.blocos[n].tamanho = lidos;
+        n++;
+      }
+    }
+
+    executaNoPool(pool, n, compactaBlocoDoLote, &lote);
+
+    iniciaCronometro(&c->cronometro);
+    for (int i = 0; i < n; i++) {
+      BlocoEmAndamento *b = &lote.blocos[i];
+      if (b->resultado != 0) {
+        resultado = -1;
+        break;
+      }
+      uint32_t totalBytes = (uint32_t)((bitmapGetLength(b->bm) + 7) / 8);
+      unsigned char prefixo[TAMANHO_PREFIXO_BLOCO];
+      montaPrefixoBloco(prefixo, (uint32_t)b->tamanho, totalBytes);
+      gravaNoFluxo(prefixo, sizeof(prefixo), saida);
+      gravaNoFluxo(bitmapGetContents(b->bm), totalBytes, saida);
+
+      somaEstatisticas(&c->est, &b->est);
+      c->est.bytesEntrada += b->tamanho;
+      c->est.bytesSaida += sizeof(prefixo) + totalBytes;
+    }
+    marcaFase(&c->est, FASE_ESCRITA, &c->cronometro);
+  }
+
+  // um bloco vazio marca o fim
+  unsigned char fim[TAMANHO_PREFIXO_BLOCO];
+  montaPrefixoBloco(fim, 0, 0);
+  gravaNoFluxo(fim, sizeof(fim), saida);
+  if (fflush(saida) != 0 || ferror(saida) || ferror(entrada)) {
+    resultado = -1;
+  }
+  c->est.bytesSaida += sizeof(fim);
+
+  for (int i = 0; i < capacidade; i++) {
+    bitmapLibera(lote.blocos[i].bm);
+    free(areas[i]);
+  }
+  free(areas);
+  free(lote.blocos);
+  liberaPool(pool);
+  finalizaEstatisticas(&c->est, &inicio);
+
+  return resultado;
 }
 
 Compactador *criaCompactador(const char *caminho_entrada) {
   Compactador *c = calloc(1, sizeof(Compactador));
+  if (c == NULL) {
+    exit(1);
+  }
+
+  defineArquivoCompactacao(c, caminho_entrada);
+
+  return c;
+};
+
+void defineArquivoCompactacao(Compactador *c, const char *caminho_entrada) {
+  free(c->arqEntrada);
+  free(c->arqSaida);
 
   // copia do caminho de entrada
   c->arqEntrada = strdup(caminho_entrada);
 
   // adiciona o .comp para o arquivo compactado
-  c->arqSaida = (char *)malloc(strlen(caminho_entrada) + 5); // .comp + \0
+  c->arqSaida = (char *)malloc(strlen(caminho_entrada) + 6); // .comp + \0
+  if (c->arqEntrada == NULL || c->arqSaida == NULL) {
+    exit(1);
+  }
   strcpy(c->arqSaida, caminho_entrada);
   strcat(c->arqSaida, ".comp");
+}
+
+void defineLimiteBits(Compactador *c, int limiteBits) {
+  c->limiteBits = limiteBits;
+}
+
+void defineTamanhoBloco(Compactador *c, size_t tamanhoBloco) {
+  c->tamanhoBloco = tamanhoBloco;
+}
 
-  for (int i = 0; i < 256; i++) {
-    c->tabelaCodigos[i] = NULL;
+void defineNumThreads(Compactador *c, int numThreads) {
+  c->numThreads = numThreads;
+}
+
+void defineNumFluxos(Compactador *c, int numFluxos) {
+  c->numFluxos = numFluxos;
+}
+
+void defineAdaptativo(Compactador *c, int adaptativo) {
+  c->adaptativo = adaptativo;
+}
+
+void defineContexto(Compactador *c, int contexto) { c->contexto = contexto; }
+
+void defineNivelLZ(Compactador *c, int nivel) {
+  // as cadeias de hash são montadas para um nível
+  if (nivel != c->nivelLZ) {
+    liberaBuscadorLZ(c->buscador);
+    c->buscador = NULL;
   }
+  c->nivelLZ = nivel;
+}
 
-  return c;
-};
+void defineTamanhoBlocoBWT(Compactador *c, size_t tamanhoBloco) {
+  c->tamanhoBlocoBWT = tamanhoBloco;
+}
+
+void defineDicionario(Compactador *c, const Dicionario *d) {
+  c->dicionario = d;
+}
+
+unsigned long long getBitsSemLimite(Compactador *c) {
+  return c->est.bitsSemLimite;
+}
+
+unsigned long long getBitsComLimite(Compactador *c) {
+  return c->est.bitsComLimite;
+}
+
+const Estatisticas *getEstatisticasCompactacao(Compactador *c) {
+  return &c->est;
+}
+
+// lê o arquivo de entrada em pedaços, pelo mesmo caminho da entrada padrão,
+// e grava o resultado no arquivo de saída
+static int compactaEmPedacos(Compactador *c) {
+  FILE *entrada = fopen(c->arqEntrada, "rb");
+  if (entrada == NULL) {
+    return -1;
+  }
+  int arqSaida = criaArquivoSaida(c->arqSaida);
+  FILE *saida = arqSaida >= 0 ? fdopen(arqSaida, "wb") : NULL;
+  if (saida == NULL) {
+    if (arqSaida >= 0) {
+      close(arqSaida);
+    }
+    fclose(entrada);
+    return -1;
+  }
+
+  int resultado = executaCompactacaoFluxo(c, entrada, saida);
+  if (fclose(saida) != 0) {
+    resultado = -1;
+  }
+  fclose(entrada);
+  return resultado;
+}
+
+int executaCompactacao(Compactador *c) {
+  // o modo adaptativo e a etapa BWT leem a entrada uma única vez, em
+  // pedaços, então não precisam dela mapeada
+  if (c->adaptativo || c->tamanhoBlocoBWT > 0) {
+    return compactaEmPedacos(c);
+  }
+
+  // uma pipe não pode ser mapeada: em vez de lida inteira para a memória, é
+  // compactada em pedaços, no formato da entrada padrão. O modelo de
+  // contexto e a etapa LZ77 precisam da entrada inteira, e os fluxos
+  // intercalados precisam do índice, então ficam de fora, como no "-".
+  if (!ehArquivoRegular(c->arqEntrada)) {
+    if (c->contexto || c->nivelLZ > 0 || c->numFluxos > 1) {
+      return -1;
+    }
+    return compactaEmPedacos(c);
+  }
+
+  Cronometro inicio;
+  iniciaCronometroProcesso(&inicio);
+  memset(&c->est, 0, sizeof(Estatisticas));
+  memset(c->frequencias, 0, sizeof(c->frequencias));
+  iniciaCronometro(&c->cronometro);
+
+  c->entrada = abreArquivoMapeado(c->arqEntrada);
+  if (c->entrada == NULL) {
+    return -1;
+  }
+  c->est.bytesEntrada = tamanhoArquivoMapeado(c->entrada);
+
+  // compactar em paralelo e dividir em fluxos exigem blocos independentes;
+  // o modelo de contexto, o dicionário e a etapa LZ77 usam sempre um fluxo
+  // único. O tamanho efetivo fica só nesta chamada: um compactador
+  // reaproveitado no lote não herda o do arquivo anterior.
+  size_t tamanhoBloco = c->tamanhoBloco;
+  if ((c->numThreads > 1 || c->numFluxos > 1) && tamanhoBloco == 0 &&
+      !c->contexto && c->dicionario == NULL && c->nivelLZ == 0) {
+    tamanhoBloco = TAMANHO_BLOCO_PADRAO;
+  }
 
-void executaCompactacao(Compactador *c) {
-  contaFrequencia(c);
+  // no modo em blocos cada bloco tem o seu próprio histograma
+  int resultado;
+  if (c->dicionario != NULL) {
+    // a tabela vem pronta do dicionário, sem árvore; a contagem só serve
+    // para saber se os códigos dele deixam esta entrada menor
+    memcpy(c->tabelaCodigos, codigosDicionario(c->dicionario),
+           sizeof(c->tabelaCodigos));
+    contaFrequencia(c);
+    c->frequencias[SIMBOLO_EOF] = 1;
+    c->est.bitsSemLimite = c->est.bitsComLimite =
+        bitsDoDicionario(c, c->frequencias);
+    resultado = escreveArquivoCompactado(c);
+  } else if (c->nivelLZ > 0) {
+    resultado = escreveArquivoLZ(c);
+  } else if (c->contexto) {
+    if (c->frequenciasContexto == NULL) {
+      c->frequenciasContexto =
+          malloc(NUM_CONTEXTOS * sizeof(*c->frequenciasContexto));
+      if (c->frequenciasContexto == NULL) {
+        exit(1);
+      }
+    }
+    memset(c->frequenciasContexto, 0,
+           NUM_CONTEXTOS * sizeof(*c->frequenciasContexto));
 
-  constroiArvoreHuffman(c);
+    contaFrequencia(c);
 
-  geraTabelaCodigos(c);
+    resultado =
+        geraTabelasContexto(c) == 0 ? escreveArquivoCompactado(c) : -1;
+  } else if (tamanhoBloco > 0) {
+    resultado = escreveArquivoEmBlocos(c, tamanhoBloco);
+  } else {
+    contaFrequencia(c);
 
-  escreveArquivoCompactado(c);
+    constroiArvoreHuffman(c);
+
+    resultado =
+        geraTabelaCodigos(c) == 0 ? escreveArquivoCompactado(c) : -1;
+  }
+
+  fechaArquivoMapeado(c->entrada);
+  c->entrada = NULL;
+  finalizaEstatisticas(&c->est, &inicio);
+
+  return resultado;
 }
 
 void liberaCompactador(Compactador *c) {
@@ -223,14 +1394,13 @@ void liberaCompactador(Compactador *c) {
 
   free(c->arqEntrada);
   free(c->arqSaida);
-  liberaArvore(c->arvore);
-
-  // pra cada ponteiro nao nulo, libera a string alocada
-  for (int i = 0; i < 257; i++) {
-    if (c->tabelaCodigos[i] != NULL) {
-      free(c->tabelaCodigos[i]);
-    }
+  liberaArenaArvore(c->arena);
+  if (c->bm != NULL) {
+    bitmapLibera(c->bm);
   }
+  liberaModeloAdaptativo(c->modelo);
+  free(c->frequenciasContexto);
+  liberaBuscadorLZ(c->buscador);
 
   free(c);
 }
\ No newline at end of file
@@ -9,6 +9,11 @@
 #ifndef COMPACTADOR_H
 #define COMPACTADOR_H
 
+#include "dicionario.h"
+#include "estatisticas.h"
+#include <stddef.h>
+#include <stdio.h>
+
 typedef struct compactador Compactador;
 
 /**
@@ -20,14 +25,173 @@ typedef struct compactador Compactador;
  */
 Compactador *criaCompactador(const char *caminho_entrada);
 
+/**
+ * @brief Troca o arquivo a ser compactado, para que o mesmo compactador (com
+ * a sua arena e o seu mapa de bits) seja usado em vários arquivos.
+ * @param c Ponteiro para o Compactador.
+ * @param caminho_entrada O nome do próximo arquivo a ser compactado.
+ */
+void defineArquivoCompactacao(Compactador *c, const char *caminho_entrada);
+
+/**
+ * @brief Limita o comprimento máximo dos códigos gerados.
+ *
+ * Quando a árvore de Huffman passa do limite, os comprimentos são refeitos
+ * pelo package-merge, que encontra o melhor código respeitando o limite.
+ * Deve ser chamada antes de executaCompactacao.
+ *
+ * @param c Ponteiro para o Compactador.
+ * @param limiteBits Comprimento máximo em bits (0 = sem limite).
+ */
+void defineLimiteBits(Compactador *c, int limiteBits);
+
+/**
+ * @brief Ativa o modo em blocos.
+ *
+ * O arquivo é dividido em blocos do tamanho dado, cada um com os seus
+ * próprios códigos, que são compactados e gravados um de cada vez. A memória
+ * usada fica proporcional ao tamanho do bloco, e não ao do arquivo.
+ *
+ * @param c Ponteiro para o Compactador.
+ * @param tamanhoBloco Tamanho de cada bloco em bytes (0 = fluxo único).
+ */
+void defineTamanhoBloco(Compactador *c, size_t tamanhoBloco);
+
+/**
+ * @brief Define quantas threads compactam blocos ao mesmo tempo.
+ *
+ * Com mais de uma thread o modo em blocos é ativado (com blocos de
+ * TAMANHO_BLOCO_PADRAO, se nenhum tamanho foi definido). Os blocos são
+ * gravados na ordem original, e o arquivo gerado é o mesmo para qualquer
+ * número de threads.
+ *
+ * @param c Ponteiro para o Compactador.
+ * @param numThreads Quantidade de threads (1 = sem paralelismo).
+ */
+void defineNumThreads(Compactador *c, int numThreads);
+
+/**
+ * @brief Divide cada bloco em fluxos intercalados que compartilham a mesma
+ * tabela de códigos, para que a descompactação decodifique vários símbolos
+ * ao mesmo tempo. Com mais de um fluxo o modo em blocos é ativado.
+ * @param c Ponteiro para o Compactador.
+ * @param numFluxos Quantidade de fluxos (1 a MAX_FLUXOS; 1 = um fluxo por
+ * bloco, no formato indexado comum).
+ */
+void defineNumFluxos(Compactador *c, int numFluxos);
+
+/**
+ * @brief Usa o Huffman adaptativo: a entrada é lida uma única vez, e a
+ * árvore, atualizada a cada byte do mesmo jeito no descompactador, não vai
+ * no cabeçalho. Dispensa o modo em blocos, o limite de comprimento e as
+ * threads, que são ignorados.
+ * @param c Ponteiro para o Compactador.
+ * @param adaptativo 1 para ativar, 0 para o Huffman estático.
+ */
+void defineAdaptativo(Compactador *c, int adaptativo);
+
+/**
+ * @brief Usa o modelo de contexto de ordem 1: o código de cada byte vem de
+ * uma tabela escolhida pelo byte anterior, com os contextos parecidos
+ * agrupados em até MAX_TABELAS_CONTEXTO tabelas. O arquivo é compactado em
+ * um fluxo único, então o modo em blocos e as threads são ignorados; vale só
+ * para executaCompactacao.
+ * @param c Ponteiro para o Compactador.
+ * @param contexto 1 para ativar, 0 para uma única tabela.
+ */
+void defineContexto(Compactador *c, int contexto);
+
+/**
+ * @brief Passa a entrada pela etapa LZ77 antes do Huffman: os trechos que
+ * repetem bytes de até JANELA_LZ bytes atrás viram pares (comprimento,
+ * distância), codificados com um alfabeto para os literais e comprimentos e
+ * outro para as distâncias. O arquivo é compactado em um fluxo único, então
+ * o modo em blocos e as threads são ignorados; vale só para
+ * executaCompactacao.
+ * @param c Ponteiro para o Compactador.
+ * @param nivel Esforço da busca, de NIVEL_LZ_MINIMO a NIVEL_LZ_MAXIMO, ou 0
+ * para não usar a etapa.
+ */
+void defineNivelLZ(Compactador *c, int nivel);
+
+/**
+ * @brief Passa a entrada pela etapa BWT antes do Huffman: em cada bloco, a
+ * transformada de Burrows-Wheeler, o move-to-front e a codificação das
+ * corridas de zeros, com uma tabela de códigos por bloco. A memória depende
+ * só do tamanho do bloco, e a entrada é lida uma única vez, então também
+ * vale para executaCompactacaoFluxo; o modo em blocos e as threads são
+ * ignorados.
+ * @param c Ponteiro para o Compactador.
+ * @param tamanhoBloco Bytes por bloco, de TAMANHO_BLOCO_BWT_MINIMO a
+ * TAMANHO_BLOCO_BWT_MAXIMO, ou 0 para não usar a etapa.
+ */
+void defineTamanhoBlocoBWT(Compactador *c, size_t tamanhoBloco);
+
+/**
+ * @brief Compacta com a tabela de um dicionário treinado: a contagem dos
+ * bytes e a tabela do cabeçalho deixam de existir, e o arquivo guarda só o
+ * identificador do dicionário. A entrada é lida uma única vez, e o modo em
+ * blocos, o modelo de contexto, o limite de comprimento e as threads são
+ * ignorados.
+ * @param c Ponteiro para o Compactador.
+ * @param d Dicionário carregado, que precisa existir enquanto o compactador
+ * for usado, ou NULL para voltar à tabela de cada arquivo.
+ */
+void defineDicionario(Compactador *c, const Dicionario *d);
+
+/**
+ * @brief Obtém o tamanho dos dados codificados, em bits, com os códigos da
+ * árvore de Huffman sem limite de comprimento.
+ * @param c Ponteiro para o Compactador (após executaCompactacao).
+ */
+unsigned long long getBitsSemLimite(Compactador *c);
+
+/**
+ * @brief Obtém o tamanho dos dados codificados, em bits, com os códigos
+ * efetivamente usados (iguais a getBitsSemLimite se o limite não atuou).
+ * @param c Ponteiro para o Compactador (após executaCompactacao).
+ */
+unsigned long long getBitsComLimite(Compactador *c);
+
+/**
+ * @brief Obtém as estatísticas da última compactação: tempo de cada fase,
+ * bytes lidos e gravados, entropia, tamanho dos códigos e pico de memória.
+ * @param c Ponteiro para o Compactador (após executaCompactacao).
+ * @return Ponteiro para as estatísticas, válido enquanto o compactador
+ * existir.
+ */
+const Estatisticas *getEstatisticasCompactacao(Compactador *c);
+
 /**
  * @brief Executa todo o processo de compactação.
  * * Esta função orquestra todas as etapas: contagem de frequência,
  * construção da árvore, geração da tabela de códigos e escrita do arquivo
- * final.
+ * final. Uma entrada que não é um arquivo regular (uma pipe nomeada) é lida
+ * em pedaços, como em executaCompactacaoFluxo, e recusada no modelo de
+ * contexto, na etapa LZ77 e com fluxos intercalados.
+ * @param c Ponteiro para o Compactador.
+ * @return 0 em caso de sucesso, -1 se a entrada não puder ser lida ou a
+ * saída não puder ser gravada.
+ */
+int executaCompactacao(Compactador *c);
+
+/**
+ * @brief Compacta um fluxo de entrada para um fluxo de saída em uma única
+ * passada, como em "pg_dump | programa -c - | ssh".
+ *
+ * Como a entrada não pode ser lida duas vezes, ela é dividida em blocos
+ * (de TAMANHO_BLOCO_PADRAO, se nenhum tamanho foi definido), cada um com o
+ * seu próprio histograma, e gravada no formato em blocos sem índice, com o
+ * tamanho antes de cada bloco. A memória usada depende só do tamanho do bloco
+ * e do número de threads. Os fluxos intercalados não se aplicam a esse
+ * formato. O caminho passado a criaCompactador não é usado.
+ *
  * @param c Ponteiro para o Compactador.
+ * @param entrada Fluxo lido até o fim (por exemplo, stdin).
+ * @param saida Fluxo que recebe o arquivo compactado (por exemplo, stdout).
+ * @return 0 em caso de sucesso, -1 em caso de erro de leitura ou gravação.
  */
-void executaCompactacao(Compactador *c);
+int executaCompactacaoFluxo(Compactador *c, FILE *entrada, FILE *saida);
 
 /**
  * @brief Libera toda a memória associada ao compactador.
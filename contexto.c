@@ -0,0 +1,294 @@
+/*
+ *
+ * Modelo de contexto de ordem 1
+ * O código de cada byte é escolhido pelo byte anterior (o contexto). Os 256
+ * contextos são agrupados em poucas tabelas de códigos, reunindo os que têm
+ * distribuições parecidas, para o cabeçalho continuar pequeno
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "contexto.h"
+#include "estatisticas.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_ITERACOES 20
+#define SEM_GRUPO 0xFF
+
+// estimativa do cabeçalho de uma tabela: a parte fixa de escreveComprimentos
+// e alguns bits por símbolo presente
+#define CUSTO_FIXO_TABELA 80
+#define CUSTO_SIMBOLO_TABELA 4
+
+void contaBytesContexto(const unsigned char *dados, size_t n,
+                        unsigned char *anterior,
+                        uint64_t frequencias[][NUM_SIMBOLOS]) {
+  unsigned char contexto = *anterior;
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    uint64_t v;
+    memcpy(&v, dados + i, sizeof(v));
+
+    // trecho que repete o byte anterior: os oito incrementos iriam para o
+    // mesmo contador, um esperando o outro
+    if (v == 0x0101010101010101ULL * contexto) {
+      frequencias[contexto][contexto] += 8;
+      continue;
+    }
+    for (size_t j = 0; j < 8; j++) {
+      frequencias[contexto][dados[i + j]]++;
+      contexto = dados[i + j];
+    }
+  }
+  for (; i < n; i++) {
+    frequencias[contexto][dados[i]]++;
+    contexto = dados[i];
+  }
+  *anterior = contexto;
+}
+
+// Custo, em bits, de cada símbolo no modelo de um grupo: o comprimento ideal
+// com meia ocorrência a mais em cada símbolo, para que os símbolos que o
+// grupo ainda não viu tenham um custo alto, mas finito.
+static void calculaCustos(const uint64_t soma[], double custo[]) {
+  uint64_t total = 0;
+  for (int s = 0; s < NUM_SIMBOLOS; s++) {
+    total += soma[s];
+  }
+
+  double base = log2Inteiro(2 * total + NUM_SIMBOLOS);
+  for (int s = 0; s < NUM_SIMBOLOS; s++) {
+    custo[s] = base - log2Inteiro(2 * soma[s] + 1);
+  }
+}
+
+// bits para codificar o histograma de um contexto com o modelo de um grupo
+static double custoContexto(const uint64_t frequencias[],
+                            const double custo[]) {
+  double bits = 0;
+  for (int s = 0; s < NUM_SIMBOLOS; s++) {
+    bits += (double)frequencias[s] * custo[s];
+  }
+  return bits;
+}
+
+// entropia do histograma de um grupo mais a estimativa do seu cabeçalho
+static double custoGrupo(const uint64_t soma[]) {
+  uint64_t total = 0;
+  double somaFLogF = 0;
+  int presentes = 0;
+  for (int s = 0; s < NUM_SIMBOLOS; s++) {
+    if (soma[s] > 0) {
+      total += soma[s];
+      somaFLogF += (double)soma[s] * log2Inteiro(soma[s]);
+      presentes++;
+    }
+  }
+  if (total == 0) {
+    return 0;
+  }
+  return (double)total * log2Inteiro(total) - somaFLogF + CUSTO_FIXO_TABELA +
+         CUSTO_SIMBOLO_TABELA * presentes;
+}
+
+// bits de cada entrada do mapa
+static int bitsDoMapa(int numTabelas) {
+  int bits = 0;
+  while ((1 << bits) < numTabelas) {
+    bits++;
+  }
+  return bits;
+}
+
+// K-médias com k grupos, em que a distância de um contexto a um grupo é o
+// custo de codificá-lo com o modelo do grupo. As sementes são escolhidas de
+// forma determinística: o contexto mais frequente e, depois, o que mais
+// perderia sendo codificado pelas sementes já escolhidas. Retorna o tamanho
+// estimado, em bits, e a quantidade de grupos não vazios em *numGrupos.
+static double agrupaEmK(const uint64_t frequencias[][NUM_SIMBOLOS],
+                        const uint64_t totais[], int k,
+                        unsigned char grupo[], int *numGrupos) {
+  double(*custos)[NUM_SIMBOLOS] = malloc(k * sizeof(*custos));
+  uint64_t(*somas)[NUM_SIMBOLOS] = malloc(k * sizeof(*somas));
+  double *melhor = malloc(NUM_CONTEXTOS * sizeof(double));
+  double *proprio = malloc(NUM_CONTEXTOS * sizeof(double));
+  if (custos == NULL || somas == NULL || melhor == NULL || proprio == NULL) {
+    exit(1);
+  }
+
+  int maior = 0;
+  for (int c = 1; c < NUM_CONTEXTOS; c++) {
+    if (totais[c] > totais[maior]) {
+      maior = c;
+    }
+  }
+
+  int sementes = 1;
+  calculaCustos(frequencias[maior], custos[0]);
+  for (int c = 0; c < NUM_CONTEXTOS; c++) {
+    if (totais[c] > 0) {
+      double proprios[NUM_SIMBOLOS];
+      calculaCustos(frequencias[c], proprios);
+      proprio[c] = custoContexto(frequencias[c], proprios);
+      melhor[c] = custoContexto(frequencias[c], custos[0]);
+    }
+  }
+
+  while (sementes < k) {
+    int escolhido = -1;
+    double maiorPerda = 1; // ao menos um bit, para não repetir sementes
+    for (int c = 0; c < NUM_CONTEXTOS; c++) {
+      if (totais[c] > 0 && melhor[c] - proprio[c] > maiorPerda) {
+        maiorPerda = melhor[c] - proprio[c];
+        escolhido = c;
+      }
+    }
+    if (escolhido < 0) {
+      break;
+    }
+
+    calculaCustos(frequencias[escolhido], custos[sementes]);
+    for (int c = 0; c < NUM_CONTEXTOS; c++) {
+      if (totais[c] > 0) {
+        double bits = custoContexto(frequencias[c], custos[sementes]);
+        if (bits < melhor[c]) {
+          melhor[c] = bits;
+        }
+      }
+    }
+    sementes++;
+  }
+
+  // alterna entre levar cada contexto ao grupo mais barato e refazer os
+  // modelos dos grupos, até nenhum contexto mudar de grupo
+  memset(grupo, SEM_GRUPO, NUM_CONTEXTOS);
+  for (int iteracao = 0; iteracao < MAX_ITERACOES; iteracao++) {
+    int mudou = 0;
+    for (int c = 0; c < NUM_CONTEXTOS; c++) {
+      if (totais[c] == 0) {
+        continue;
+      }
+      int escolhido = 0;
+      double menor = custoContexto(frequencias[c], custos[0]);
+      for (int g = 1; g < sementes; g++) {
+        double bits = custoContexto(frequencias[c], custos[g]);
+        if (bits < menor) {
+          menor = bits;
+          escolhido = g;
+        }
+      }
+      if (grupo[c] != escolhido) {
+        grupo[c] = (unsigned char)escolhido;
+        mudou = 1;
+      }
+    }
+
+    memset(somas, 0, sementes * sizeof(*somas));
+    for (int c = 0; c < NUM_CONTEXTOS; c++) {
+      if (totais[c] > 0) {
+        for (int s = 0; s < NUM_SIMBOLOS; s++) {
+          somas[grupo[c]][s] += frequencias[c][s];
+        }
+      }
+    }
+    if (!mudou) {
+      break;
+    }
+    for (int g = 0; g < sementes; g++) {
+      calculaCustos(somas[g], custos[g]);
+    }
+  }
+
+  // renumera os grupos não vazios pela ordem do primeiro contexto; os
+  // contextos que não aparecem ficam com o grupo 0
+  int novo[MAX_TABELAS_CONTEXTO];
+  int usados = 0;
+  for (int g = 0; g < sementes; g++) {
+    novo[g] = -1;
+  }
+  for (int c = 0; c < NUM_CONTEXTOS; c++) {
+    if (totais[c] > 0 && novo[grupo[c]] < 0) {
+      novo[grupo[c]] = usados++;
+    }
+  }
+
+  double bits = 4;
+  for (int g = 0; g < sementes; g++) {
+    if (novo[g] >= 0) {
+      bits += custoGrupo(somas[g]);
+    }
+  }
+  bits += (double)NUM_CONTEXTOS * bitsDoMapa(usados);
+
+  for (int c = 0; c < NUM_CONTEXTOS; c++) {
+    grupo[c] = totais[c] > 0 ? (unsigned char)novo[grupo[c]] : 0;
+  }
+  *numGrupos = usados;
+
+  free(custos);
+  free(somas);
+  free(melhor);
+  free(proprio);
+
+  return bits;
+}
+
+int agrupaContextos(const uint64_t frequencias[][NUM_SIMBOLOS],
+                    unsigned char grupo[NUM_CONTEXTOS]) {
+  uint64_t totais[NUM_CONTEXTOS];
+  for (int c = 0; c < NUM_CONTEXTOS; c++) {
+    totais[c] = 0;
+    for (int s = 0; s < NUM_SIMBOLOS; s++) {
+      totais[c] += frequencias[c][s];
+    }
+  }
+
+  int numTabelas = 0;
+  double menor = 0;
+  for (int k = 1; k <= MAX_TABELAS_CONTEXTO; k *= 2) {
+    unsigned char candidato[NUM_CONTEXTOS];
+    int numGrupos;
+    double bits = agrupaEmK(frequencias, totais, k, candidato, &numGrupos);
+    if (numTabelas == 0 || bits < menor) {
+      menor = bits;
+      numTabelas = numGrupos;
+      memcpy(grupo, candidato, NUM_CONTEXTOS);
+    }
+
+    // sem sementes novas, mais grupos dariam o mesmo resultado
+    if (numGrupos < k) {
+      break;
+    }
+  }
+
+  return numTabelas;
+}
+
+void escreveMapaContextos(bitmap *bm, const unsigned char grupo[],
+                          int numTabelas) {
+  bitmapAppendBits(bm, numTabelas - 1, 4);
+
+  // com uma única tabela o mapa é implícito
+  int bits = bitsDoMapa(numTabelas);
+  if (bits > 0) {
+    for (int c = 0; c < NUM_CONTEXTOS; c++) {
+      bitmapAppendBits(bm, grupo[c], bits);
+    }
+  }
+}
+
+int leMapaContextos(LeitorBits *l, unsigned char grupo[NUM_CONTEXTOS],
+                    int *numTabelas) {
+  *numTabelas = (int)leBits(l, 4) + 1;
+
+  int bits = bitsDoMapa(*numTabelas);
+  for (int c = 0; c < NUM_CONTEXTOS; c++) {
+    grupo[c] = bits > 0 ? (unsigned char)leBits(l, bits) : 0;
+    if (grupo[c] >= *numTabelas) {
+      return -1;
+    }
+  }
+
+  return leitorEstourou(l) ? -1 : 0;
+}
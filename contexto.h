@@ -0,0 +1,71 @@
+/*
+ *
+ * Modelo de contexto de ordem 1
+ * O código de cada byte é escolhido pelo byte anterior (o contexto). Os 256
+ * contextos são agrupados em poucas tabelas de códigos, reunindo os que têm
+ * distribuições parecidas, para o cabeçalho continuar pequeno
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef CONTEXTO_H
+#define CONTEXTO_H
+
+#include "bitmap.h"
+#include "huffman.h"
+#include "leitor.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// versão com o modelo de contexto: assinatura, versão, mapa dos contextos,
+// comprimentos de cada tabela e os códigos, terminados pelo símbolo EOF
+#define VERSAO_CONTEXTO 6
+
+// um contexto por valor do byte anterior; o primeiro byte usa o contexto 0
+#define NUM_CONTEXTOS 256
+
+#define MAX_TABELAS_CONTEXTO 16
+
+/**
+ * @brief Conta cada byte no histograma do seu contexto. Pode ser chamada em
+ * pedaços consecutivos da entrada.
+ * @param dados Bytes a contar.
+ * @param n Quantidade de bytes.
+ * @param anterior Contexto do primeiro byte; recebe o último byte contado.
+ * @param frequencias Histogramas dos contextos, incrementados.
+ */
+void contaBytesContexto(const unsigned char *dados, size_t n,
+                        unsigned char *anterior,
+                        uint64_t frequencias[][NUM_SIMBOLOS]);
+
+/**
+ * @brief Agrupa os contextos em até MAX_TABELAS_CONTEXTO tabelas. Testa 1, 2,
+ * 4, 8 e 16 grupos e fica com a quantidade de menor tamanho estimado, somando
+ * a entropia de cada grupo ao custo do seu cabeçalho.
+ * @param frequencias Histogramas dos contextos (o EOF incluído).
+ * @param grupo Recebe a tabela de cada contexto.
+ * @return Quantidade de tabelas.
+ */
+int agrupaContextos(const uint64_t frequencias[][NUM_SIMBOLOS],
+                    unsigned char grupo[NUM_CONTEXTOS]);
+
+/**
+ * @brief Escreve a quantidade de tabelas e a tabela de cada contexto.
+ * @param bm Bitmap de destino.
+ * @param grupo Tabela de cada contexto.
+ * @param numTabelas Quantidade de tabelas (1 a MAX_TABELAS_CONTEXTO).
+ */
+void escreveMapaContextos(bitmap *bm, const unsigned char grupo[],
+                          int numTabelas);
+
+/**
+ * @brief Lê o mapa escrito por escreveMapaContextos.
+ * @param l Leitor de bits.
+ * @param grupo Recebe a tabela de cada contexto.
+ * @param numTabelas Recebe a quantidade de tabelas.
+ * @return 0 em caso de sucesso, -1 se o mapa for inválido.
+ */
+int leMapaContextos(LeitorBits *l, unsigned char grupo[NUM_CONTEXTOS],
+                    int *numTabelas);
+
+#endif // CONTEXTO_H
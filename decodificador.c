@@ -0,0 +1,711 @@
+/*
+ *
+ * Tad TabelaDecodificacao
+ * Tabelas de consulta que resolvem um símbolo inteiro por acesso, indexadas
+ * pelos próximos bits do fluxo compactado
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "decodificador.h"
+#include "bwt.h"
+#include "huffman.h"
+#include "lz77.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BITS_TABELA_PRINCIPAL 11
+#define BITS_TABELA_SECUNDARIA 11
+#define TAMANHO_BUFFER_SAIDA (64 * 1024)
+
+// cada entrada guarda (valor << 9) | ligação << 8 | bits, onde valor é o
+// símbolo (folha) ou o início da tabela seguinte (ligação) e bits é quantos
+// bits a folha consome ou quantos bits indexam a tabela seguinte
+#define ENTRADA_LIGACAO 0x100u
+#define entradaValor(e) ((e) >> 9)
+#define entradaBits(e) ((e)&0xFFu)
+
+typedef struct {
+  uint64_t codigo;
+  int comprimento;
+  int simbolo;
+} CodigoSimbolo;
+
+struct tabelaDecodificacao {
+  uint32_t *entradas;
+  size_t quantidade; // entradas já reservadas
+  size_t capacidade;
+  unsigned int bitsPrincipais;
+  int simboloUnico; // símbolo de um código com uma única folha, ou -1
+};
+
+// reserva n entradas zeradas no fim do vetor, com o índice da primeira em
+// 'inicio'; retorna -1 se faltar memória
+static int reservaEntradas(TabelaDecodificacao *t, size_t n, size_t *inicio) {
+  if (t->quantidade + n > t->capacidade) {
+    size_t novaCapacidade = t->capacidade ? t->capacidade : 4096;
+    while (novaCapacidade < t->quantidade + n) {
+      novaCapacidade *= 2;
+    }
+    uint32_t *entradas =
+        realloc(t->entradas, novaCapacidade * sizeof(uint32_t));
+    if (entradas == NULL) {
+      return -1;
+    }
+    t->entradas = entradas;
+    t->capacidade = novaCapacidade;
+  }
+
+  *inicio = t->quantidade;
+  for (size_t i = 0; i < n; i++) {
+    t->entradas[*inicio + i] = 0;
+  }
+  t->quantidade += n;
+
+  return 0;
+}
+
+// extrai n bits do código, começando 'base' bits após o seu início
+static uint32_t bitsDoCodigo(const CodigoSimbolo *c, int base, int n) {
+  return (uint32_t)(c->codigo >> (c->comprimento - base - n)) &
+         ((1u << n) - 1);
+}
+
+// preenche a tabela com 'bits' bits que começa em 'inicio', responsável pelos
+// códigos [lo, hi) que compartilham os 'base' primeiros bits. Os códigos
+// precisam estar em ordem lexicográfica. Retorna -1 se faltar memória.
+static int preencheTabela(TabelaDecodificacao *t, size_t inicio, int bits,
+                           int base, const CodigoSimbolo *c, int lo, int hi) {
+  int i = lo;
+  while (i < hi) {
+    int resto = c[i].comprimento - base;
+
+    if (resto <= bits) {
+      // código curto: ocupa todas as entradas que começam com ele
+      uint32_t primeira = bitsDoCodigo(&c[i], base, resto) << (bits - resto);
+      uint32_t repeticoes = 1u << (bits - resto);
+      uint32_t entrada = ((uint32_t)c[i].simbolo << 9) | (uint32_t)resto;
+      for (uint32_t k = 0; k < repeticoes; k++) {
+        t->entradas[inicio + primeira + k] = entrada;
+      }
+      i++;
+    } else {
+      // código longo: agrupa os códigos com o mesmo prefixo nesta tabela
+      uint32_t prefixo = bitsDoCodigo(&c[i], base, bits);
+      int maiorComprimento = c[i].comprimento;
+      int j = i + 1;
+      while (j < hi && c[j].comprimento - base > bits &&
+             bitsDoCodigo(&c[j], base, bits) == prefixo) {
+        if (c[j].comprimento > maiorComprimento) {
+          maiorComprimento = c[j].comprimento;
+        }
+        j++;
+      }
+
+      int subBits = maiorComprimento - base - bits;
+      if (subBits > BITS_TABELA_SECUNDARIA) {
+        subBits = BITS_TABELA_SECUNDARIA;
+      }
+
+      size_t sub;
+      if (reservaEntradas(t, (size_t)1 << subBits, &sub) != 0) {
+        return -1;
+      }
+      t->entradas[inicio + prefixo] =
+          ((uint32_t)sub << 9) | ENTRADA_LIGACAO | (uint32_t)subBits;
+      if (preencheTabela(t, sub, subBits, base + bits, c, i, j) != 0) {
+        return -1;
+      }
+      i = j;
+    }
+  }
+
+  return 0;
+}
+
+TabelaDecodificacao *criaTabelaDecodificacao(void) {
+  TabelaDecodificacao *t = calloc(1, sizeof(TabelaDecodificacao));
+  if (t == NULL) {
+    return NULL;
+  }
+  t->simboloUnico = -1;
+
+  // espaço para a tabela principal e algumas secundárias, o bastante para
+  // os códigos comuns não precisarem de mais
+  size_t inicio;
+  if (reservaEntradas(t, 4096, &inicio) != 0) {
+    free(t);
+    return NULL;
+  }
+  t->quantidade = 0;
+
+  return t;
+}
+
+// monta as tabelas a partir de códigos em ordem lexicográfica, reaproveitando
+// as entradas já alocadas; retorna -1 se os códigos forem inválidos ou se
+// faltar memória
+static int montaTabelaDosCodigos(TabelaDecodificacao *t,
+                                 const CodigoSimbolo *c, int n) {
+  t->quantidade = 0;
+  t->bitsPrincipais = 0;
+  t->simboloUnico = -1;
+  if (n == 0) {
+    return -1;
+  }
+
+  // árvore só com a raiz: o símbolo é implícito e não ocupa bits
+  if (n == 1 && c[0].comprimento == 0) {
+    t->simboloUnico = c[0].simbolo;
+    return 0;
+  }
+
+  // código canônico com um único símbolo de 1 bit: os dois valores do bit
+  // levam ao mesmo símbolo
+  size_t principal;
+  if (n == 1 && c[0].comprimento == 1) {
+    t->bitsPrincipais = 1;
+    if (reservaEntradas(t, 2, &principal) != 0) {
+      return -1;
+    }
+    t->entradas[principal] = t->entradas[principal + 1] =
+        ((uint32_t)c[0].simbolo << 9) | 1u;
+    return 0;
+  }
+
+  int maiorComprimento = 0;
+  for (int i = 0; i < n; i++) {
+    if (c[i].comprimento > maiorComprimento) {
+      maiorComprimento = c[i].comprimento;
+    }
+  }
+
+  t->bitsPrincipais = maiorComprimento < BITS_TABELA_PRINCIPAL
+                          ? maiorComprimento
+                          : BITS_TABELA_PRINCIPAL;
+
+  if (reservaEntradas(t, (size_t)1 << t->bitsPrincipais, &principal) != 0 ||
+      preencheTabela(t, principal, t->bitsPrincipais, 0, c, 0, n) != 0) {
+    return -1;
+  }
+
+  // entradas que sobraram zeradas indicam um código incompleto
+  for (size_t i = 0; i < t->quantidade; i++) {
+    if (entradaBits(t->entradas[i]) == 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static TabelaDecodificacao *criaTabelaDosCodigos(const CodigoSimbolo *c,
+                                                 int n) {
+  TabelaDecodificacao *t = criaTabelaDecodificacao();
+  if (t != NULL && montaTabelaDosCodigos(t, c, n) != 0) {
+    liberaTabelaDecodificacao(t);
+    return NULL;
+  }
+
+  return t;
+}
+
+// nó pendente no percurso da árvore compacta
+typedef struct {
+  uint16_t ref;
+  int profundidade;
+  uint64_t codigo;
+} NoPendente;
+
+TabelaDecodificacao *criaTabelaDaArvore(const ArvoreCompacta *arvore) {
+  CodigoSimbolo codigos[NUM_SIMBOLOS];
+  int n = 0;
+
+  // percorre a árvore em pré-ordem (esquerda antes da direita), o que já
+  // produz as folhas em ordem lexicográfica de código. Cada nó interno
+  // empilha os dois filhos, então a pilha nunca passa de um a mais que o
+  // número de nós
+  NoPendente pilha[MAX_NOS_COMPACTOS + 1];
+  int topo = 0;
+  pilha[topo++] = (NoPendente){arvore->raiz, 0, 0};
+
+  while (topo > 0) {
+    NoPendente p = pilha[--topo];
+
+    if (ehFolhaCompacta(p.ref)) {
+      if (n == NUM_SIMBOLOS) {
+        return NULL;
+      }
+      codigos[n].codigo = p.codigo;
+      codigos[n].comprimento = p.profundidade;
+      codigos[n].simbolo = simboloCompacto(p.ref);
+      n++;
+      continue;
+    }
+
+    if (p.profundidade == MAX_COMPRIMENTO_CODIGO ||
+        p.ref >= arvore->numNos) {
+      return NULL;
+    }
+
+    // a direita entra antes para que a esquerda saia primeiro
+    pilha[topo++] = (NoPendente){filhoCompacto(arvore, p.ref, 1),
+                                 p.profundidade + 1, (p.codigo << 1) | 1};
+    pilha[topo++] = (NoPendente){filhoCompacto(arvore, p.ref, 0),
+                                 p.profundidade + 1, p.codigo << 1};
+  }
+
+  return criaTabelaDosCodigos(codigos, n);
+}
+
+int remontaTabelaDosComprimentos(TabelaDecodificacao *t,
+                                 const unsigned char comprimentos[], int n) {
+  uint64_t codigos[MAX_SIMBOLOS_ALFABETO];
+  CodigoSimbolo ordenados[MAX_SIMBOLOS_ALFABETO];
+  if (n > MAX_SIMBOLOS_ALFABETO ||
+      geraCodigosCanonicos(comprimentos, n, codigos) != 0) {
+    return -1;
+  }
+
+  // na ordem canônica (comprimento, símbolo) os códigos já ficam em ordem
+  // lexicográfica
+  int total = 0;
+  for (int comp = 1; comp <= MAX_COMPRIMENTO_CODIGO; comp++) {
+    for (int i = 0; i < n; i++) {
+      if (comprimentos[i] == comp) {
+        ordenados[total].codigo = codigos[i];
+        ordenados[total].comprimento = comp;
+        ordenados[total].simbolo = i;
+        total++;
+      }
+    }
+  }
+
+  return montaTabelaDosCodigos(t, ordenados, total);
+}
+
+TabelaDecodificacao *criaTabelaDosComprimentos(const unsigned char comprimentos[],
+                                               int n) {
+  TabelaDecodificacao *t = criaTabelaDecodificacao();
+  if (t != NULL && remontaTabelaDosComprimentos(t, comprimentos, n) != 0) {
+    liberaTabelaDecodificacao(t);
+    return NULL;
+  }
+
+  return t;
+}
+
+// segue as ligações até uma folha; caminho raro, só para códigos longos
+static uint32_t resolveLigacao(const uint32_t *entradas, uint32_t entrada,
+                               unsigned int bits, LeitorBits *l) {
+  do {
+    consomeBits(l, bits);
+    recarregaLeitor(l);
+    bits = entradaBits(entrada);
+    entrada = entradas[entradaValor(entrada) + espiaBits(l, bits)];
+  } while (entrada & ENTRADA_LIGACAO);
+
+  return entrada;
+}
+
+// resolve o próximo símbolo de um fluxo com uma consulta na tabela principal
+static inline uint32_t proximoSimbolo(const uint32_t *entradas,
+                                      unsigned int bitsPrincipais,
+                                      LeitorBits *l) {
+  recarregaLeitor(l);
+  uint32_t entrada = entradas[espiaBits(l, bitsPrincipais)];
+  if (entrada & ENTRADA_LIGACAO) {
+    entrada = resolveLigacao(entradas, entrada, bitsPrincipais, l);
+  }
+  consomeBits(l, entradaBits(entrada));
+
+  return entradaValor(entrada);
+}
+
+int decodificaSimbolo(TabelaDecodificacao *t, LeitorBits *l) {
+  if (t->simboloUnico >= 0) {
+    return t->simboloUnico;
+  }
+
+  return (int)proximoSimbolo(t->entradas, t->bitsPrincipais, l);
+}
+
+int decodificaAteEOF(TabelaDecodificacao *t, LeitorBits *l, FILE *saida) {
+  if (t->simboloUnico >= 0) {
+    // só o EOF existe: arquivo original vazio
+    return t->simboloUnico == SIMBOLO_EOF ? 0 : -1;
+  }
+
+  unsigned char *buffer = malloc(TAMANHO_BUFFER_SAIDA);
+  if (buffer == NULL) {
+    exit(1);
+  }
+
+  const uint32_t *entradas = t->entradas;
+  unsigned int bitsPrincipais = t->bitsPrincipais;
+  size_t n = 0;
+  int resultado = 0;
+
+  for (;;) {
+    uint32_t simbolo = proximoSimbolo(entradas, bitsPrincipais, l);
+    if (simbolo == SIMBOLO_EOF) {
+      break;
+    }
+
+    buffer[n++] = (unsigned char)simbolo;
+    if (n == TAMANHO_BUFFER_SAIDA) {
+      fwrite(buffer, 1, n, saida);
+      n = 0;
+      // um fluxo sem EOF acabaria decodificando os zeros de preenchimento
+      if (leitorEstourou(l)) {
+        resultado = -1;
+        break;
+      }
+    }
+  }
+
+  if (leitorEstourou(l)) {
+    resultado = -1;
+  }
+
+  fwrite(buffer, 1, n, saida);
+  free(buffer);
+
+  return resultado;
+}
+
+int decodificaContextoAteEOF(TabelaDecodificacao *const tabelas[],
+                             const unsigned char grupo[], LeitorBits *l,
+                             FILE *saida) {
+  // as tabelas dos comprimentos sempre consomem bits; uma sem bits poderia
+  // repetir o mesmo símbolo para sempre
+  TabelaDecodificacao *doContexto[256];
+  for (int c = 0; c < 256; c++) {
+    doContexto[c] = tabelas[grupo[c]];
+    if (doContexto[c]->simboloUnico >= 0) {
+      return -1;
+    }
+  }
+
+  unsigned char *buffer = malloc(TAMANHO_BUFFER_SAIDA);
+  if (buffer == NULL) {
+    exit(1);
+  }
+
+  const TabelaDecodificacao *t = doContexto[0];
+  size_t n = 0;
+  int resultado = 0;
+
+  for (;;) {
+    uint32_t simbolo = proximoSimbolo(t->entradas, t->bitsPrincipais, l);
+    if (simbolo == SIMBOLO_EOF) {
+      break;
+    }
+
+    // o símbolo decodificado escolhe a tabela do próximo
+    t = doContexto[simbolo];
+    buffer[n++] = (unsigned char)simbolo;
+    if (n == TAMANHO_BUFFER_SAIDA) {
+      fwrite(buffer, 1, n, saida);
+      n = 0;
+      if (leitorEstourou(l)) {
+        resultado = -1;
+        break;
+      }
+    }
+  }
+
+  if (leitorEstourou(l)) {
+    resultado = -1;
+  }
+
+  fwrite(buffer, 1, n, saida);
+  free(buffer);
+
+  return resultado;
+}
+
+// copia o trecho de uma cópia LZ77; a área de destino tem folga para que
+// as palavras de 8 bytes passem do fim
+static inline void copiaLZ(unsigned char *destino, size_t distancia,
+                           size_t comprimento) {
+  const unsigned char *origem = destino - distancia;
+  if (distancia >= 8) {
+    // as palavras só se sobrepõem a bytes que já foram copiados
+    for (size_t i = 0; i < comprimento; i += 8) {
+      memcpy(destino + i, origem + i, 8);
+    }
+  } else {
+    for (size_t i = 0; i < comprimento; i++) {
+      destino[i] = origem[i];
+    }
+  }
+}
+
+int decodificaBlocoLZ(TabelaDecodificacao *literais,
+                      TabelaDecodificacao *distancias, LeitorBits *l,
+                      unsigned char *buffer, size_t inicio, size_t n) {
+  if (literais->simboloUnico >= 0 ||
+      (distancias != NULL && distancias->simboloUnico >= 0)) {
+    return -1;
+  }
+
+  const uint32_t *entradas = literais->entradas;
+  unsigned int bitsPrincipais = literais->bitsPrincipais;
+  unsigned char *destino = buffer + inicio;
+  size_t k = 0; // bytes já produzidos no bloco
+
+  // cada volta produz ao menos um byte ou termina, então um fluxo
+  // corrompido não passa do fim do bloco
+  for (;;) {
+    uint32_t simbolo = proximoSimbolo(entradas, bitsPrincipais, l);
+    if (simbolo < SIMBOLO_EOF) {
+      if (k == n) {
+        return -1;
+      }
+      destino[k++] = (unsigned char)simbolo;
+    } else if (simbolo == SIMBOLO_EOF) {
+      break;
+    } else {
+      unsigned int classe = simbolo - PRIMEIRO_COMPRIMENTO_LZ;
+      if (classe >= NUM_CLASSES_COMPRIMENTO || distancias == NULL) {
+        return -1;
+      }
+      unsigned int extras = bitsExtrasDaClasse(classe);
+      size_t comprimento = COMPRIMENTO_MINIMO_LZ + baseDaClasse(classe) +
+                           (extras > 0 ? leBits(l, extras) : 0);
+
+      classe = proximoSimbolo(distancias->entradas,
+                              distancias->bitsPrincipais, l);
+      extras = bitsExtrasDaClasse(classe);
+      size_t distancia =
+          1 + baseDaClasse(classe) + (extras > 0 ? leBits(l, extras) : 0);
+
+      // as cópias alcançam os blocos anteriores ainda no buffer, mas não
+      // passam do fim do bloco
+      if (classe >= NUM_DISTANCIAS_LZ || distancia > inicio + k ||
+          comprimento > n - k) {
+        return -1;
+      }
+      copiaLZ(destino + k, distancia, comprimento);
+      k += comprimento;
+    }
+  }
+
+  return k == n && !leitorEstourou(l) ? 0 : -1;
+}
+
+int decodificaMTF(TabelaDecodificacao *t, LeitorBits *l,
+                  unsigned char *destino, uint32_t n) {
+  if (t->simboloUnico >= 0) {
+    return -1;
+  }
+
+  const uint32_t *entradas = t->entradas;
+  unsigned int bitsPrincipais = t->bitsPrincipais;
+  unsigned char ordem[256];
+  for (int c = 0; c < 256; c++) {
+    ordem[c] = (unsigned char)c;
+  }
+
+  uint32_t k = 0;       // bytes já produzidos
+  uint32_t corrida = 0; // zeros da corrida em andamento
+  uint32_t peso = 1;    // valor do próximo dígito da corrida
+  for (;;) {
+    uint32_t simbolo = proximoSimbolo(entradas, bitsPrincipais, l);
+    if (simbolo <= CORRIDA_B) {
+      // a corrida nunca passa do que falta no bloco, então o peso também
+      // não cresce além dele
+      corrida += (simbolo + 1) * peso;
+      peso <<= 1;
+      if (corrida > n - k) {
+        return -1;
+      }
+      continue;
+    }
+
+    if (corrida > 0) {
+      memset(destino + k, ordem[0], corrida);
+      k += corrida;
+      corrida = 0;
+    }
+    peso = 1;
+    if (simbolo == FIM_BLOCO_BWT) {
+      break;
+    }
+    if (simbolo > FIM_BLOCO_BWT || k == n) {
+      return -1;
+    }
+
+    // as posições pequenas são as mais comuns, e o laço curto sai mais
+    // barato que uma chamada de memmove
+    unsigned int j = simbolo - 1;
+    unsigned char c = ordem[j];
+    for (; j > 0; j--) {
+      ordem[j] = ordem[j - 1];
+    }
+    ordem[0] = c;
+    destino[k++] = c;
+  }
+
+  return k != n || leitorEstourou(l) ? -1 : 0;
+}
+
+int decodificaSimbolos(TabelaDecodificacao *t, LeitorBits *l,
+                       unsigned char *destino, size_t n) {
+  const uint32_t *entradas = t->entradas;
+  unsigned int bitsPrincipais = t->bitsPrincipais;
+
+  if (t->simboloUnico >= 0) {
+    return -1;
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    destino[i] = (unsigned char)proximoSimbolo(entradas, bitsPrincipais, l);
+  }
+
+  return leitorEstourou(l) ? -1 : 0;
+}
+
+// recarga sem conferir o fim da entrada: quem chama garante que há ao menos
+// 8 bytes a partir de l->pos
+static inline void recarregaSemConferir(LeitorBits *l) {
+  const unsigned char *p = l->pos;
+  uint64_t v = ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+               ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+               ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+               ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+  l->buffer |= v >> l->bitsNoBuffer;
+  l->pos += (63 - l->bitsNoBuffer) >> 3;
+  l->bitsNoBuffer |= 56;
+}
+
+static inline unsigned char simboloSemConferir(const uint32_t *entradas,
+                                               unsigned int bitsPrincipais,
+                                               LeitorBits *l) {
+  recarregaSemConferir(l);
+  uint32_t entrada = entradas[espiaBits(l, bitsPrincipais)];
+  if (entrada & ENTRADA_LIGACAO) {
+    entrada = resolveLigacao(entradas, entrada, bitsPrincipais, l);
+  }
+  consomeBits(l, entradaBits(entrada));
+
+  return (unsigned char)entradaValor(entrada);
+}
+
+// quantas rodadas (um símbolo de cada fluxo) podem ser decodificadas sem
+// conferir o fim de nenhum fluxo. Um símbolo consome no máximo 8 bytes e a
+// recarga lê 8 bytes a partir de no máximo 8 bytes depois do que já foi
+// consumido, então cada fluxo precisa de 8 bytes por rodada mais 16 de folga
+static size_t rodadasSeguras(const LeitorBits leitores[], int numFluxos) {
+  size_t rodadas = SIZE_MAX;
+  for (int j = 0; j < numFluxos; j++) {
+    size_t folga = (size_t)(leitores[j].fim - leitores[j].pos);
+    if (folga < 16) {
+      return 0;
+    }
+    if ((folga - 16) / 8 + 1 < rodadas) {
+      rodadas = (folga - 16) / 8 + 1;
+    }
+  }
+  return rodadas;
+}
+
+// quatro fluxos, o caso padrão: os leitores ficam em variáveis locais para
+// que o compilador os mantenha em registradores e as quatro decodificações,
+// independentes entre si, se sobreponham no processador
+static void decodificaQuatroFluxos(const uint32_t *entradas,
+                                   unsigned int bitsPrincipais,
+                                   LeitorBits leitores[],
+                                   unsigned char *destino, size_t n) {
+  size_t i = 0;
+  for (;;) {
+    size_t rodadas = rodadasSeguras(leitores, 4);
+    if (rodadas > (n - i) / 4) {
+      rodadas = (n - i) / 4;
+    }
+    if (rodadas == 0) {
+      break;
+    }
+
+    LeitorBits a = leitores[0];
+    LeitorBits b = leitores[1];
+    LeitorBits c = leitores[2];
+    LeitorBits d = leitores[3];
+    unsigned char *p = destino + i;
+    unsigned char *fim = p + 4 * rodadas;
+
+    for (; p < fim; p += 4) {
+      p[0] = simboloSemConferir(entradas, bitsPrincipais, &a);
+      p[1] = simboloSemConferir(entradas, bitsPrincipais, &b);
+      p[2] = simboloSemConferir(entradas, bitsPrincipais, &c);
+      p[3] = simboloSemConferir(entradas, bitsPrincipais, &d);
+    }
+
+    leitores[0] = a;
+    leitores[1] = b;
+    leitores[2] = c;
+    leitores[3] = d;
+    i += 4 * rodadas;
+  }
+
+  // perto do fim dos fluxos, com as conferências de sempre
+  for (; i < n; i++) {
+    destino[i] = (unsigned char)proximoSimbolo(entradas, bitsPrincipais,
+                                               &leitores[i % 4]);
+  }
+}
+
+int decodificaSimbolosIntercalados(TabelaDecodificacao *t,
+                                   LeitorBits leitores[], int numFluxos,
+                                   unsigned char *destino, size_t n) {
+  const uint32_t *entradas = t->entradas;
+  unsigned int bitsPrincipais = t->bitsPrincipais;
+
+  if (t->simboloUnico >= 0) {
+    return -1;
+  }
+
+  if (numFluxos == 4) {
+    decodificaQuatroFluxos(entradas, bitsPrincipais, leitores, destino, n);
+  } else {
+    // o símbolo i está no fluxo i % numFluxos
+    size_t i = 0;
+    size_t k = (size_t)numFluxos;
+    for (;;) {
+      size_t rodadas = rodadasSeguras(leitores, numFluxos);
+      if (rodadas > (n - i) / k) {
+        rodadas = (n - i) / k;
+      }
+      if (rodadas == 0) {
+        break;
+      }
+      for (size_t r = 0; r < rodadas; r++) {
+        for (int j = 0; j < numFluxos; j++, i++) {
+          destino[i] =
+              simboloSemConferir(entradas, bitsPrincipais, &leitores[j]);
+        }
+      }
+    }
+    for (; i < n; i++) {
+      destino[i] = (unsigned char)proximoSimbolo(entradas, bitsPrincipais,
+                                                 &leitores[i % k]);
+    }
+  }
+
+  for (int j = 0; j < numFluxos; j++) {
+    if (leitorEstourou(&leitores[j])) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+void liberaTabelaDecodificacao(TabelaDecodificacao *t) {
+  if (t != NULL) {
+    free(t->entradas);
+    free(t);
+  }
+}
@@ -0,0 +1,166 @@
+/*
+ *
+ * Tad TabelaDecodificacao
+ * Tabelas de consulta que resolvem um símbolo inteiro por acesso, indexadas
+ * pelos próximos bits do fluxo compactado
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef DECODIFICADOR_H
+#define DECODIFICADOR_H
+
+#include "arvore.h"
+#include "leitor.h"
+#include <stdio.h>
+
+typedef struct tabelaDecodificacao TabelaDecodificacao;
+
+/**
+ * @brief Constrói as tabelas de decodificação a partir da árvore de Huffman
+ * em formato compacto.
+ *
+ * A tabela principal é indexada pelos próximos bits do fluxo (até 11) e
+ * resolve diretamente os códigos curtos. Códigos mais longos apontam para
+ * tabelas secundárias indexadas pelos bits seguintes.
+ *
+ * @param arvore Árvore reconstruída do cabeçalho.
+ * @return Ponteiro para a nova tabela, ou NULL se a árvore for inválida.
+ */
+TabelaDecodificacao *criaTabelaDaArvore(const ArvoreCompacta *arvore);
+
+/**
+ * @brief Constrói as tabelas de decodificação só a partir dos comprimentos
+ * dos códigos canônicos, sem montar uma árvore.
+ * @param comprimentos Comprimento do código de cada símbolo (0 = ausente).
+ * @param n Quantidade de símbolos do alfabeto.
+ * @return Ponteiro para a nova tabela, ou NULL se os comprimentos não
+ * formarem um código válido.
+ */
+TabelaDecodificacao *criaTabelaDosComprimentos(const unsigned char comprimentos[],
+                                               int n);
+
+/**
+ * @brief Cria uma tabela vazia, para ser montada com
+ * remontaTabelaDosComprimentos e reaproveitada: quem decodifica muitos
+ * blocos aloca a tabela uma vez.
+ * @return Ponteiro para a nova tabela, ou NULL se faltar memória.
+ */
+TabelaDecodificacao *criaTabelaDecodificacao(void);
+
+/**
+ * @brief Monta de novo uma tabela a partir dos comprimentos, reaproveitando
+ * as entradas já alocadas; só aloca se o novo código precisar de mais
+ * entradas que todos os anteriores.
+ * @param t Tabela criada por criaTabelaDecodificacao (ou por outra função de
+ * criação).
+ * @param comprimentos Comprimento do código de cada símbolo (0 = ausente).
+ * @param n Quantidade de símbolos do alfabeto.
+ * @return 0 em caso de sucesso, -1 se os comprimentos não formarem um código
+ * válido ou se faltar memória.
+ */
+int remontaTabelaDosComprimentos(TabelaDecodificacao *t,
+                                 const unsigned char comprimentos[], int n);
+
+/**
+ * @brief Decodifica um único símbolo. Usada fora do laço principal, como na
+ * leitura do cabeçalho.
+ * @param t Ponteiro para a tabela de decodificação.
+ * @param l Leitor de bits.
+ * @return O símbolo decodificado.
+ */
+int decodificaSimbolo(TabelaDecodificacao *t, LeitorBits *l);
+
+/**
+ * @brief Decodifica símbolos até encontrar o EOF (256), escrevendo os
+ * caracteres no arquivo de saída.
+ * @param t Ponteiro para a tabela de decodificação.
+ * @param l Leitor posicionado no início dos dados.
+ * @param saida Arquivo de saída aberto em modo binário.
+ * @return 0 em caso de sucesso, -1 se o fluxo terminou antes do EOF.
+ */
+int decodificaAteEOF(TabelaDecodificacao *t, LeitorBits *l, FILE *saida);
+
+/**
+ * @brief Decodifica símbolos até o EOF trocando de tabela a cada símbolo: a
+ * tabela de cada um é a do grupo do byte anterior (o primeiro usa o do byte
+ * 0).
+ * @param tabelas Tabela de cada grupo.
+ * @param grupo Grupo de cada um dos 256 valores do byte anterior.
+ * @param l Leitor posicionado no início dos dados.
+ * @param saida Arquivo de saída aberto em modo binário.
+ * @return 0 em caso de sucesso, -1 se o fluxo terminou antes do EOF.
+ */
+int decodificaContextoAteEOF(TabelaDecodificacao *const tabelas[],
+                             const unsigned char grupo[], LeitorBits *l,
+                             FILE *saida);
+
+/**
+ * @brief Decodifica um bloco da etapa LZ77 até o EOF: literais, e classes de
+ * comprimento seguidas de uma distância, copiadas dos bytes já produzidos.
+ * @param literais Tabela dos literais e comprimentos (NUM_LITERAIS_LZ).
+ * @param distancias Tabela das distâncias, ou NULL se o bloco não tem
+ * cópias.
+ * @param l Leitor posicionado no início dos códigos.
+ * @param buffer Bytes dos blocos anteriores, que as cópias alcançam, com
+ * espaço para o bloco e mais 8 bytes de folga.
+ * @param inicio Posição do bloco no buffer.
+ * @param n Tamanho do bloco.
+ * @return 0 em caso de sucesso, -1 se o fluxo terminou antes do EOF, não
+ * produziu exatamente n bytes ou tem uma cópia inválida.
+ */
+int decodificaBlocoLZ(TabelaDecodificacao *literais,
+                      TabelaDecodificacao *distancias, LeitorBits *l,
+                      unsigned char *buffer, size_t inicio, size_t n);
+
+/**
+ * @brief Decodifica um bloco da etapa BWT até o símbolo FIM_BLOCO_BWT,
+ * desfazendo as corridas de zeros e o move-to-front.
+ * @param t Tabela do bloco (NUM_SIMBOLOS_BWT símbolos).
+ * @param l Leitor posicionado no início dos códigos do bloco.
+ * @param destino Recebe os bytes transformados.
+ * @param n Tamanho do bloco.
+ * @return 0 em caso de sucesso, -1 se o bloco não tiver exatamente n bytes
+ * ou o fluxo terminar antes da hora.
+ */
+int decodificaMTF(TabelaDecodificacao *t, LeitorBits *l,
+                  unsigned char *destino, uint32_t n);
+
+/**
+ * @brief Decodifica exatamente n símbolos para a memória, para fluxos cujo
+ * fim é dado pela quantidade de símbolos e não pelo EOF.
+ * @param t Ponteiro para a tabela de decodificação (símbolos de 0 a 255).
+ * @param l Leitor posicionado no início dos dados.
+ * @param destino Área que recebe os bytes decodificados.
+ * @param n Quantidade de símbolos.
+ * @return 0 em caso de sucesso, -1 se o fluxo terminou antes da hora.
+ */
+int decodificaSimbolos(TabelaDecodificacao *t, LeitorBits *l,
+                       unsigned char *destino, size_t n);
+
+/**
+ * @brief Decodifica n símbolos distribuídos entre vários fluxos que
+ * compartilham a mesma tabela: o símbolo i está no fluxo i % numFluxos.
+ *
+ * Como cada fluxo tem o seu próprio leitor, a decodificação de um símbolo não
+ * depende do comprimento do anterior no mesmo laço, e as consultas dos
+ * fluxos podem ser executadas em paralelo pelo processador.
+ *
+ * @param t Tabela de decodificação.
+ * @param leitores Um leitor posicionado no início de cada fluxo.
+ * @param numFluxos Quantidade de fluxos.
+ * @param destino Área que recebe os símbolos (como bytes).
+ * @param n Quantidade de símbolos a decodificar.
+ * @return 0 em caso de sucesso, -1 se algum fluxo acabar antes do esperado.
+ */
+int decodificaSimbolosIntercalados(TabelaDecodificacao *t,
+                                   LeitorBits leitores[], int numFluxos,
+                                   unsigned char *destino, size_t n);
+
+/**
+ * @brief Libera a memória das tabelas de decodificação.
+ * @param t Ponteiro para a tabela.
+ */
+void liberaTabelaDecodificacao(TabelaDecodificacao *t);
+
+#endif // DECODIFICADOR_H
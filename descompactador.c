@@ -7,15 +7,47 @@
  */
 
 #include "descompactador.h"
-#include "arvore.h"
+#include "adaptativo.h"
+#include "arquivo.h"
+#include "bloco.h"
+#include "bwt.h"
+#include "contexto.h"
+#include "decodificador.h"
+#include "dicionario.h"
+#include "huffman.h"
+#include "leitor.h"
+#include "lz77.h"
+#include "pool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// pedaços em que os bytes armazenados sem compactação são copiados
+#define TAMANHO_PEDACO_COPIA (1024 * 1024)
 
 struct descompactador {
   char *arqEntrada;
   char *arqSaida;
-  Arvore *arvore;
+  int numThreads;
+  const Dicionario *dicionario; // tabela pronta, compartilhada entre arquivos
+
+  // arquivo e índice carregados para extrair intervalos, mantidos entre
+  // chamadas
+  ArquivoMapeado *entradaIndexada;
+  int intercalado; // blocos divididos em fluxos intercalados
+  EntradaIndice *indice;
+  uint32_t numBlocos;
+  uint32_t tamanhoBloco;
+  uint64_t tamanhoOriginal;
+  unsigned char *areaOriginal;
+
+  // tabela de decodificação remontada a cada bloco, criada no primeiro uso
+  TabelaDecodificacao *tabelaBloco;
+
+  Estatisticas est;
+  Cronometro cronometro; // marca o fim da última fase medida
 };
 
 Descompactador *criaDescompactador(const char *caminho_entrada) {
@@ -24,6 +56,24 @@ Descompactador *criaDescompactador(const char *caminho_entrada) {
     exit(1);
   }
 
+  defineArquivoDescompactacao(d, caminho_entrada);
+
+  return d;
+}
+
+void defineArquivoDescompactacao(Descompactador *d,
+                                 const char *caminho_entrada) {
+  free(d->arqEntrada);
+  free(d->arqSaida);
+
+  // o índice carregado para extrair intervalos é do arquivo anterior
+  fechaArquivoMapeado(d->entradaIndexada);
+  free(d->indice);
+  free(d->areaOriginal);
+  d->entradaIndexada = NULL;
+  d->indice = NULL;
+  d->areaOriginal = NULL;
+
   // duplica a string do caminho de entrada pro descompactador ter sua própria
   // cópia
   d->arqEntrada = strdup(caminho_entrada);
@@ -35,8 +85,6 @@ Descompactador *criaDescompactador(const char *caminho_entrada) {
     d->arqSaida =
         (char *)malloc(len - 4); // len - 5 para remover ".comp", +1 para '\0'
     if (d->arqSaida == NULL) {
-      free(d->arqEntrada);
-      free(d);
       exit(1);
     }
     strncpy(d->arqSaida, caminho_entrada, len - 5);
@@ -45,130 +93,976 @@ Descompactador *criaDescompactador(const char *caminho_entrada) {
     // se n tiver a extensão .comp, apenas copia o nome
     d->arqSaida = strdup(caminho_entrada);
   }
+  if (d->arqEntrada == NULL || d->arqSaida == NULL) {
+    exit(1);
+  }
+}
 
-  d->arvore = NULL;
+// lê um nó do cabeçalho em pré-ordem direto para a árvore compacta e
+// retorna a sua referência, ou -1 se o cabeçalho for inválido
+static int leNoCabecalho(LeitorBits *l, ArvoreCompacta *a, int profundidade) {
+  // com no máximo 257 folhas a árvore nunca passa de 256 níveis
+  if (leitorEstourou(l) || profundidade > 256) {
+    return -1;
+  }
 
-  return d;
+  // nó folha
+  if (leBits(l, 1) == 1) {
+    int bit_tipo_folha = leBits(l, 1); // lê o bit extra
+    if (bit_tipo_folha == 1) {
+      return FOLHA_COMPACTA | SIMBOLO_EOF;
+    } else {
+      // lê os próximos 8 bits para reconstruir o caractere
+      return FOLHA_COMPACTA | leBits(l, 8);
+    }
+  }
+
+  if (a->numNos == MAX_NOS_COMPACTOS) {
+    return -1;
+  }
+  int indice = a->numNos++;
+
+  int esquerda = leNoCabecalho(l, a, profundidade + 1);
+  if (esquerda < 0) {
+    return -1;
+  }
+  int direita = leNoCabecalho(l, a, profundidade + 1);
+  if (direita < 0) {
+    return -1;
+  }
+
+  a->nos[indice].filhos[0] = (uint16_t)esquerda;
+  a->nos[indice].filhos[1] = (uint16_t)direita;
+  return indice;
+}
+
+// lê a árvore do formato original e a deixa em ordem de largura
+static int leCabecalho(LeitorBits *l, ArvoreCompacta *a) {
+  a->numNos = 0;
+  int raiz = leNoCabecalho(l, a, 0);
+  if (raiz < 0) {
+    return -1;
+  }
+  a->raiz = (uint16_t)raiz;
+  ordenaEmLargura(a);
+
+  return 0;
+}
+
+// monta a tabela a partir do formato canônico, que só guarda os comprimentos
+static TabelaDecodificacao *leCabecalhoCanonico(Descompactador *d,
+                                                LeitorBits *l) {
+  unsigned char comprimentos[NUM_SIMBOLOS];
+  if (leComprimentos(l, comprimentos, NUM_SIMBOLOS) != 0) {
+    return NULL;
+  }
+  registraComprimentos(&d->est, comprimentos, NUM_SIMBOLOS);
+  marcaFase(&d->est, FASE_CABECALHO, &d->cronometro);
+
+  TabelaDecodificacao *tabela =
+      criaTabelaDosComprimentos(comprimentos, NUM_SIMBOLOS);
+  marcaFase(&d->est, FASE_TABELA, &d->cronometro);
+  return tabela;
 }
 
-static int leProximoBit(FILE *arq) {
-  static int byte_atual = 0;
-  static int contador_bits = 0;
+// copia os bytes armazenados sem compactação até o fim da entrada
+static int copiaArmazenado(Descompactador *d, LeitorBits *l, FILE *arq_saida) {
+  unsigned char *pedaco = malloc(TAMANHO_PEDACO_COPIA);
+  if (pedaco == NULL) {
+    exit(1);
+  }
+
+  size_t lidos;
+  while ((lidos = leBytes(l, pedaco, TAMANHO_PEDACO_COPIA)) > 0) {
+    fwrite(pedaco, 1, lidos, arq_saida);
+  }
+  free(pedaco);
+  marcaFase(&d->est, FASE_ESCRITA, &d->cronometro);
+
+  return 0;
+}
 
-  // se já lemos todos os 8 bits do byte atual, leia um novo byte do arquivo
-  if (contador_bits == 0) {
-    byte_atual = fgetc(arq);
-    if (byte_atual == EOF) {
-      return EOF;
+// lê o mapa dos contextos e os comprimentos de cada tabela e descompacta o
+// fluxo trocando de tabela a cada byte
+static int descompactaContexto(Descompactador *d, LeitorBits *l,
+                               FILE *arq_saida) {
+  unsigned char grupo[NUM_CONTEXTOS];
+  int numTabelas;
+  if (leMapaContextos(l, grupo, &numTabelas) != 0) {
+    return -1;
+  }
+
+  TabelaDecodificacao *tabelas[MAX_TABELAS_CONTEXTO] = {NULL};
+  int resultado = 0;
+  for (int t = 0; t < numTabelas && resultado == 0; t++) {
+    tabelas[t] = leCabecalhoCanonico(d, l);
+    if (tabelas[t] == NULL) {
+      resultado = -1;
     }
-    contador_bits = 8;
   }
 
-  // extrai o bit mais significativo do byte atual
-  int bit = (byte_atual >> 7) & 1;
+  if (resultado == 0) {
+    resultado = decodificaContextoAteEOF(tabelas, grupo, l, arq_saida);
+    marcaFase(&d->est, FASE_DECODIFICACAO, &d->cronometro);
+  }
+
+  for (int t = 0; t < numTabelas; t++) {
+    if (tabelas[t] != NULL) {
+      liberaTabelaDecodificacao(tabelas[t]);
+    }
+  }
 
-  // prepara o byte para a próxima leitura, deslocando os bits para a esquerda
-  byte_atual = byte_atual << 1;
+  return resultado;
+}
 
-  contador_bits--;
+// lê os blocos da etapa LZ77 até o bloco vazio: cada um tem as suas tabelas,
+// e as cópias alcançam os bytes dos blocos anteriores, que ficam no buffer
+// até a janela sair dele
+static int descompactaLZ(Descompactador *d, LeitorBits *l, FILE *arq_saida) {
+  uint32_t tamanhoBloco = leBits(l, 32);
+  if (tamanhoBloco < 1 || tamanhoBloco > TAMANHO_BLOCO_LZ_MAXIMO) {
+    return -1;
+  }
+  marcaFase(&d->est, FASE_CABECALHO, &d->cronometro);
 
-  return bit;
+  // a janela seguida de espaço para alguns blocos: só quando ele acaba a
+  // janela volta para o início do buffer
+  size_t capacidade = JANELA_LZ + 4 * (size_t)tamanhoBloco;
+  unsigned char *buffer = malloc(capacidade + 8);
+  TabelaDecodificacao *literais = criaTabelaDecodificacao();
+  TabelaDecodificacao *distancias = criaTabelaDecodificacao();
+  if (buffer == NULL || literais == NULL || distancias == NULL) {
+    exit(1);
+  }
+
+  int resultado = 0;
+  size_t usados = 0;
+  uint32_t n;
+  while (resultado == 0 && (n = leBits(l, 32)) > 0) {
+    if (n > tamanhoBloco) {
+      resultado = -1;
+      break;
+    }
+    if (usados + n > capacidade) {
+      memmove(buffer, buffer + usados - JANELA_LZ, JANELA_LZ);
+      usados = JANELA_LZ;
+    }
+    unsigned char *destino = buffer + usados;
+
+    uint32_t tipo = leBits(l, 2);
+    if (tipo == BLOCO_LZ_ARMAZENADO) {
+      alinhaLeitor(l);
+      if (leBytes(l, destino, n) != n) {
+        resultado = -1;
+        break;
+      }
+    } else if (tipo == BLOCO_LZ_DIRETO) {
+      unsigned char comprimentos[256];
+      if (leComprimentos(l, comprimentos, 256) != 0) {
+        resultado = -1;
+        break;
+      }
+      registraComprimentos(&d->est, comprimentos, 256);
+      marcaFase(&d->est, FASE_CABECALHO, &d->cronometro);
+
+      resultado = remontaTabelaDosComprimentos(literais, comprimentos, 256);
+      marcaFase(&d->est, FASE_TABELA, &d->cronometro);
+      if (resultado == 0) {
+        resultado = decodificaSimbolos(literais, l, destino, n);
+      }
+    } else if (tipo == BLOCO_LZ_COPIAS) {
+      unsigned char comprimentosLiterais[NUM_LITERAIS_LZ];
+      unsigned char comprimentosDistancias[NUM_DISTANCIAS_LZ];
+      if (leComprimentos(l, comprimentosLiterais, NUM_LITERAIS_LZ) != 0 ||
+          leComprimentos(l, comprimentosDistancias, NUM_DISTANCIAS_LZ) != 0) {
+        resultado = -1;
+        break;
+      }
+      registraComprimentos(&d->est, comprimentosLiterais, NUM_LITERAIS_LZ);
+      registraComprimentos(&d->est, comprimentosDistancias,
+                           NUM_DISTANCIAS_LZ);
+      marcaFase(&d->est, FASE_CABECALHO, &d->cronometro);
+
+      // sem nenhuma cópia, o alfabeto das distâncias fica vazio
+      int semCopias = 1;
+      for (int s = 0; s < NUM_DISTANCIAS_LZ; s++) {
+        semCopias = semCopias && comprimentosDistancias[s] == 0;
+      }
+
+      if (remontaTabelaDosComprimentos(literais, comprimentosLiterais,
+                                       NUM_LITERAIS_LZ) != 0 ||
+          (!semCopias &&
+           remontaTabelaDosComprimentos(distancias, comprimentosDistancias,
+                                        NUM_DISTANCIAS_LZ) != 0)) {
+        resultado = -1;
+      }
+      marcaFase(&d->est, FASE_TABELA, &d->cronometro);
+      if (resultado == 0) {
+        resultado = decodificaBlocoLZ(literais, semCopias ? NULL : distancias,
+                                      l, buffer, usados, n);
+      }
+    } else {
+      resultado = -1;
+    }
+    marcaFase(&d->est, FASE_DECODIFICACAO, &d->cronometro);
+
+    if (resultado == 0) {
+      fwrite(destino, 1, n, arq_saida);
+      usados += n;
+      marcaFase(&d->est, FASE_ESCRITA, &d->cronometro);
+    }
+  }
+
+  if (leitorEstourou(l)) {
+    resultado = -1;
+  }
+  free(buffer);
+  liberaTabelaDecodificacao(literais);
+  liberaTabelaDecodificacao(distancias);
+
+  return resultado;
 }
 
-static Arvore *leCabecalho(FILE *arq) {
-  int tipo_bit = leProximoBit(arq);
+// lê os blocos da etapa BWT até o bloco vazio: cada um tem a sua tabela, e
+// nos blocos transformados a transformada é desfeita depois do move-to-front
+static int descompactaBWT(Descompactador *d, LeitorBits *l, FILE *arq_saida) {
+  uint32_t tamanhoBloco = leBits(l, 32);
+  if (tamanhoBloco < TAMANHO_BLOCO_BWT_MINIMO ||
+      tamanhoBloco > TAMANHO_BLOCO_BWT_MAXIMO) {
+    return -1;
+  }
+  marcaFase(&d->est, FASE_CABECALHO, &d->cronometro);
 
-  if (tipo_bit == EOF) {
-    return NULL;
+  unsigned char *transformados = malloc(tamanhoBloco);
+  unsigned char *dados = malloc(tamanhoBloco);
+  uint32_t *vetor = malloc(((size_t)tamanhoBloco + 1) * sizeof(uint32_t));
+  TabelaDecodificacao *tabela = criaTabelaDecodificacao();
+  if (transformados == NULL || dados == NULL || vetor == NULL ||
+      tabela == NULL) {
+    exit(1);
   }
 
-  // nó folha
-  if (tipo_bit == 1) {
-    int bit_tipo_folha = leProximoBit(arq); // lê o bit extra
-    if (bit_tipo_folha == 1) {
-      return criaNoFolha(256, 0);
+  int resultado = 0;
+  uint32_t n;
+  while (resultado == 0 && (n = leBits(l, 32)) > 0) {
+    if (n > tamanhoBloco) {
+      resultado = -1;
+      break;
+    }
+
+    uint32_t tipo = leBits(l, 2);
+    if (tipo == BLOCO_BWT_ARMAZENADO) {
+      alinhaLeitor(l);
+      if (leBytes(l, dados, n) != n) {
+        resultado = -1;
+        break;
+      }
+      fwrite(dados, 1, n, arq_saida);
+      marcaFase(&d->est, FASE_ESCRITA, &d->cronometro);
+      continue;
+    }
+    if (tipo != BLOCO_BWT_TRANSFORMADO && tipo != BLOCO_BWT_DIRETO) {
+      resultado = -1;
+      break;
+    }
+
+    // o bloco direto só tem os 256 bytes no alfabeto
+    uint32_t primario = 0;
+    uint32_t linhas[NUM_TRECHOS_BWT - 1];
+    if (tipo == BLOCO_BWT_TRANSFORMADO) {
+      primario = leBits(l, 32);
+      for (int k = 0; k < NUM_TRECHOS_BWT - 1; k++) {
+        linhas[k] = leBits(l, 32);
+      }
+    }
+    int numSimbolos = tipo == BLOCO_BWT_TRANSFORMADO ? NUM_SIMBOLOS_BWT : 256;
+    unsigned char comprimentos[NUM_SIMBOLOS_BWT];
+    if (leComprimentos(l, comprimentos, numSimbolos) != 0) {
+      resultado = -1;
+      break;
+    }
+    registraComprimentos(&d->est, comprimentos, numSimbolos);
+    marcaFase(&d->est, FASE_CABECALHO, &d->cronometro);
+
+    // a mesma tabela é remontada a cada bloco
+    resultado = remontaTabelaDosComprimentos(tabela, comprimentos, numSimbolos);
+    marcaFase(&d->est, FASE_TABELA, &d->cronometro);
+    if (resultado != 0) {
+      break;
+    }
+
+    if (tipo == BLOCO_BWT_DIRETO) {
+      resultado = decodificaSimbolos(tabela, l, dados, n);
     } else {
-      int caractere = 0;
-      // lê os próximos 8 bits para reconstruir o caractere
-      for (int i = 0; i < 8; i++) {
-        int bit = leProximoBit(arq);
-        if (bit == EOF)
-          return NULL;
-        caractere = (caractere << 1) | bit;
+      resultado = decodificaMTF(tabela, l, transformados, n);
+      if (resultado == 0) {
+        resultado =
+            desfazBWT(transformados, n, primario, linhas, vetor, dados);
       }
-      return criaNoFolha(caractere, 0);
     }
-  } else {
-    Arvore *esquerda = leCabecalho(arq);
-    Arvore *direita = leCabecalho(arq);
-    return criaNoInterno(esquerda, direita);
+    marcaFase(&d->est, FASE_DECODIFICACAO, &d->cronometro);
+    if (resultado == 0) {
+      fwrite(dados, 1, n, arq_saida);
+      marcaFase(&d->est, FASE_ESCRITA, &d->cronometro);
+    }
   }
+
+  if (leitorEstourou(l)) {
+    resultado = -1;
+  }
+  free(transformados);
+  free(dados);
+  free(vetor);
+  liberaTabelaDecodificacao(tabela);
+
+  return resultado;
+}
+
+// tabela dos blocos descompactados em sequência, alocada uma vez e
+// reaproveitada em todos os blocos e arquivos
+static TabelaDecodificacao *tabelaDosBlocos(Descompactador *d) {
+  if (d->tabelaBloco == NULL) {
+    d->tabelaBloco = criaTabelaDecodificacao();
+    if (d->tabelaBloco == NULL) {
+      exit(1);
+    }
+  }
+  return d->tabelaBloco;
 }
 
-// descompacta os dados do arquivo original paro arquivo de saída
-static void descompactaDados(Descompactador *d, FILE *arq_entrada,
+// descompacta o formato em blocos, um bloco por vez, com memória
+// proporcional ao tamanho do bloco
+static int descompactaBlocos(Descompactador *d, LeitorBits *l,
                              FILE *arq_saida) {
-  if (!d || !d->arvore)
+  uint32_t tamanhoBloco = leBits(l, 32);
+  if (tamanhoBloco < TAMANHO_BLOCO_MINIMO ||
+      tamanhoBloco > TAMANHO_BLOCO_MAXIMO) {
+    return -1;
+  }
+
+  size_t maximoCompactado = (size_t)tamanhoBloco + FOLGA_BLOCO_COMPACTADO;
+  unsigned char *compactado = malloc(maximoCompactado);
+  unsigned char *original = malloc(tamanhoBloco);
+  if (compactado == NULL || original == NULL) {
+    exit(1);
+  }
+
+  int resultado = 0;
+  for (;;) {
+    uint32_t tamanhoOriginal = leBits(l, 32);
+    if (tamanhoOriginal == 0 || leitorEstourou(l)) {
+      break;
+    }
+
+    uint32_t tamanhoCompactado = leBits(l, 32);
+    if (tamanhoOriginal > tamanhoBloco ||
+        tamanhoCompactado > maximoCompactado ||
+        leBytes(l, compactado, tamanhoCompactado) != tamanhoCompactado) {
+      resultado = -1;
+      break;
+    }
+
+    // as fases do bloco são medidas dentro de descompactaBloco
+    iniciaCronometro(&d->cronometro);
+    if (descompactaBloco(compactado, tamanhoCompactado, original,
+                         tamanhoOriginal, tabelaDosBlocos(d), &d->est) != 0) {
+      resultado = -1;
+      break;
+    }
+
+    iniciaCronometro(&d->cronometro);
+    fwrite(original, 1, tamanhoOriginal, arq_saida);
+    marcaFase(&d->est, FASE_ESCRITA, &d->cronometro);
+  }
+
+  if (leitorEstourou(l)) {
+    resultado = -1;
+  }
+
+  free(compactado);
+  free(original);
+
+  return resultado;
+}
+
+// área de trabalho de um bloco em andamento
+typedef struct {
+  unsigned char *original;
+  TabelaDecodificacao *tabela;
+  int erro;
+  Estatisticas est;
+} AreaBloco;
+
+typedef struct {
+  const unsigned char *entrada; // arquivo compactado mapeado
+  int saida;                    // descritor do arquivo descompactado
+  const EntradaIndice *indice;
+  int intercalado;   // blocos divididos em fluxos intercalados
+  uint32_t primeiro; // primeiro bloco do lote
+  AreaBloco *areas;
+} LoteDescompactacao;
+
+// os dois formatos indexados só diferem no conteúdo dos blocos
+static int descompactaBlocoDoFormato(int intercalado,
+                                     const unsigned char *dados,
+                                     size_t tamanho, unsigned char *saida,
+                                     size_t n, TabelaDecodificacao *tabela,
+                                     Estatisticas *est) {
+  if (intercalado) {
+    return descompactaBlocoIntercalado(dados, tamanho, saida, n, tabela, est);
+  }
+  return descompactaBloco(dados, tamanho, saida, n, tabela, est);
+}
+
+// tarefa executada pelas threads: descompacta o i-ésimo bloco do lote direto
+// da entrada mapeada e grava o resultado na sua posição no arquivo de saída
+static void descompactaBlocoDoLote(void *contexto, int i) {
+  LoteDescompactacao *lote = contexto;
+  const EntradaIndice *e = &lote->indice[lote->primeiro + i];
+  AreaBloco *area = &lote->areas[i];
+
+  memset(&area->est, 0, sizeof(Estatisticas));
+  area->erro = descompactaBlocoDoFormato(lote->intercalado,
+                                         lote->entrada + e->deslocamento,
+                                         e->tamanhoCompactado, area->original,
+                                         e->tamanhoOriginal, area->tabela,
+                                         &area->est) != 0;
+  if (area->erro) {
     return;
+  }
 
-  Arvore *noAtual = d->arvore;
-  int bit;
+  Cronometro cronometro;
+  iniciaCronometro(&cronometro);
+  area->erro = escreveNaPosicao(lote->saida, area->original,
+                                e->tamanhoOriginal, e->posicaoOriginal) != 0;
+  marcaFase(&area->est, FASE_ESCRITA, &cronometro);
+}
 
-  // le um bit de cada vez
-  while ((bit = leProximoBit(arq_entrada)) != EOF) {
+// descompacta o formato indexado: como cada bloco sabe onde começa nos dois
+// arquivos, os blocos são distribuídos entre as threads e gravados fora de
+// ordem
+static int descompactaBlocosIndexados(Descompactador *d, LeitorBits *l,
+                                      ArquivoMapeado *entrada, int versao) {
+  uint32_t tamanhoBloco, numBlocos;
+  uint64_t tamanhoOriginal;
+  EntradaIndice *indice =
+      leCabecalhoIndexado(l, tamanhoArquivoMapeado(entrada), &tamanhoBloco,
+                          &numBlocos, &tamanhoOriginal);
+  if (indice == NULL) {
+    return -1;
+  }
+  marcaFase(&d->est, FASE_CABECALHO, &d->cronometro);
 
-    // Navega na árvore: 0 = esquerda, 1 = direita
-    if (bit == 0) {
-      noAtual = getEsquerda(noAtual);
-    } else {
-      noAtual = getDireita(noAtual);
+  LoteDescompactacao lote;
+  lote.entrada = dadosArquivoMapeado(entrada);
+  lote.indice = indice;
+  lote.intercalado = versao == VERSAO_BLOCOS_INTERCALADOS;
+  lote.saida = criaArquivoSaida(d->arqSaida);
+  if (lote.saida < 0) {
+    free(indice);
+    return -1;
+  }
+
+  // reserva o tamanho final de uma vez; os blocos preenchem cada parte
+  if (ftruncate(lote.saida, (off_t)tamanhoOriginal) != 0) {
+    close(lote.saida);
+    free(indice);
+    return -1;
+  }
+
+  int numThreads = d->numThreads > 1 ? d->numThreads : 1;
+  int capacidade = numThreads > 1 ? 2 * numThreads : 1;
+  Pool *pool = numThreads > 1 ? criaPool(numThreads) : NULL;
+
+  lote.areas = calloc(capacidade, sizeof(AreaBloco));
+  if (lote.areas == NULL) {
+    exit(1);
+  }
+  for (int i = 0; i < capacidade; i++) {
+    lote.areas[i].original = malloc(tamanhoBloco);
+    lote.areas[i].tabela = criaTabelaDecodificacao();
+    if (lote.areas[i].original == NULL || lote.areas[i].tabela == NULL) {
+      exit(1);
     }
+  }
 
-    // se chegou numa folha, encontrou um caractere
-    if (ehNoFolha(noAtual)) {
-      // se for EOF, para a descompactação
-      if (getCaractere(noAtual) == 256) { // EOF
-        break;
+  int resultado = 0;
+  for (lote.primeiro = 0; lote.primeiro < numBlocos && resultado == 0;
+       lote.primeiro += capacidade) {
+    uint32_t n = numBlocos - lote.primeiro;
+    if (n > (uint32_t)capacidade) {
+      n = capacidade;
+    }
+
+    executaNoPool(pool, (int)n, descompactaBlocoDoLote, &lote);
+
+    for (uint32_t i = 0; i < n; i++) {
+      if (lote.areas[i].erro) {
+        resultado = -1;
       }
-      // escreve o caractere no arquivo de saída
-      fputc(getCaractere(noAtual), arq_saida);
-      // volta para a raiz da árvore para continuar
-      noAtual = d->arvore;
+      somaEstatisticas(&d->est, &lote.areas[i].est);
     }
+
+    // os blocos do lote já foram usados: as suas páginas podem sair da
+    // memória
+    const EntradaIndice *ultimo = &indice[lote.primeiro + n - 1];
+    descartaTrechoMapeado(entrada, indice[lote.primeiro].deslocamento,
+                          ultimo->deslocamento + ultimo->tamanhoCompactado -
+                              indice[lote.primeiro].deslocamento);
   }
+
+  for (int i = 0; i < capacidade; i++) {
+    free(lote.areas[i].original);
+    liberaTabelaDecodificacao(lote.areas[i].tabela);
+  }
+  free(lote.areas);
+  liberaPool(pool);
+  free(indice);
+  close(lote.saida);
+  d->est.bytesSaida = tamanhoOriginal;
+
+  return resultado;
 }
 
-void executaDescompactacao(Descompactador *d) {
-  if (!d)
-    return;
+// abre a saída dos formatos sequenciais, gravada em ordem pelo stdio;
+// retorna NULL se o arquivo não puder ser criado
+static FILE *abreSaidaSequencial(Descompactador *d) {
+  // abre um novo arquivo pra escrever binario
+  return fopen(d->arqSaida, "wb");
+}
+
+// Os formatos sequenciais são lidos uma única vez, do início ao fim: em vez
+// da entrada mapeada, cujas páginas lidas ficariam na memória do processo
+// até o fim, o leitor passa a ler o arquivo em pedaços a partir da posição
+// dada, com memória constante para qualquer tamanho. Se o arquivo deixou de
+// ser regular depois de mapeado, nada muda.
+static FILE *passaParaLeitorArquivo(Descompactador *d, LeitorBits *l,
+                                    off_t posicao) {
+  struct stat info;
+  if (stat(d->arqEntrada, &info) != 0 || !S_ISREG(info.st_mode)) {
+    return NULL;
+  }
+
+  FILE *arq = fopen(d->arqEntrada, "rb");
+  if (arq == NULL) {
+    return NULL;
+  }
+  if (fseeko(arq, posicao, SEEK_SET) != 0) {
+    fclose(arq);
+    return NULL;
+  }
+
+  finalizaLeitor(l);
+  iniciaLeitorArquivo(l, arq);
+  return arq;
+}
 
-  // abre o arquivo pra leitura binaria
-  FILE *arq_entrada = fopen(d->arqEntrada, "rb");
-  if (arq_entrada == NULL) {
+// formato indexado lido do início ao fim, sem acesso aleatório (da entrada
+// padrão): os blocos ficam em ordem logo depois do cabeçalho, então basta
+// conferir que cada um começa onde o anterior terminou. O índice vem inteiro
+// antes dos blocos e precisa ser guardado, mas a área só cresce conforme as
+// entradas são de fato lidas: o numBlocos do cabeçalho, que pode estar
+// corrompido, não decide quanto é alocado.
+static int descompactaIndexadoEmOrdem(Descompactador *d, LeitorBits *l,
+                                      int versao, FILE *arq_saida) {
+  uint32_t tamanhoBloco, numBlocos;
+  uint64_t tamanhoOriginal;
+  if (leCabecalhoIndexadoFixo(l, UINT64_MAX, &tamanhoBloco, &numBlocos,
+                              &tamanhoOriginal) != 0) {
+    return -1;
+  }
+
+  EntradaIndice *indice = NULL;
+  uint32_t capacidade = 0;
+  uint64_t posicaoOriginal = 0;
+  for (uint32_t i = 0; i < numBlocos; i++) {
+    if (i == capacidade) {
+      uint64_t nova = capacidade == 0 ? 1024 : 2 * (uint64_t)capacidade;
+      capacidade = nova < numBlocos ? (uint32_t)nova : numBlocos;
+      EntradaIndice *novo =
+          realloc(indice, (size_t)capacidade * sizeof(EntradaIndice));
+      if (novo == NULL) {
+        free(indice);
+        return -1;
+      }
+      indice = novo;
+    }
+
+    if (leEntradaIndice(l, UINT64_MAX, tamanhoBloco, numBlocos,
+                        posicaoOriginal, &indice[i]) != 0) {
+      free(indice);
+      return -1;
+    }
+    posicaoOriginal += indice[i].tamanhoOriginal;
+  }
+  if (posicaoOriginal != tamanhoOriginal) {
+    free(indice);
+    return -1;
+  }
+  marcaFase(&d->est, FASE_CABECALHO, &d->cronometro);
+
+  size_t maximoCompactado = (size_t)tamanhoBloco + FOLGA_BLOCO_COMPACTADO;
+  unsigned char *compactado = malloc(maximoCompactado);
+  unsigned char *original = malloc(tamanhoBloco);
+  if (compactado == NULL || original == NULL) {
     exit(1);
   }
 
-  // le o cabeçalho e reconstroi a arvore
-  d->arvore = leCabecalho(arq_entrada);
+  int resultado = 0;
+  uint64_t posicao = tamanhoCabecalhoIndexado(numBlocos);
+  for (uint32_t i = 0; i < numBlocos; i++) {
+    const EntradaIndice *e = &indice[i];
+    if (e->deslocamento != posicao ||
+        leBytes(l, compactado, e->tamanhoCompactado) != e->tamanhoCompactado) {
+      resultado = -1;
+      break;
+    }
+    posicao += e->tamanhoCompactado;
+
+    iniciaCronometro(&d->cronometro);
+    if (descompactaBlocoDoFormato(versao == VERSAO_BLOCOS_INTERCALADOS,
+                                  compactado, e->tamanhoCompactado, original,
+                                  e->tamanhoOriginal, tabelaDosBlocos(d),
+                                  &d->est) != 0) {
+      resultado = -1;
+      break;
+    }
+
+    iniciaCronometro(&d->cronometro);
+    fwrite(original, 1, e->tamanhoOriginal, arq_saida);
+    marcaFase(&d->est, FASE_ESCRITA, &d->cronometro);
+  }
+
+  free(compactado);
+  free(original);
+  free(indice);
+
+  return resultado;
+}
 
-  FILE *arq_saida =
-      fopen(d->arqSaida, "wb"); // abre um novo arquivo pra escrever binario
-  if (arq_saida == NULL) {
+// descompacta qualquer formato lendo a entrada do início ao fim e gravando a
+// saída em ordem; versao é -1 no formato original, que não tem assinatura
+static int descompactaEmOrdem(Descompactador *d, LeitorBits *l, int versao,
+                              FILE *arq_saida) {
+  if (versao == VERSAO_BLOCOS_INDEXADOS ||
+      versao == VERSAO_BLOCOS_INTERCALADOS) {
+    return descompactaIndexadoEmOrdem(d, l, versao, arq_saida);
+  }
+  if (versao == VERSAO_BLOCOS) {
+    return descompactaBlocos(d, l, arq_saida);
+  }
+
+  int resultado = -1;
+  if (versao == VERSAO_ARMAZENADA) {
+    resultado = copiaArmazenado(d, l, arq_saida);
+  } else if (versao == VERSAO_DICIONARIO) {
+    // a tabela já montada no dicionário é usada direto, sem cabeçalho
+    uint32_t identificador = leBits(l, 32);
+    marcaFase(&d->est, FASE_CABECALHO, &d->cronometro);
+    if (d->dicionario != NULL &&
+        identificador == identificadorDicionario(d->dicionario)) {
+      resultado = decodificaAteEOF(tabelaDicionario(d->dicionario), l,
+                                   arq_saida);
+      marcaFase(&d->est, FASE_DECODIFICACAO, &d->cronometro);
+    }
+  } else if (versao == VERSAO_CONTEXTO) {
+    resultado = descompactaContexto(d, l, arq_saida);
+  } else if (versao == VERSAO_LZ77) {
+    resultado = descompactaLZ(d, l, arq_saida);
+  } else if (versao == VERSAO_BWT) {
+    resultado = descompactaBWT(d, l, arq_saida);
+  } else if (versao == VERSAO_ADAPTATIVA) {
+    // a árvore é refeita a cada símbolo, como no compactador
+    ModeloAdaptativo *modelo = criaModeloAdaptativo();
+    resultado = decodificaAdaptativoAteEOF(modelo, l, arq_saida);
+    marcaFase(&d->est, FASE_DECODIFICACAO, &d->cronometro);
+    liberaModeloAdaptativo(modelo);
+  } else if (versao == VERSAO_CANONICA) {
+    TabelaDecodificacao *tabela = leCabecalhoCanonico(d, l);
+    if (tabela != NULL) {
+      resultado = decodificaAteEOF(tabela, l, arq_saida);
+      marcaFase(&d->est, FASE_DECODIFICACAO, &d->cronometro);
+      liberaTabelaDecodificacao(tabela);
+    }
+  } else if (versao < 0) {
+    // formato original: le o cabeçalho e reconstroi a arvore
+    ArvoreCompacta arvore;
+    TabelaDecodificacao *tabela = NULL;
+    if (leCabecalho(l, &arvore) == 0) {
+      // numNos nós internos e numNos + 1 folhas
+      d->est.nosArvore = 2 * arvore.numNos + 1;
+      marcaFase(&d->est, FASE_CABECALHO, &d->cronometro);
+      tabela = criaTabelaDaArvore(&arvore);
+      marcaFase(&d->est, FASE_TABELA, &d->cronometro);
+    }
+    if (tabela != NULL) {
+      resultado = decodificaAteEOF(tabela, l, arq_saida);
+      marcaFase(&d->est, FASE_DECODIFICACAO, &d->cronometro);
+      liberaTabelaDecodificacao(tabela);
+    }
+  }
+
+  return resultado;
+}
+
+// reconhece o formato pela assinatura e consome a assinatura e a versão;
+// retorna -1 no formato original
+static int leVersao(LeitorBits *l) {
+  recarregaLeitor(l);
+  if (espiaBits(l, 32) != ASSINATURA_FORMATO) {
+    return -1;
+  }
+  consomeBits(l, 32);
+  return (int)leBits(l, 8);
+}
+
+// pipes e outros arquivos especiais não podem ser mapeados: em vez de lidos
+// inteiros para a memória, são descompactados em pedaços, pelo mesmo caminho
+// da entrada padrão, com a saída gravada em ordem
+static int descompactaEmPedacos(Descompactador *d) {
+  FILE *entrada = fopen(d->arqEntrada, "rb");
+  if (entrada == NULL) {
+    return -1;
+  }
+  FILE *saida = abreSaidaSequencial(d);
+  if (saida == NULL) {
+    fclose(entrada);
+    return -1;
+  }
+
+  int resultado = executaDescompactacaoFluxo(d, entrada, saida);
+  if (fclose(saida) != 0) {
+    resultado = -1;
+  }
+  fclose(entrada);
+  return resultado;
+}
+
+int executaDescompactacao(Descompactador *d) {
+  if (!d)
+    return -1;
+
+  if (!ehArquivoRegular(d->arqEntrada)) {
+    return descompactaEmPedacos(d);
+  }
+
+  Cronometro inicio;
+  iniciaCronometroProcesso(&inicio);
+  memset(&d->est, 0, sizeof(Estatisticas));
+  iniciaCronometro(&d->cronometro);
+
+  // mapeia o arquivo compactado inteiro; o formato é reconhecido direto da
+  // memória, e os formatos indexados também são lidos dela
+  ArquivoMapeado *entrada = abreArquivoMapeado(d->arqEntrada);
+  if (entrada == NULL) {
+    return -1;
+  }
+  d->est.bytesEntrada = tamanhoArquivoMapeado(entrada);
+
+  LeitorBits leitor;
+  iniciaLeitorMemoria(&leitor, dadosArquivoMapeado(entrada),
+                      (size_t)tamanhoArquivoMapeado(entrada));
+
+  int resultado = -1;
+  FILE *arq_saida = NULL;
+  FILE *arq_entrada = NULL; // só nos formatos sequenciais
+  int versao = leVersao(&leitor);
+
+  if (versao == VERSAO_BLOCOS_INDEXADOS ||
+      versao == VERSAO_BLOCOS_INTERCALADOS) {
+    resultado = descompactaBlocosIndexados(d, &leitor, entrada, versao);
+  } else if (versao < 0 || versao == VERSAO_BLOCOS ||
+             versao == VERSAO_CANONICA || versao == VERSAO_ADAPTATIVA ||
+             versao == VERSAO_CONTEXTO || versao == VERSAO_DICIONARIO ||
+             versao == VERSAO_ARMAZENADA || versao == VERSAO_LZ77 ||
+             versao == VERSAO_BWT) {
+    arq_entrada = passaParaLeitorArquivo(d, &leitor, versao < 0 ? 0 : 5);
+    arq_saida = abreSaidaSequencial(d);
+    if (arq_saida != NULL) {
+      resultado = descompactaEmOrdem(d, &leitor, versao, arq_saida);
+    }
+  }
+
+  finalizaLeitor(&leitor);
+  if (arq_entrada != NULL) {
     fclose(arq_entrada);
+  }
+  if (arq_saida != NULL) {
+    // o que ainda estava no buffer do stdio vai para o arquivo agora
+    iniciaCronometro(&d->cronometro);
+    if (fflush(arq_saida) != 0 || ferror(arq_saida)) {
+      resultado = -1;
+    }
+    d->est.bytesSaida = (uint64_t)ftello(arq_saida);
+    if (fclose(arq_saida) != 0) {
+      resultado = -1;
+    }
+    marcaFase(&d->est, FASE_ESCRITA, &d->cronometro);
+  }
+  fechaArquivoMapeado(entrada);
+  finalizaEstatisticas(&d->est, &inicio);
+
+  return resultado;
+}
+
+int executaDescompactacaoFluxo(Descompactador *d, FILE *entrada,
+                                FILE *saida) {
+  Cronometro inicio;
+  iniciaCronometroProcesso(&inicio);
+  memset(&d->est, 0, sizeof(Estatisticas));
+  iniciaCronometro(&d->cronometro);
+
+  LeitorBits leitor;
+  iniciaLeitorArquivo(&leitor, entrada);
+
+  int versao = leVersao(&leitor);
+  int resultado = descompactaEmOrdem(d, &leitor, versao, saida);
+  finalizaLeitor(&leitor);
+
+  iniciaCronometro(&d->cronometro);
+  if (fflush(saida) != 0 || ferror(saida)) {
+    resultado = -1;
+  }
+  marcaFase(&d->est, FASE_ESCRITA, &d->cronometro);
+
+  // as posições só existem quando os fluxos são arquivos, não pipes
+  off_t lidos = ftello(entrada);
+  off_t gravados = ftello(saida);
+  d->est.bytesEntrada = lidos > 0 ? (uint64_t)lidos : 0;
+  d->est.bytesSaida = gravados > 0 ? (uint64_t)gravados : 0;
+  finalizaEstatisticas(&d->est, &inicio);
+
+  return resultado;
+}
+
+// mapeia o arquivo e lê o índice na primeira extração
+static int carregaIndice(Descompactador *d) {
+  if (d->indice != NULL) {
+    return 0;
+  }
+
+  ArquivoMapeado *entrada = abreArquivoMapeado(d->arqEntrada);
+  if (entrada == NULL) {
+    return -1;
+  }
+
+  LeitorBits leitor;
+  iniciaLeitorMemoria(&leitor, dadosArquivoMapeado(entrada),
+                      (size_t)tamanhoArquivoMapeado(entrada));
+  recarregaLeitor(&leitor);
+
+  // só os formatos indexados permitem pular direto para um bloco
+  int versao = -1;
+  if (leBits(&leitor, 32) == ASSINATURA_FORMATO) {
+    versao = (int)leBits(&leitor, 8);
+  }
+  if (versao != VERSAO_BLOCOS_INDEXADOS &&
+      versao != VERSAO_BLOCOS_INTERCALADOS) {
+    finalizaLeitor(&leitor);
+    fechaArquivoMapeado(entrada);
+    return EXTRACAO_SEM_INDICE;
+  }
+  d->intercalado = versao == VERSAO_BLOCOS_INTERCALADOS;
+  d->indice = leCabecalhoIndexado(&leitor, tamanhoArquivoMapeado(entrada),
+                                  &d->tamanhoBloco, &d->numBlocos,
+                                  &d->tamanhoOriginal);
+  finalizaLeitor(&leitor);
+
+  if (d->indice == NULL) {
+    fechaArquivoMapeado(entrada);
+    return -1;
+  }
+
+  d->entradaIndexada = entrada;
+  d->areaOriginal = malloc(d->tamanhoBloco);
+  if (d->areaOriginal == NULL) {
     exit(1);
   }
 
-  descompactaDados(d, arq_entrada, arq_saida);
+  return 0;
+}
+// busca binária pelo bloco que contém a posição dada do arquivo original
+static uint32_t encontraBloco(Descompactador *d, uint64_t posicao) {
+  uint32_t inicio = 0;
+  uint32_t fim = d->numBlocos;
+
+  while (fim - inicio > 1) {
+    uint32_t meio = inicio + (fim - inicio) / 2;
+    if (d->indice[meio].posicaoOriginal <= posicao) {
+      inicio = meio;
+    } else {
+      fim = meio;
+    }
+  }
+
+  return inicio;
+}
+
+long long extraiIntervalo(Descompactador *d, unsigned long long inicio,
+                          unsigned char *destino, size_t quantidade) {
+  int carregado = carregaIndice(d);
+  if (carregado != 0) {
+    return carregado;
+  }
+
+  if (inicio >= d->tamanhoOriginal) {
+    return 0;
+  }
+  if (quantidade > d->tamanhoOriginal - inicio) {
+    quantidade = (size_t)(d->tamanhoOriginal - inicio);
+  }
+
+  size_t copiados = 0;
+  uint32_t bloco = encontraBloco(d, inicio);
+
+  // só os blocos que se sobrepõem ao intervalo são descompactados, e cada um
+  // só até onde o intervalo termina
+  while (copiados < quantidade) {
+    const EntradaIndice *e = &d->indice[bloco++];
+    uint64_t posicao = inicio + copiados;
+    size_t deslocamentoNoBloco = (size_t)(posicao - e->posicaoOriginal);
+    size_t falta = quantidade - copiados;
+    size_t fimNoBloco = deslocamentoNoBloco + falta < e->tamanhoOriginal
+                            ? deslocamentoNoBloco + falta
+                            : e->tamanhoOriginal;
+
+    if (descompactaBlocoDoFormato(d->intercalado,
+                                  dadosArquivoMapeado(d->entradaIndexada) +
+                                      e->deslocamento,
+                                  e->tamanhoCompactado, d->areaOriginal,
+                                  fimNoBloco, tabelaDosBlocos(d),
+                                  &d->est) != 0) {
+      return -1;
+    }
+
+    memcpy(destino + copiados, d->areaOriginal + deslocamentoNoBloco,
+           fimNoBloco - deslocamentoNoBloco);
+    copiados += fimNoBloco - deslocamentoNoBloco;
+  }
+
+  return (long long)copiados;
+}
+
+void defineThreadsDescompactacao(Descompactador *d, int numThreads) {
+  d->numThreads = numThreads;
+}
+
+void defineDicionarioDescompactacao(Descompactador *d, const Dicionario *dic) {
+  d->dicionario = dic;
+}
 
-  fclose(arq_saida);
-  fclose(arq_entrada);
+const Estatisticas *getEstatisticasDescompactacao(Descompactador *d) {
+  return &d->est;
 }
 
 void liberaDescompactador(Descompactador *d) {
   if (d != NULL) {
     free(d->arqEntrada);
     free(d->arqSaida);
-    liberaArvore(d->arvore);
+    fechaArquivoMapeado(d->entradaIndexada);
+    free(d->indice);
+    free(d->areaOriginal);
+    liberaTabelaDecodificacao(d->tabelaBloco);
     free(d);
   }
 }
\ No newline at end of file
@@ -11,9 +11,15 @@
 
 #include "arvore.h"
 #include "bitmap.h"
+#include "dicionario.h"
+#include "estatisticas.h"
 #include "lista.h"
 #include <stdio.h>
 
+// retorno de extraiIntervalo para arquivos sem índice de blocos: só os
+// arquivos criados com -b permitem a extração de um intervalo
+#define EXTRACAO_SEM_INDICE -2
+
 /**
  * @brief Estrutura para representar o descompactador.
  *
@@ -33,15 +39,100 @@ typedef struct descompactador Descompactador;
  */
 Descompactador* criaDescompactador(const char* caminho_entrada);
 
+/**
+ * @brief Troca o arquivo a ser descompactado, para que o mesmo
+ * descompactador seja usado em vários arquivos. O índice carregado por
+ * extraiIntervalo é descartado.
+ *
+ * @param d Ponteiro para a estrutura do Descompactador.
+ * @param caminho_entrada O nome do próximo arquivo a ser descompactado.
+ */
+void defineArquivoDescompactacao(Descompactador* d,
+                                 const char* caminho_entrada);
+
 /**
  * @brief Executa todo o processo de descompactação.
  *
  * Esta função orquestra todas as etapas: leitura do cabeçalho,
  * reconstrução da árvore, leitura dos bits e escrita do arquivo original.
+ * Uma entrada que não é um arquivo regular (uma pipe nomeada) é lida em
+ * pedaços, como em executaDescompactacaoFluxo.
+ *
+ * @param d Ponteiro para a estrutura do Descompactador.
+ * @return 0 em caso de sucesso, -1 se a entrada não puder ser lida, estiver
+ * corrompida ou a saída não puder ser gravada.
+ */
+int executaDescompactacao(Descompactador* d);
+
+/**
+ * @brief Descompacta um fluxo de entrada para um fluxo de saída em uma única
+ * passada, como em "ssh ... | programa -d - > arquivo".
+ *
+ * Aceita todos os formatos: nos indexados, os blocos são lidos na ordem em
+ * que estão no arquivo, sem acesso aleatório nem paralelismo. A memória usada
+ * depende só do tamanho do bloco. O caminho passado a criaDescompactador não
+ * é usado.
+ *
+ * @param d Ponteiro para a estrutura do Descompactador.
+ * @param entrada Fluxo com o arquivo compactado (por exemplo, stdin).
+ * @param saida Fluxo que recebe os bytes originais (por exemplo, stdout).
+ * @return 0 em caso de sucesso, -1 se a entrada estiver corrompida ou houver
+ * erro de gravação.
+ */
+int executaDescompactacaoFluxo(Descompactador* d, FILE* entrada,
+                                FILE* saida);
+
+/**
+ * @brief Define quantas threads descompactam blocos ao mesmo tempo.
+ *
+ * Só tem efeito em arquivos no formato em blocos com índice: cada bloco é
+ * lido, descompactado e gravado direto na sua posição do arquivo de saída.
+ *
+ * @param d Ponteiro para a estrutura do Descompactador.
+ * @param numThreads Quantidade de threads (1 = sem paralelismo).
+ */
+void defineThreadsDescompactacao(Descompactador* d, int numThreads);
+
+/**
+ * @brief Define o dicionário dos arquivos compactados com uma tabela
+ * treinada. As tabelas de decodificação dele são montadas uma única vez e
+ * reaproveitadas em todos os arquivos; um arquivo compactado com outro
+ * dicionário é recusado.
+ * @param d Ponteiro para a estrutura do Descompactador.
+ * @param dic Dicionário carregado, que precisa existir enquanto o
+ * descompactador for usado, ou NULL.
+ */
+void defineDicionarioDescompactacao(Descompactador *d, const Dicionario *dic);
+
+/**
+ * @brief Obtém as estatísticas da última descompactação: tempo de cada fase,
+ * bytes lidos e gravados, tamanho dos códigos e pico de memória.
+ *
+ * @param d Ponteiro para a estrutura do Descompactador (após
+ * executaDescompactacao).
+ * @return Ponteiro para as estatísticas, válido enquanto o descompactador
+ * existir.
+ */
+const Estatisticas* getEstatisticasDescompactacao(Descompactador* d);
+
+/**
+ * @brief Extrai um intervalo de bytes do arquivo original sem descompactar o
+ * arquivo inteiro.
+ *
+ * Usa o índice de blocos (formato em blocos com índice) para descompactar só
+ * os blocos que se sobrepõem ao intervalo. O índice é lido na primeira
+ * chamada e reaproveitado nas seguintes.
  *
  * @param d Ponteiro para a estrutura do Descompactador.
+ * @param inicio Posição do primeiro byte no arquivo original.
+ * @param destino Área que recebe os bytes extraídos.
+ * @param quantidade Quantidade de bytes desejada.
+ * @return Quantidade de bytes extraídos (menor que a pedida se o intervalo
+ * passar do fim do arquivo), EXTRACAO_SEM_INDICE se o arquivo não for do
+ * formato com índice, ou -1 se não puder ser lido ou estiver corrompido.
  */
-void executaDescompactacao(Descompactador* d);
+long long extraiIntervalo(Descompactador* d, unsigned long long inicio,
+                          unsigned char* destino, size_t quantidade);
 
 /**
  * @brief Libera toda a memória associada ao descompactador.
@@ -0,0 +1,163 @@
+/*
+ *
+ * Tad Dicionario
+ * Tabela de códigos treinada em um conjunto de amostras e guardada em um
+ * arquivo à parte, para compactar arquivos pequenos sem contar os bytes e
+ * sem gravar a tabela em cada um
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "dicionario.h"
+#include "arquivo.h"
+#include "arvore.h"
+#include "bitmap.h"
+#include "histograma.h"
+#include "leitor.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// versão do próprio arquivo do dicionário
+#define VERSAO_ARQUIVO_DICIONARIO 1
+
+struct dicionario {
+  uint32_t identificador;
+  unsigned char comprimentos[NUM_SIMBOLOS];
+  CodigoHuffman codigos[NUM_SIMBOLOS];
+  TabelaDecodificacao *tabela;
+};
+
+int treinaDicionario(const char *caminho, char *const amostras[],
+                     int numAmostras) {
+  uint64_t frequencias[NUM_SIMBOLOS] = {0};
+
+  // o histograma somado de todas as amostras, com um EOF no fim de cada uma
+  for (int i = 0; i < numAmostras; i++) {
+    ArquivoMapeado *a = abreArquivoMapeado(amostras[i]);
+    if (a == NULL) {
+      return -1;
+    }
+    contaBytes(dadosArquivoMapeado(a), (size_t)tamanhoArquivoMapeado(a),
+               frequencias);
+    fechaArquivoMapeado(a);
+    frequencias[SIMBOLO_EOF]++;
+  }
+
+  // os bytes ausentes das amostras também precisam de um código
+  for (int s = 0; s < NUM_SIMBOLOS; s++) {
+    if (frequencias[s] == 0) {
+      frequencias[s] = 1;
+    }
+  }
+
+  unsigned char comprimentos[NUM_SIMBOLOS];
+  ArenaArvore *arena = criaArenaArvore(2 * NUM_SIMBOLOS - 1);
+  Arvore *arvore =
+      constroiArvoreDeFrequencias(frequencias, NUM_SIMBOLOS, arena);
+  int maior = calculaComprimentos(arvore, comprimentos, NUM_SIMBOLOS);
+  liberaArenaArvore(arena);
+  if (aplicaLimiteComprimentos(frequencias, NUM_SIMBOLOS,
+                               LIMITE_BITS_DICIONARIO, maior,
+                               comprimentos) != 0) {
+    return -1;
+  }
+
+  // assinatura, versão e os comprimentos, como no cabeçalho canônico
+  bitmap *bm = bitmapInit(8 * 1024 * 8);
+  bitmapAppendBits(bm, ASSINATURA_DICIONARIO, 32);
+  bitmapAppendBits(bm, VERSAO_ARQUIVO_DICIONARIO, 8);
+  escreveComprimentos(bm, comprimentos, NUM_SIMBOLOS);
+  bitmapAppendBits(bm, 0, (8 - bitmapGetLength(bm) % 8) % 8);
+
+  int resultado = 0;
+  FILE *arq = fopen(caminho, "wb");
+  if (arq == NULL) {
+    resultado = -1;
+  } else {
+    size_t tamanho = (size_t)(bitmapGetLength(bm) / 8);
+    if (fwrite(bitmapGetContents(bm), 1, tamanho, arq) != tamanho) {
+      resultado = -1;
+    }
+    if (fclose(arq) != 0) {
+      resultado = -1;
+    }
+  }
+  bitmapLibera(bm);
+
+  return resultado;
+}
+
+// FNV-1a dos comprimentos: dicionários com os mesmos códigos têm o mesmo
+// identificador
+static uint32_t calculaIdentificador(const unsigned char comprimentos[]) {
+  uint32_t h = 2166136261u;
+  for (int s = 0; s < NUM_SIMBOLOS; s++) {
+    h ^= comprimentos[s];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+Dicionario *carregaDicionario(const char *caminho) {
+  ArquivoMapeado *a = abreArquivoMapeado(caminho);
+  if (a == NULL) {
+    return NULL;
+  }
+
+  Dicionario *d = calloc(1, sizeof(Dicionario));
+  if (d == NULL) {
+    exit(1);
+  }
+
+  LeitorBits leitor;
+  iniciaLeitorMemoria(&leitor, dadosArquivoMapeado(a),
+                      (size_t)tamanhoArquivoMapeado(a));
+  int invalido = leBits(&leitor, 32) != ASSINATURA_DICIONARIO ||
+                 leBits(&leitor, 8) != VERSAO_ARQUIVO_DICIONARIO ||
+                 leComprimentos(&leitor, d->comprimentos, NUM_SIMBOLOS) != 0 ||
+                 leitorEstourou(&leitor);
+  finalizaLeitor(&leitor);
+  fechaArquivoMapeado(a);
+
+  // todo byte precisa ser codificável
+  for (int s = 0; s < NUM_SIMBOLOS && !invalido; s++) {
+    invalido = d->comprimentos[s] == 0;
+  }
+  if (!invalido) {
+    invalido =
+        montaTabelaCodigos(d->comprimentos, NUM_SIMBOLOS, d->codigos) != 0;
+  }
+  if (!invalido) {
+    d->tabela = criaTabelaDosComprimentos(d->comprimentos, NUM_SIMBOLOS);
+    invalido = d->tabela == NULL;
+  }
+  if (invalido) {
+    liberaDicionario(d);
+    return NULL;
+  }
+
+  d->identificador = calculaIdentificador(d->comprimentos);
+  return d;
+}
+
+uint32_t identificadorDicionario(const Dicionario *d) {
+  return d->identificador;
+}
+
+const CodigoHuffman *codigosDicionario(const Dicionario *d) {
+  return d->codigos;
+}
+
+TabelaDecodificacao *tabelaDicionario(const Dicionario *d) {
+  return d->tabela;
+}
+
+void liberaDicionario(Dicionario *d) {
+  if (d == NULL) {
+    return;
+  }
+  if (d->tabela != NULL) {
+    liberaTabelaDecodificacao(d->tabela);
+  }
+  free(d);
+}
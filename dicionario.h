@@ -0,0 +1,82 @@
+/*
+ *
+ * Tad Dicionario
+ * Tabela de códigos treinada em um conjunto de amostras e guardada em um
+ * arquivo à parte, para compactar arquivos pequenos sem contar os bytes e
+ * sem gravar a tabela em cada um
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef DICIONARIO_H
+#define DICIONARIO_H
+
+#include "decodificador.h"
+#include "huffman.h"
+#include <stdint.h>
+
+// "\x89HUD" no início do arquivo do dicionário
+#define ASSINATURA_DICIONARIO 0x89485544u
+
+// versão compactada com um dicionário: assinatura, versão, identificador do
+// dicionário e os códigos, terminados pelo símbolo EOF
+#define VERSAO_DICIONARIO 7
+
+// comprimento máximo dos códigos do dicionário: os bytes que não aparecem
+// nas amostras continuam codificáveis, mas sem códigos longos demais
+#define LIMITE_BITS_DICIONARIO 20
+
+typedef struct dicionario Dicionario;
+
+/**
+ * @brief Treina um dicionário com o histograma somado das amostras e o grava
+ * em um arquivo. Todos os bytes recebem um código, mesmo os que não aparecem
+ * nas amostras, e o EOF conta uma vez por amostra.
+ * @param caminho Arquivo do dicionário a ser criado.
+ * @param amostras Caminhos dos arquivos de amostra.
+ * @param numAmostras Quantidade de amostras.
+ * @return 0 em caso de sucesso, -1 se alguma amostra não puder ser lida ou o
+ * dicionário não puder ser gravado.
+ */
+int treinaDicionario(const char *caminho, char *const amostras[],
+                     int numAmostras);
+
+/**
+ * @brief Carrega um dicionário e já monta as tabelas de codificação e de
+ * decodificação, reaproveitadas por todos os arquivos (e threads) que o
+ * usam.
+ * @param caminho Arquivo criado por treinaDicionario.
+ * @return Ponteiro para o dicionário, ou NULL se o arquivo for inválido.
+ */
+Dicionario *carregaDicionario(const char *caminho);
+
+/**
+ * @brief Obtém o identificador gravado nos arquivos compactados com o
+ * dicionário, para recusar a descompactação com outro dicionário.
+ * @param d Ponteiro para o dicionário.
+ * @return O identificador.
+ */
+uint32_t identificadorDicionario(const Dicionario *d);
+
+/**
+ * @brief Obtém a tabela de códigos de escrita.
+ * @param d Ponteiro para o dicionário.
+ * @return Tabela com NUM_SIMBOLOS códigos.
+ */
+const CodigoHuffman *codigosDicionario(const Dicionario *d);
+
+/**
+ * @brief Obtém a tabela de decodificação, que só é lida durante a
+ * decodificação e pode ser compartilhada.
+ * @param d Ponteiro para o dicionário.
+ * @return Ponteiro para a tabela.
+ */
+TabelaDecodificacao *tabelaDicionario(const Dicionario *d);
+
+/**
+ * @brief Libera o dicionário e as suas tabelas.
+ * @param d Ponteiro para o dicionário (pode ser NULL).
+ */
+void liberaDicionario(Dicionario *d);
+
+#endif // DICIONARIO_H
@@ -0,0 +1,79 @@
+/*
+ *
+ * Tad EscritorBits
+ * Escrita de códigos inteiros em um acumulador de 64 bits, descarregado no
+ * mapa de bits uma palavra de cada vez
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef ESCRITOR_H
+#define ESCRITOR_H
+
+#include "bitmap.h"
+#include <stdint.h>
+
+/**
+ * @brief Estrutura do escritor de bits.
+ *
+ * Assim como no LeitorBits, a estrutura é exposta para que escreveCodigo,
+ * chamada uma vez por byte da entrada, possa ser expandida inline.
+ */
+typedef struct escritorBits {
+  uint64_t acumulador;        // bits pendentes, alinhados à esquerda
+  unsigned int bitsPendentes; // sempre menos de 32 entre as chamadas
+  bitmap *bm;                 // destino dos bits
+} EscritorBits;
+
+/**
+ * @brief Inicializa um escritor que acrescenta bits ao final do mapa.
+ * @param e Ponteiro para o escritor.
+ * @param bm Mapa de bits de destino.
+ */
+static inline void iniciaEscritor(EscritorBits *e, bitmap *bm) {
+  e->acumulador = 0;
+  e->bitsPendentes = 0;
+  e->bm = bm;
+}
+
+/**
+ * @brief Descarrega os bits que ainda estão no acumulador.
+ * @param e Ponteiro para o escritor.
+ */
+static inline void finalizaEscritor(EscritorBits *e) {
+  if (e->bitsPendentes > 0) {
+    bitmapAppendBits(e->bm, e->acumulador >> (64 - e->bitsPendentes),
+                     e->bitsPendentes);
+  }
+  e->acumulador = 0;
+  e->bitsPendentes = 0;
+}
+
+/**
+ * @brief Escreve um código inteiro, do bit mais significativo para o menos.
+ * @param e Ponteiro para o escritor.
+ * @param codigo Valor do código (menor que 2^comprimento).
+ * @param comprimento Quantidade de bits do código (1 a 64).
+ */
+static inline void escreveCodigo(EscritorBits *e, uint64_t codigo,
+                                 unsigned int comprimento) {
+  // códigos com mais de 32 bits são raros: a parte alta vai antes
+  if (comprimento > 32) {
+    finalizaEscritor(e);
+    bitmapAppendBits(e->bm, codigo >> 32, comprimento - 32);
+    codigo &= 0xFFFFFFFFu;
+    comprimento = 32;
+  }
+
+  e->acumulador |= codigo << (64 - e->bitsPendentes - comprimento);
+  e->bitsPendentes += comprimento;
+
+  // descarrega uma palavra de 32 bits de uma vez
+  if (e->bitsPendentes >= 32) {
+    bitmapAppendBits(e->bm, e->acumulador >> 32, 32);
+    e->acumulador <<= 32;
+    e->bitsPendentes -= 32;
+  }
+}
+
+#endif // ESCRITOR_H
@@ -0,0 +1,199 @@
+/*
+ *
+ * Estatísticas de execução
+ * Tempo de cada fase, bytes lidos e gravados, entropia do histograma e
+ * tamanho dos códigos de uma compactação ou descompactação
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "estatisticas.h"
+#include <sys/resource.h>
+#include <time.h>
+
+static const char *nomesFases[NUM_FASES] = {
+    "contagem",   "arvore",         "tabela", "cabecalho",
+    "codificacao", "decodificacao", "escrita"};
+
+static double leRelogio(clockid_t relogio) {
+  struct timespec t;
+  clock_gettime(relogio, &t);
+  return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+void iniciaCronometro(Cronometro *c) {
+  c->relogio = leRelogio(CLOCK_MONOTONIC);
+  c->cpu = leRelogio(CLOCK_THREAD_CPUTIME_ID);
+}
+
+void iniciaCronometroProcesso(Cronometro *c) {
+  c->relogio = leRelogio(CLOCK_MONOTONIC);
+  c->cpu = leRelogio(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+void marcaFase(Estatisticas *e, Fase fase, Cronometro *c) {
+  Cronometro agora;
+  iniciaCronometro(&agora);
+
+  e->fases[fase].segundos += agora.relogio - c->relogio;
+  e->fases[fase].segundosCpu += agora.cpu - c->cpu;
+  *c = agora;
+}
+
+// sem depender da libm: separa a potência de 2 e calcula o logaritmo da
+// mantissa, entre 1 e 2, pela série de atanh
+double log2Inteiro(uint64_t x) {
+  int expoente = 63 - __builtin_clzll(x);
+  double m = (double)x / (double)(1ULL << expoente);
+
+  // ln(m) = 2 atanh(z), com z = (m - 1) / (m + 1) <= 1/3
+  double z = (m - 1) / (m + 1);
+  double z2 = z * z;
+  double termo = z;
+  double soma = 0;
+  for (int k = 1; k < 40; k += 2) {
+    soma += termo / k;
+    termo *= z2;
+  }
+
+  return expoente + 2 * soma / 0.69314718055994530942;
+}
+
+void acumulaEntropia(Estatisticas *e, const uint64_t frequencias[], int n) {
+  // H = N log2 N - soma f log2 f, em bits para os N símbolos
+  uint64_t total = 0;
+  double somaFLogF = 0;
+  for (int i = 0; i < n; i++) {
+    if (frequencias[i] > 0) {
+      total += (uint64_t)frequencias[i];
+      somaFLogF += frequencias[i] * log2Inteiro((uint64_t)frequencias[i]);
+    }
+  }
+  if (total == 0) {
+    return;
+  }
+
+  e->simbolos += total;
+  e->bitsEntropia += (double)total * log2Inteiro(total) - somaFLogF;
+}
+
+void registraComprimentos(Estatisticas *e, const unsigned char comprimentos[],
+                          int n) {
+  int presentes = 0;
+  for (int i = 0; i < n; i++) {
+    if (comprimentos[i] > 0) {
+      presentes++;
+      if (comprimentos[i] > e->maiorComprimento) {
+        e->maiorComprimento = comprimentos[i];
+      }
+    }
+  }
+
+  // uma árvore binária cheia com k folhas tem 2k - 1 nós
+  int nos = presentes > 0 ? 2 * presentes - 1 : 0;
+  if (nos > e->nosArvore) {
+    e->nosArvore = nos;
+  }
+}
+
+void somaEstatisticas(Estatisticas *destino, const Estatisticas *origem) {
+  for (int i = 0; i < NUM_FASES; i++) {
+    destino->fases[i].segundos += origem->fases[i].segundos;
+    destino->fases[i].segundosCpu += origem->fases[i].segundosCpu;
+  }
+  destino->bytesEntrada += origem->bytesEntrada;
+  destino->bytesSaida += origem->bytesSaida;
+  destino->simbolos += origem->simbolos;
+  destino->bitsEntropia += origem->bitsEntropia;
+  destino->bitsSemLimite += origem->bitsSemLimite;
+  destino->bitsComLimite += origem->bitsComLimite;
+  if (origem->maiorComprimento > destino->maiorComprimento) {
+    destino->maiorComprimento = origem->maiorComprimento;
+  }
+  if (origem->nosArvore > destino->nosArvore) {
+    destino->nosArvore = origem->nosArvore;
+  }
+}
+
+void finalizaEstatisticas(Estatisticas *e, const Cronometro *inicio) {
+  Cronometro fim;
+  iniciaCronometroProcesso(&fim);
+  e->total.segundos = fim.relogio - inicio->relogio;
+  e->total.segundosCpu = fim.cpu - inicio->cpu;
+
+  // no Linux ru_maxrss já vem em KiB
+  struct rusage uso;
+  if (getrusage(RUSAGE_SELF, &uso) == 0) {
+    e->picoMemoriaKb = uso.ru_maxrss;
+  }
+}
+
+// bits por símbolo da entropia e dos códigos usados
+static double mediaPorSimbolo(double bits, uint64_t simbolos) {
+  return simbolos > 0 ? bits / (double)simbolos : 0;
+}
+
+void imprimeEstatisticas(const Estatisticas *e, const char *operacao,
+                         FILE *saida) {
+  fprintf(saida, "%s: %llu -> %llu bytes", operacao,
+          (unsigned long long)e->bytesEntrada,
+          (unsigned long long)e->bytesSaida);
+  if (e->bytesEntrada > 0) {
+    fprintf(saida, " (%.2f%%)",
+            100.0 * (double)e->bytesSaida / (double)e->bytesEntrada);
+  }
+  fprintf(saida, "\n%-15s %12s %12s\n", "fase", "relogio (s)", "cpu (s)");
+
+  // só as fases que a operação executou
+  for (int i = 0; i < NUM_FASES; i++) {
+    if (e->fases[i].segundos > 0 || e->fases[i].segundosCpu > 0) {
+      fprintf(saida, "%-15s %12.6f %12.6f\n", nomesFases[i],
+              e->fases[i].segundos, e->fases[i].segundosCpu);
+    }
+  }
+  fprintf(saida, "%-15s %12.6f %12.6f\n", "total", e->total.segundos,
+          e->total.segundosCpu);
+
+  if (e->simbolos > 0) {
+    double entropia = mediaPorSimbolo(e->bitsEntropia, e->simbolos);
+    double media = mediaPorSimbolo((double)e->bitsComLimite, e->simbolos);
+    fprintf(saida,
+            "entropia: %.4f bits/simbolo, codigo medio: %.4f bits/simbolo",
+            entropia, media);
+    // com um único símbolo a entropia é zero e a diferença não tem sentido
+    if (entropia > 0) {
+      fprintf(saida, " (+%.2f%%)", 100.0 * (media - entropia) / entropia);
+    }
+    fprintf(saida, "\n");
+  }
+  if (e->nosArvore > 0) {
+    fprintf(saida, "maior codigo: %d bits, nos da maior arvore: %d\n",
+            e->maiorComprimento, e->nosArvore);
+  }
+  fprintf(saida, "pico de memoria: %ld KiB\n", e->picoMemoriaKb);
+}
+
+void imprimeEstatisticasJson(const Estatisticas *e, const char *operacao,
+                             FILE *saida) {
+  fprintf(saida, "{\"operacao\":\"%s\",\"fases\":{", operacao);
+  for (int i = 0; i < NUM_FASES; i++) {
+    fprintf(saida, "%s\"%s\":{\"relogio_s\":%.6f,\"cpu_s\":%.6f}",
+            i > 0 ? "," : "", nomesFases[i], e->fases[i].segundos,
+            e->fases[i].segundosCpu);
+  }
+  fprintf(saida,
+          "},\"total\":{\"relogio_s\":%.6f,\"cpu_s\":%.6f},"
+          "\"bytes_entrada\":%llu,\"bytes_saida\":%llu,\"simbolos\":%llu,"
+          "\"entropia_bits_simbolo\":%.6f,\"codigo_medio_bits_simbolo\":%.6f,"
+          "\"bits_sem_limite\":%llu,\"bits_com_limite\":%llu,"
+          "\"maior_comprimento\":%d,\"nos_arvore\":%d,"
+          "\"pico_memoria_kb\":%ld}\n",
+          e->total.segundos, e->total.segundosCpu,
+          (unsigned long long)e->bytesEntrada,
+          (unsigned long long)e->bytesSaida, (unsigned long long)e->simbolos,
+          mediaPorSimbolo(e->bitsEntropia, e->simbolos),
+          mediaPorSimbolo((double)e->bitsComLimite, e->simbolos),
+          (unsigned long long)e->bitsSemLimite,
+          (unsigned long long)e->bitsComLimite, e->maiorComprimento,
+          e->nosArvore, e->picoMemoriaKb);
+}
@@ -0,0 +1,143 @@
+/*
+ *
+ * Estatísticas de execução
+ * Tempo de cada fase, bytes lidos e gravados, entropia do histograma e
+ * tamanho dos códigos de uma compactação ou descompactação
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef ESTATISTICAS_H
+#define ESTATISTICAS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+  FASE_CONTAGEM,      // histograma dos bytes
+  FASE_ARVORE,        // árvore de Huffman e comprimentos dos códigos
+  FASE_TABELA,        // tabela de códigos ou de decodificação
+  FASE_CABECALHO,     // escrita ou leitura do cabeçalho
+  FASE_CODIFICACAO,   // laço que escreve os códigos
+  FASE_DECODIFICACAO, // laço que lê os códigos
+  FASE_ESCRITA,       // gravação do resultado no arquivo
+  NUM_FASES
+} Fase;
+
+/**
+ * @brief Tempo acumulado de uma fase. No modo em blocos as fases rodam uma
+ * vez por bloco, possivelmente em várias threads, e os tempos são somados.
+ */
+typedef struct {
+  double segundos;    // tempo de relógio
+  double segundosCpu; // tempo de CPU da thread que executou a fase
+} TempoFase;
+
+/**
+ * @brief Estatísticas de uma compactação ou descompactação.
+ */
+typedef struct {
+  TempoFase fases[NUM_FASES];
+  TempoFase total; // operação inteira (a CPU é a de todo o processo)
+  uint64_t bytesEntrada;
+  uint64_t bytesSaida;
+  uint64_t simbolos;     // símbolos dos histogramas (só na compactação)
+  double bitsEntropia;   // limite de Shannon dos histogramas, em bits
+  uint64_t bitsSemLimite; // dados codificados com a árvore de Huffman
+  uint64_t bitsComLimite; // dados codificados com os códigos usados
+  int maiorComprimento;   // maior código, em bits
+  int nosArvore;          // nós da maior árvore
+  long picoMemoriaKb;     // pico de memória residente do processo
+} Estatisticas;
+
+/**
+ * @brief Marca de tempo usada para medir as fases.
+ */
+typedef struct {
+  double relogio;
+  double cpu;
+} Cronometro;
+
+/**
+ * @brief Guarda o instante atual no cronômetro.
+ * @param c Ponteiro para o cronômetro.
+ */
+void iniciaCronometro(Cronometro *c);
+
+/**
+ * @brief Soma à fase o tempo passado desde a última marca do cronômetro e o
+ * reinicia, para que fases seguidas possam ser medidas em sequência.
+ * @param e Estatísticas que recebem o tempo.
+ * @param fase Fase que acabou de terminar.
+ * @param c Cronômetro iniciado na mesma thread.
+ */
+void marcaFase(Estatisticas *e, Fase fase, Cronometro *c);
+
+/**
+ * @brief Calcula o logaritmo na base 2 de um inteiro.
+ * @param x Valor positivo.
+ * @return log2(x).
+ */
+double log2Inteiro(uint64_t x);
+
+/**
+ * @brief Soma a entropia de um histograma: o menor tamanho possível, em bits,
+ * para os seus símbolos codificados um a um.
+ * @param e Estatísticas que recebem a entropia.
+ * @param frequencias Frequência de cada símbolo.
+ * @param n Quantidade de símbolos.
+ */
+void acumulaEntropia(Estatisticas *e, const uint64_t frequencias[], int n);
+
+/**
+ * @brief Atualiza o maior comprimento e o tamanho da maior árvore a partir
+ * dos comprimentos de um código.
+ * @param e Estatísticas a atualizar.
+ * @param comprimentos Comprimento de cada símbolo (0 = ausente).
+ * @param n Quantidade de símbolos.
+ */
+void registraComprimentos(Estatisticas *e, const unsigned char comprimentos[],
+                          int n);
+
+/**
+ * @brief Junta as estatísticas de um bloco às da operação inteira.
+ * @param destino Estatísticas da operação.
+ * @param origem Estatísticas do bloco.
+ */
+void somaEstatisticas(Estatisticas *destino, const Estatisticas *origem);
+
+/**
+ * @brief Guarda o instante atual no cronômetro, com o tempo de CPU de todas
+ * as threads do processo, para medir a operação inteira.
+ * @param c Ponteiro para o cronômetro.
+ */
+void iniciaCronometroProcesso(Cronometro *c);
+
+/**
+ * @brief Fecha a medição: guarda o tempo total e o pico de memória do
+ * processo.
+ * @param e Estatísticas da operação.
+ * @param inicio Cronômetro iniciado por iniciaCronometroProcesso no começo
+ * da operação.
+ */
+void finalizaEstatisticas(Estatisticas *e, const Cronometro *inicio);
+
+/**
+ * @brief Imprime as estatísticas em forma de tabela, para leitura.
+ * @param e Estatísticas a imprimir.
+ * @param operacao Nome da operação ("compactacao" ou "descompactacao").
+ * @param saida Arquivo de destino.
+ */
+void imprimeEstatisticas(const Estatisticas *e, const char *operacao,
+                         FILE *saida);
+
+/**
+ * @brief Imprime as estatísticas como um objeto JSON em uma linha.
+ * @param e Estatísticas a imprimir.
+ * @param operacao Nome da operação ("compactacao" ou "descompactacao").
+ * @param saida Arquivo de destino.
+ */
+void imprimeEstatisticasJson(const Estatisticas *e, const char *operacao,
+                             FILE *saida);
+
+#endif // ESTATISTICAS_H
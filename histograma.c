@@ -0,0 +1,156 @@
+/*
+ *
+ * Histograma de bytes
+ * Contagem da frequência de cada byte de uma região de memória, com várias
+ * tabelas de contadores intercaladas e instruções vetoriais quando existirem
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "histograma.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+// no i386 o SSE2 não é garantido, e o compilador não gera as suas instruções
+// sem -msse2; lá fica a versão genérica
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HISTOGRAMA_X86
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HISTOGRAMA_NEON
+#endif
+
+#define NUM_TABELAS 4
+
+// quantos bytes são examinados por vez na procura de trechos repetidos
+#define TAMANHO_TRECHO 32
+
+// os contadores internos são de 32 bits; os dados são divididos em partes
+// pequenas o bastante para que nenhum deles transborde antes da soma final
+#define MAX_BYTES_POR_PASSADA ((size_t)1 << 30)
+
+typedef uint32_t Tabelas[NUM_TABELAS][256];
+
+// conta os bytes um a um, alternando entre as tabelas
+static inline void contaEscalar(const unsigned char *p, size_t n,
+                                Tabelas t) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    uint64_t v;
+    memcpy(&v, p + i, sizeof(v));
+    t[0][v & 0xFF]++;
+    t[1][(v >> 8) & 0xFF]++;
+    t[2][(v >> 16) & 0xFF]++;
+    t[3][(v >> 24) & 0xFF]++;
+    t[0][(v >> 32) & 0xFF]++;
+    t[1][(v >> 40) & 0xFF]++;
+    t[2][(v >> 48) & 0xFF]++;
+    t[3][v >> 56]++;
+  }
+  for (; i < n; i++) {
+    t[i % NUM_TABELAS][p[i]]++;
+  }
+}
+
+#if defined(HISTOGRAMA_X86)
+
+// SSE2 faz parte de todo processador x86-64: dois vetores de 16 bytes por
+// trecho
+static void contaTabelasSSE2(const unsigned char *p, size_t n, Tabelas t) {
+  size_t i = 0;
+  for (; i + TAMANHO_TRECHO <= n; i += TAMANHO_TRECHO) {
+    __m128i primeiro = _mm_set1_epi8((char)p[i]);
+    __m128i a = _mm_loadu_si128((const __m128i *)(p + i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(p + i + 16));
+    __m128i iguais =
+        _mm_and_si128(_mm_cmpeq_epi8(a, primeiro), _mm_cmpeq_epi8(b, primeiro));
+    if (_mm_movemask_epi8(iguais) == 0xFFFF) {
+      t[0][p[i]] += TAMANHO_TRECHO;
+    } else {
+      contaEscalar(p + i, TAMANHO_TRECHO, t);
+    }
+  }
+  contaEscalar(p + i, n - i, t);
+}
+
+__attribute__((target("avx2"))) static void
+contaTabelasAVX2(const unsigned char *p, size_t n, Tabelas t) {
+  size_t i = 0;
+  for (; i + TAMANHO_TRECHO <= n; i += TAMANHO_TRECHO) {
+    __m256i primeiro = _mm256_set1_epi8((char)p[i]);
+    __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, primeiro)) == -1) {
+      t[0][p[i]] += TAMANHO_TRECHO;
+    } else {
+      contaEscalar(p + i, TAMANHO_TRECHO, t);
+    }
+  }
+  contaEscalar(p + i, n - i, t);
+}
+
+#elif defined(HISTOGRAMA_NEON)
+
+// NEON faz parte de todo processador AArch64
+static void contaTabelasNEON(const unsigned char *p, size_t n, Tabelas t) {
+  size_t i = 0;
+  for (; i + TAMANHO_TRECHO <= n; i += TAMANHO_TRECHO) {
+    uint8x16_t primeiro = vdupq_n_u8(p[i]);
+    uint8x16_t iguais = vandq_u8(vceqq_u8(vld1q_u8(p + i), primeiro),
+                                 vceqq_u8(vld1q_u8(p + i + 16), primeiro));
+    if (vminvq_u8(iguais) == 0xFF) {
+      t[0][p[i]] += TAMANHO_TRECHO;
+    } else {
+      contaEscalar(p + i, TAMANHO_TRECHO, t);
+    }
+  }
+  contaEscalar(p + i, n - i, t);
+}
+
+#else
+
+// versão sem instruções vetoriais
+static void contaTabelasGenerico(const unsigned char *p, size_t n,
+                                 Tabelas t) {
+  contaEscalar(p, n, t);
+}
+
+#endif
+
+typedef void (*FuncaoContagem)(const unsigned char *, size_t, Tabelas);
+
+static FuncaoContagem conta;
+static pthread_once_t escolhaFeita = PTHREAD_ONCE_INIT;
+
+// escolhe a melhor versão para o processador em uso
+static void escolheFuncao(void) {
+#if defined(HISTOGRAMA_X86)
+  __builtin_cpu_init();
+  conta = __builtin_cpu_supports("avx2") ? contaTabelasAVX2 : contaTabelasSSE2;
+#elif defined(HISTOGRAMA_NEON)
+  conta = contaTabelasNEON;
+#else
+  conta = contaTabelasGenerico;
+#endif
+}
+
+void contaBytes(const unsigned char *dados, size_t n, uint64_t frequencias[]) {
+  // os blocos são contados por várias threads, mas a escolha é feita uma vez
+  pthread_once(&escolhaFeita, escolheFuncao);
+
+  while (n > 0) {
+    size_t parte = n < MAX_BYTES_POR_PASSADA ? n : MAX_BYTES_POR_PASSADA;
+
+    Tabelas t;
+    memset(t, 0, sizeof(t));
+    conta(dados, parte, t);
+
+    for (int s = 0; s < 256; s++) {
+      frequencias[s] += (uint64_t)t[0][s] + t[1][s] + t[2][s] + t[3][s];
+    }
+
+    dados += parte;
+    n -= parte;
+  }
+}
@@ -0,0 +1,32 @@
+/*
+ *
+ * Histograma de bytes
+ * Contagem da frequência de cada byte de uma região de memória, com várias
+ * tabelas de contadores intercaladas e instruções vetoriais quando existirem
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef HISTOGRAMA_H
+#define HISTOGRAMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Soma às frequências a quantidade de vezes que cada byte aparece nos
+ * dados.
+ *
+ * Os bytes são distribuídos entre quatro tabelas de contadores, somadas no
+ * final, para que bytes repetidos em sequência não fiquem esperando o
+ * incremento anterior chegar à memória. Trechos formados por um único byte
+ * repetido são detectados com instruções vetoriais (AVX2, escolhida em tempo
+ * de execução, SSE2 ou NEON) e contados de uma vez.
+ *
+ * @param dados Início da região.
+ * @param n Tamanho da região em bytes.
+ * @param frequencias Vetor com 256 posições, acumulado (não é zerado).
+ */
+void contaBytes(const unsigned char *dados, size_t n, uint64_t frequencias[]);
+
+#endif // HISTOGRAMA_H
@@ -0,0 +1,604 @@
+/*
+ *
+ * Construção dos códigos de Huffman
+ * Árvore a partir das frequências, comprimentos dos códigos, códigos
+ * canônicos e o cabeçalho compacto com os comprimentos
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "huffman.h"
+#include <stdlib.h>
+#include <string.h>
+
+// alfabeto usado para codificar os comprimentos:
+// 0 a 15: comprimento literal
+// 16: repete o comprimento anterior de 3 a 6 vezes (2 bits extras)
+// 17: de 3 a 10 zeros (3 bits extras)
+// 18: de 11 a 138 zeros (7 bits extras)
+// 19: comprimento literal de 16 a 79 (6 bits extras)
+#define NUM_SIMBOLOS_COMPRIMENTO 20
+#define REPETE_ANTERIOR 16
+#define ZEROS_CURTO 17
+#define ZEROS_LONGO 18
+#define COMPRIMENTO_LONGO 19
+
+// ordem em que os comprimentos do segundo código são gravados, dos mais para
+// os menos usados, para que os zeros do final possam ser omitidos
+static const int ordemComprimentos[NUM_SIMBOLOS_COMPRIMENTO] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15, 19};
+
+// item da fila de prioridade: a ordem de criação desempata as frequências, e
+// também é o índice do nó (as folhas primeiro, depois os nós internos)
+typedef struct {
+  uint64_t frequencia;
+  int ordem;
+} ItemFila;
+
+// o item 'a' sai da fila antes do 'b'? Com frequências iguais sai primeiro o
+// criado por último, a mesma ordem que a lista ordenada usava
+static int vemAntes(const ItemFila *a, const ItemFila *b) {
+  if (a->frequencia != b->frequencia) {
+    return a->frequencia < b->frequencia;
+  }
+  return a->ordem > b->ordem;
+}
+
+static void desceNoHeap(ItemFila *heap, int tamanho, int i) {
+  ItemFila item = heap[i];
+  for (;;) {
+    int filho = 2 * i + 1;
+    if (filho >= tamanho) {
+      break;
+    }
+    if (filho + 1 < tamanho && vemAntes(&heap[filho + 1], &heap[filho])) {
+      filho++;
+    }
+    if (!vemAntes(&heap[filho], &item)) {
+      break;
+    }
+    heap[i] = heap[filho];
+    i = filho;
+  }
+  heap[i] = item;
+}
+
+static void sobeNoHeap(ItemFila *heap, int i) {
+  ItemFila item = heap[i];
+  while (i > 0) {
+    int pai = (i - 1) / 2;
+    if (!vemAntes(&item, &heap[pai])) {
+      break;
+    }
+    heap[i] = heap[pai];
+    i = pai;
+  }
+  heap[i] = item;
+}
+
+static ItemFila removeDoHeap(ItemFila *heap, int *tamanho) {
+  ItemFila primeiro = heap[0];
+  heap[0] = heap[--*tamanho];
+  desceNoHeap(heap, *tamanho, 0);
+  return primeiro;
+}
+
+// Combina os nós pelo heap sem montar a árvore: as folhas são os símbolos
+// presentes, na ordem dos símbolos (simbolos[k] é o símbolo da folha k), e o
+// k-ésimo nó interno recebe o índice folhas + k, com os filhos em
+// filhos[2k] e filhos[2k + 1]. Retorna a quantidade de folhas.
+static int combinaNos(const uint64_t frequencias[], int n, int simbolos[],
+                      int filhos[]) {
+  ItemFila heap[MAX_SIMBOLOS_ALFABETO];
+
+  int tamanho = 0;
+  for (int i = 0; i < n; i++) {
+    if (frequencias[i] > 0) {
+      simbolos[tamanho] = i;
+      heap[tamanho].frequencia = frequencias[i];
+      heap[tamanho].ordem = tamanho;
+      tamanho++;
+    }
+  }
+  int folhas = tamanho;
+  for (int i = tamanho / 2 - 1; i >= 0; i--) {
+    desceNoHeap(heap, tamanho, i);
+  }
+
+  // cria nós internos até sobrar o nó raiz
+  int ordem = folhas;
+  while (tamanho > 1) {
+    // remove os dois itens de menor frequência
+    ItemFila esquerdo = removeDoHeap(heap, &tamanho);
+    ItemFila direito = removeDoHeap(heap, &tamanho);
+
+    // cria nó interno e reinsere no heap
+    filhos[2 * (ordem - folhas)] = esquerdo.ordem;
+    filhos[2 * (ordem - folhas) + 1] = direito.ordem;
+    heap[tamanho].frequencia = esquerdo.frequencia + direito.frequencia;
+    heap[tamanho].ordem = ordem++;
+    sobeNoHeap(heap, tamanho);
+    tamanho++;
+  }
+
+  return folhas;
+}
+
+Arvore *constroiArvoreDeFrequencias(const uint64_t frequencias[], int n,
+                                    ArenaArvore *arena) {
+  int simbolos[MAX_SIMBOLOS_ALFABETO];
+  int filhos[2 * MAX_SIMBOLOS_ALFABETO];
+  int folhas = combinaNos(frequencias, n, simbolos, filhos);
+  if (folhas == 0) {
+    return NULL;
+  }
+
+  // os nós são criados na ordem dos índices: as folhas e depois os internos
+  Arvore *nos[2 * MAX_SIMBOLOS_ALFABETO];
+  for (int k = 0; k < folhas; k++) {
+    nos[k] = criaNoFolhaNaArena(arena, simbolos[k], frequencias[simbolos[k]]);
+  }
+  for (int k = 0; k < folhas - 1; k++) {
+    nos[folhas + k] = criaNoInternoNaArena(arena, nos[filhos[2 * k]],
+                                           nos[filhos[2 * k + 1]]);
+  }
+
+  return nos[2 * folhas - 2];
+}
+
+int calculaComprimentosDeFrequencias(const uint64_t frequencias[], int n,
+                                     unsigned char comprimentos[]) {
+  int simbolos[MAX_SIMBOLOS_ALFABETO];
+  int filhos[2 * MAX_SIMBOLOS_ALFABETO];
+  int folhas = combinaNos(frequencias, n, simbolos, filhos);
+
+  for (int i = 0; i < n; i++) {
+    comprimentos[i] = 0;
+  }
+  if (folhas == 0) {
+    return 0;
+  }
+  if (folhas == 1) {
+    comprimentos[simbolos[0]] = 1;
+    return 1;
+  }
+
+  // cada nó interno foi criado depois dos filhos, então descendo da raiz
+  // (o último nó) a profundidade do pai já é conhecida
+  int profundidade[2 * MAX_SIMBOLOS_ALFABETO];
+  profundidade[2 * folhas - 2] = 0;
+  for (int k = folhas - 2; k >= 0; k--) {
+    int filho = profundidade[folhas + k] + 1;
+    profundidade[filhos[2 * k]] = filho;
+    profundidade[filhos[2 * k + 1]] = filho;
+  }
+
+  int maior = 0;
+  for (int k = 0; k < folhas; k++) {
+    comprimentos[simbolos[k]] = (unsigned char)profundidade[k];
+    if (profundidade[k] > maior) {
+      maior = profundidade[k];
+    }
+  }
+
+  return maior;
+}
+
+static void percorreComprimentos(Arvore *a, int profundidade,
+                                 unsigned char comprimentos[], int *maior) {
+  if (ehNoFolha(a)) {
+    comprimentos[getCaractere(a)] = (unsigned char)profundidade;
+    if (profundidade > *maior) {
+      *maior = profundidade;
+    }
+    return;
+  }
+  percorreComprimentos(getEsquerda(a), profundidade + 1, comprimentos, maior);
+  percorreComprimentos(getDireita(a), profundidade + 1, comprimentos, maior);
+}
+
+int calculaComprimentos(Arvore *raiz, unsigned char comprimentos[], int n) {
+  for (int i = 0; i < n; i++) {
+    comprimentos[i] = 0;
+  }
+
+  if (raiz == NULL) {
+    return 0;
+  }
+
+  // com uma única folha o código teria 0 bits; usa 1 bit para o fluxo
+  // continuar decodificável
+  if (ehNoFolha(raiz)) {
+    comprimentos[getCaractere(raiz)] = 1;
+    return 1;
+  }
+
+  int maior = 0;
+  percorreComprimentos(raiz, 0, comprimentos, &maior);
+
+  return maior;
+}
+
+// item de um nível do package-merge: um símbolo ou um pacote de dois itens
+// do nível anterior
+typedef struct {
+  int64_t peso;
+  int simbolo; // -1 para pacotes
+} ItemPacote;
+
+// ordena os símbolos presentes por frequência (e pelo símbolo nos empates)
+static int comparaItemPacote(const void *a, const void *b) {
+  const ItemPacote *x = a;
+  const ItemPacote *y = b;
+  if (x->peso != y->peso) {
+    return x->peso < y->peso ? -1 : 1;
+  }
+  return x->simbolo - y->simbolo;
+}
+
+int calculaComprimentosLimitados(const uint64_t frequencias[], int n, int limite,
+                                 unsigned char comprimentos[]) {
+  for (int i = 0; i < n; i++) {
+    comprimentos[i] = 0;
+  }
+
+  if (limite < 1 || limite > MAX_COMPRIMENTO_CODIGO ||
+      n > MAX_SIMBOLOS_ALFABETO) {
+    return -1;
+  }
+
+  ItemPacote folhas[MAX_SIMBOLOS_ALFABETO];
+  int m = 0;
+  for (int i = 0; i < n; i++) {
+    if (frequencias[i] > 0) {
+      folhas[m].peso = (int64_t)frequencias[i];
+      folhas[m].simbolo = i;
+      m++;
+    }
+  }
+
+  if (m <= 1) {
+    if (m == 1) {
+      comprimentos[folhas[0].simbolo] = 1;
+    }
+    return 0;
+  }
+
+  // 'limite' bits comportam no máximo 2^limite símbolos
+  if (limite < 31 && m > (1 << limite)) {
+    return -1;
+  }
+
+  qsort(folhas, m, sizeof(ItemPacote), comparaItemPacote);
+
+  // Cada nível, do mais profundo (0) até a raiz (limite - 1), intercala as
+  // folhas com os pacotes formados pelos pares do nível anterior, e tem no
+  // máximo m folhas e m - 1 pacotes. Só os pesos de dois níveis ficam
+  // guardados; de cada nível basta saber quais posições são folhas, porque
+  // as folhas entram sempre na mesma ordem.
+  int64_t pesos[2][2 * MAX_SIMBOLOS_ALFABETO];
+  uint64_t ehFolha[MAX_COMPRIMENTO_CODIGO][2 * MAX_SIMBOLOS_ALFABETO / 64];
+  int tamanho = m;
+  for (int i = 0; i < m; i++) {
+    pesos[0][i] = folhas[i].peso;
+  }
+
+  for (int j = 1; j < limite; j++) {
+    const int64_t *anterior = pesos[(j - 1) & 1];
+    int64_t *atual = pesos[j & 1];
+    uint64_t *bits = ehFolha[j];
+    memset(bits, 0, (2 * (size_t)m + 63) / 64 * sizeof(uint64_t));
+    int pacotes = tamanho / 2;
+
+    // nos empates a folha vem primeiro
+    int f = 0, p = 0, k = 0;
+    while (f < m || p < pacotes) {
+      int64_t pesoPacote =
+          p < pacotes ? anterior[2 * p] + anterior[2 * p + 1] : 0;
+      if (p >= pacotes || (f < m && folhas[f].peso <= pesoPacote)) {
+        bits[k / 64] |= (uint64_t)1 << (k % 64);
+        atual[k++] = folhas[f++].peso;
+      } else {
+        atual[k++] = pesoPacote;
+        p++;
+      }
+    }
+    tamanho = k;
+  }
+
+  // seleciona os 2m - 2 primeiros itens do nível da raiz e desce: cada
+  // pacote selecionado seleciona os dois itens que o formaram, que são sempre
+  // os primeiros do nível anterior. As folhas entre os selecionados são as
+  // primeiras da ordem, e cada uma ganha um bit.
+  int selecionados = 2 * m - 2;
+  for (int j = limite - 1; j >= 0 && selecionados > 0; j--) {
+    int quantasFolhas = selecionados;
+    if (j > 0) {
+      quantasFolhas = 0;
+      for (int i = 0; i < selecionados; i++) {
+        quantasFolhas += (int)((ehFolha[j][i / 64] >> (i % 64)) & 1);
+      }
+    }
+    for (int i = 0; i < quantasFolhas; i++) {
+      comprimentos[folhas[i].simbolo]++;
+    }
+    selecionados = 2 * (selecionados - quantasFolhas);
+  }
+
+  return 0;
+}
+
+int aplicaLimiteComprimentos(const uint64_t frequencias[], int n, int limiteBits,
+                             int maior, unsigned char comprimentos[]) {
+  if (limiteBits <= 0 || maior <= limiteBits) {
+    return 0;
+  }
+
+  return calculaComprimentosLimitados(frequencias, n, limiteBits,
+                                      comprimentos);
+}
+
+uint64_t calculaBitsCodificados(const uint64_t frequencias[],
+                                const unsigned char comprimentos[], int n) {
+  uint64_t total = 0;
+
+  for (int i = 0; i < n; i++) {
+    total += (uint64_t)frequencias[i] * comprimentos[i];
+  }
+
+  return total;
+}
+
+int geraCodigosCanonicos(const unsigned char comprimentos[], int n,
+                         uint64_t codigos[]) {
+  int quantidade[MAX_COMPRIMENTO_CODIGO + 1] = {0};
+  int usados = 0;
+
+  for (int i = 0; i < n; i++) {
+    if (comprimentos[i] > MAX_COMPRIMENTO_CODIGO) {
+      return -1;
+    }
+    if (comprimentos[i] > 0) {
+      quantidade[comprimentos[i]]++;
+      usados++;
+    }
+  }
+
+  // um único símbolo de 1 bit é aceito mesmo sem completar o código
+  int unico = usados == 1 && quantidade[1] == 1;
+
+  // confere se os códigos preenchem exatamente todas as folhas: em cada nível
+  // sobram 'livres' posições, que precisam caber nos símbolos restantes
+  int64_t livres = 1;
+  int restantes = usados;
+  for (int comp = 1; comp <= MAX_COMPRIMENTO_CODIGO && !unico; comp++) {
+    livres = livres * 2 - quantidade[comp];
+    restantes -= quantidade[comp];
+    if (livres < 0 || livres > restantes) {
+      return -1;
+    }
+  }
+
+  uint64_t proximo[MAX_COMPRIMENTO_CODIGO + 1];
+  uint64_t codigo = 0;
+  proximo[0] = 0;
+  for (int comp = 1; comp <= MAX_COMPRIMENTO_CODIGO; comp++) {
+    codigo = (codigo + (comp > 1 ? quantidade[comp - 1] : 0)) << 1;
+    proximo[comp] = codigo;
+  }
+
+  for (int i = 0; i < n; i++) {
+    codigos[i] = comprimentos[i] ? proximo[comprimentos[i]]++ : 0;
+  }
+
+  return 0;
+}
+
+int montaTabelaCodigos(const unsigned char comprimentos[], int n,
+                       CodigoHuffman tabela[]) {
+  uint64_t codigos[MAX_SIMBOLOS_ALFABETO];
+  if (n > MAX_SIMBOLOS_ALFABETO) {
+    return -1;
+  }
+
+  int resultado = geraCodigosCanonicos(comprimentos, n, codigos);
+  for (int i = 0; i < n; i++) {
+    tabela[i].codigo = codigos[i];
+    tabela[i].comprimento = comprimentos[i];
+  }
+
+  return resultado;
+}
+
+// transforma os comprimentos na sequência de símbolos do segundo alfabeto,
+// cada um acompanhado do valor dos seus bits extras
+static int geraSimbolosComprimento(const unsigned char comprimentos[], int n,
+                                   int simbolos[], int extras[]) {
+  int total = 0;
+  int i = 0;
+
+  while (i < n) {
+    int atual = comprimentos[i];
+    int corrida = 1;
+    while (i + corrida < n && comprimentos[i + corrida] == atual) {
+      corrida++;
+    }
+
+    if (atual == 0 && corrida >= 3) {
+      if (corrida > 138) {
+        corrida = 138;
+      }
+      if (corrida >= 11) {
+        simbolos[total] = ZEROS_LONGO;
+        extras[total++] = corrida - 11;
+      } else {
+        simbolos[total] = ZEROS_CURTO;
+        extras[total++] = corrida - 3;
+      }
+      i += corrida;
+      continue;
+    }
+
+    // escreve o próprio comprimento uma vez...
+    if (atual >= 16) {
+      simbolos[total] = COMPRIMENTO_LONGO;
+      extras[total++] = atual - 16;
+    } else {
+      simbolos[total] = atual;
+      extras[total++] = 0;
+    }
+    i++;
+    corrida--;
+
+    // ...e as repetições seguintes em grupos de 3 a 6
+    while (corrida >= 3) {
+      int grupo = corrida > 6 ? 6 : corrida;
+      simbolos[total] = REPETE_ANTERIOR;
+      extras[total++] = grupo - 3;
+      i += grupo;
+      corrida -= grupo;
+    }
+  }
+
+  return total;
+}
+
+static int bitsExtras(int simbolo) {
+  switch (simbolo) {
+  case REPETE_ANTERIOR:
+    return 2;
+  case ZEROS_CURTO:
+    return 3;
+  case ZEROS_LONGO:
+    return 7;
+  case COMPRIMENTO_LONGO:
+    return 6;
+  default:
+    return 0;
+  }
+}
+
+void escreveComprimentos(bitmap *bm, const unsigned char comprimentos[],
+                         int n) {
+  int simbolos[MAX_SIMBOLOS_ALFABETO];
+  int extras[MAX_SIMBOLOS_ALFABETO];
+
+  int total = geraSimbolosComprimento(comprimentos, n, simbolos, extras);
+
+  // código de Huffman para o próprio alfabeto dos comprimentos
+  uint64_t frequencias[NUM_SIMBOLOS_COMPRIMENTO] = {0};
+  for (int i = 0; i < total; i++) {
+    frequencias[simbolos[i]]++;
+  }
+
+  unsigned char compCodigo[NUM_SIMBOLOS_COMPRIMENTO];
+  uint64_t codigos[NUM_SIMBOLOS_COMPRIMENTO];
+  calculaComprimentosDeFrequencias(frequencias, NUM_SIMBOLOS_COMPRIMENTO,
+                                   compCodigo);
+  geraCodigosCanonicos(compCodigo, NUM_SIMBOLOS_COMPRIMENTO, codigos);
+
+  // no máximo MAX_SIMBOLOS_ALFABETO (512) ocorrências, abaixo das 2584
+  // (Fibonacci) que uma árvore de 16 níveis exigiria: a árvore nunca passa de
+  // 15 níveis, então cada comprimento cabe em 4 bits
+  int gravados = NUM_SIMBOLOS_COMPRIMENTO;
+  while (gravados > 4 && compCodigo[ordemComprimentos[gravados - 1]] == 0) {
+    gravados--;
+  }
+
+  bitmapAppendBits(bm, gravados - 4, 5);
+  for (int i = 0; i < gravados; i++) {
+    bitmapAppendBits(bm, compCodigo[ordemComprimentos[i]], 4);
+  }
+
+  for (int i = 0; i < total; i++) {
+    int s = simbolos[i];
+    bitmapAppendBits(bm, codigos[s], compCodigo[s]);
+    bitmapAppendBits(bm, extras[i], bitsExtras(s));
+  }
+}
+
+// Lê um símbolo do código canônico bit a bit: em cada comprimento, os códigos
+// vão de 'primeiro' a primeiro + quantidade - 1, e os símbolos estão em
+// 'ordenados' na ordem canônica. Retorna -1 se nenhum código servir.
+static int leSimboloCanonico(LeitorBits *l, const int quantidade[16],
+                             const int ordenados[]) {
+  int codigo = 0;
+  int primeiro = 0;
+  int indice = 0;
+  for (int comp = 1; comp < 16; comp++) {
+    codigo |= (int)leBits(l, 1);
+    if (codigo - primeiro < quantidade[comp]) {
+      return ordenados[indice + codigo - primeiro];
+    }
+    indice += quantidade[comp];
+    primeiro = (primeiro + quantidade[comp]) << 1;
+    codigo <<= 1;
+  }
+
+  return -1;
+}
+
+int leComprimentos(LeitorBits *l, unsigned char comprimentos[], int n) {
+  unsigned char compCodigo[NUM_SIMBOLOS_COMPRIMENTO] = {0};
+
+  int gravados = leBits(l, 5) + 4;
+  if (gravados > NUM_SIMBOLOS_COMPRIMENTO) {
+    return -1;
+  }
+  for (int i = 0; i < gravados; i++) {
+    compCodigo[ordemComprimentos[i]] = leBits(l, 4);
+  }
+
+  // o alfabeto é pequeno e cada cabeçalho tem poucos símbolos: a
+  // decodificação canônica bit a bit dispensa montar uma tabela
+  uint64_t codigos[NUM_SIMBOLOS_COMPRIMENTO];
+  if (geraCodigosCanonicos(compCodigo, NUM_SIMBOLOS_COMPRIMENTO, codigos) !=
+      0) {
+    return -1;
+  }
+  int quantidade[16] = {0};
+  int ordenados[NUM_SIMBOLOS_COMPRIMENTO];
+  int total = 0;
+  for (int comp = 1; comp < 16; comp++) {
+    for (int s = 0; s < NUM_SIMBOLOS_COMPRIMENTO; s++) {
+      if (compCodigo[s] == comp) {
+        quantidade[comp]++;
+        ordenados[total++] = s;
+      }
+    }
+  }
+
+  int i = 0;
+  while (i < n && !leitorEstourou(l)) {
+    int s = leSimboloCanonico(l, quantidade, ordenados);
+    if (s < 0) {
+      break;
+    }
+    int extra = bitsExtras(s) ? leBits(l, bitsExtras(s)) : 0;
+    int valor = 0;
+    int repeticoes = 1;
+
+    if (s < 16) {
+      valor = s;
+    } else if (s == COMPRIMENTO_LONGO) {
+      valor = 16 + extra;
+    } else if (s == REPETE_ANTERIOR) {
+      if (i == 0) {
+        break;
+      }
+      valor = comprimentos[i - 1];
+      repeticoes = 3 + extra;
+    } else {
+      repeticoes = (s == ZEROS_CURTO ? 3 : 11) + extra;
+    }
+
+    if (i + repeticoes > n) {
+      break;
+    }
+    while (repeticoes-- > 0) {
+      comprimentos[i++] = (unsigned char)valor;
+    }
+  }
+
+  return (i == n && !leitorEstourou(l)) ? 0 : -1;
+}
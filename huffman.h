@@ -0,0 +1,170 @@
+/*
+ *
+ * Construção dos códigos de Huffman
+ * Árvore a partir das frequências, comprimentos dos códigos, códigos
+ * canônicos e o cabeçalho compacto com os comprimentos
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef HUFFMAN_H
+#define HUFFMAN_H
+
+#include "arvore.h"
+#include "bitmap.h"
+#include "leitor.h"
+#include <stdint.h>
+
+// "\x89HUF" no início do arquivo. Arquivos do formato original começam com a
+// árvore em pré-ordem, e o único que pode começar com o bit 1 é o arquivo
+// vazio (byte 0xC0), então a assinatura nunca se confunde com eles.
+#define ASSINATURA_FORMATO 0x89485546u
+
+// versão com códigos canônicos e só os comprimentos no cabeçalho
+#define VERSAO_CANONICA 1
+
+// versão sem compactação: os bytes originais logo depois da versão, para as
+// entradas que os códigos não deixariam menores
+#define VERSAO_ARMAZENADA 8
+
+#define NUM_SIMBOLOS 257
+#define SIMBOLO_EOF 256
+#define MAX_COMPRIMENTO_CODIGO 64
+
+// maior alfabeto aceito pelas funções abaixo, que guardam as áreas de
+// trabalho na pilha em vez de alocá-las a cada chamada (o maior dos
+// alfabetos usados é o dos literais e comprimentos da etapa LZ77)
+#define MAX_SIMBOLOS_ALFABETO 512
+
+/**
+ * @brief Código de um símbolo pronto para a escrita: o valor e o comprimento
+ * ficam lado a lado, e a tabela inteira cabe em poucas linhas de cache.
+ */
+typedef struct {
+  uint64_t codigo;
+  unsigned int comprimento;
+} CodigoHuffman;
+
+/**
+ * @brief Constrói a árvore de Huffman para os símbolos com frequência não
+ * nula, usando um heap binário como fila de prioridade.
+ * @param frequencias Frequência de cada símbolo.
+ * @param n Quantidade de símbolos do alfabeto.
+ * @param arena Arena onde os nós são criados, com espaço para 2n - 1 nós; a
+ * árvore é liberada junto com ela.
+ * @return A raiz da árvore, ou NULL se nenhum símbolo aparece.
+ */
+Arvore *constroiArvoreDeFrequencias(const uint64_t frequencias[], int n,
+                                    ArenaArvore *arena);
+
+/**
+ * @brief Calcula os comprimentos dos códigos direto das frequências, sem
+ * criar os nós da árvore: o mesmo resultado de constroiArvoreDeFrequencias
+ * seguida de calculaComprimentos, sem alocar memória.
+ * @param frequencias Frequência de cada símbolo.
+ * @param n Quantidade de símbolos do alfabeto.
+ * @param comprimentos Saída com n posições; símbolos ausentes ficam com 0.
+ * @return O maior comprimento encontrado.
+ */
+int calculaComprimentosDeFrequencias(const uint64_t frequencias[], int n,
+                                     unsigned char comprimentos[]);
+
+/**
+ * @brief Calcula o comprimento do código de cada símbolo (a profundidade da
+ * sua folha). Se a árvore tiver uma única folha, o símbolo recebe 1 bit.
+ * @param raiz Raiz da árvore de Huffman.
+ * @param comprimentos Saída com n posições; símbolos ausentes ficam com 0.
+ * @param n Quantidade de símbolos do alfabeto.
+ * @return O maior comprimento encontrado.
+ */
+int calculaComprimentos(Arvore *raiz, unsigned char comprimentos[], int n);
+
+/**
+ * @brief Calcula comprimentos ótimos sob a restrição de nenhum código passar
+ * de 'limite' bits, pelo algoritmo package-merge.
+ *
+ * Para cada nível de 1 a 'limite' os símbolos são combinados em pacotes de
+ * dois itens do nível mais profundo; os 2m - 2 itens mais leves do último
+ * nível determinam quantas vezes cada símbolo é contado, que é o seu
+ * comprimento. Com o limite maior ou igual à profundidade da árvore de
+ * Huffman, o custo total é o mesmo dela.
+ *
+ * @param frequencias Frequência de cada símbolo.
+ * @param n Quantidade de símbolos do alfabeto.
+ * @param limite Comprimento máximo permitido (até MAX_COMPRIMENTO_CODIGO).
+ * @param comprimentos Saída com n posições; símbolos ausentes ficam com 0.
+ * @return 0 em caso de sucesso, -1 se os símbolos não cabem no limite.
+ */
+int calculaComprimentosLimitados(const uint64_t frequencias[], int n, int limite,
+                                 unsigned char comprimentos[]);
+
+/**
+ * @brief Garante que nenhum código passe de 'limiteBits', refazendo os
+ * comprimentos pelo package-merge quando a árvore tiver ficado mais funda.
+ * @param frequencias Frequência de cada símbolo.
+ * @param n Quantidade de símbolos do alfabeto.
+ * @param limiteBits Comprimento máximo (0 = sem limite).
+ * @param maior Maior comprimento atual (retorno de calculaComprimentos).
+ * @param comprimentos Comprimentos atuais, substituídos se preciso.
+ * @return 0 em caso de sucesso, -1 se os símbolos não cabem no limite.
+ */
+int aplicaLimiteComprimentos(const uint64_t frequencias[], int n, int limiteBits,
+                             int maior, unsigned char comprimentos[]);
+
+/**
+ * @brief Calcula o tamanho, em bits, dos dados codificados com os
+ * comprimentos dados (soma de frequência vezes comprimento).
+ * @param frequencias Frequência de cada símbolo.
+ * @param comprimentos Comprimento do código de cada símbolo.
+ * @param n Quantidade de símbolos do alfabeto.
+ * @return O total de bits.
+ */
+uint64_t calculaBitsCodificados(const uint64_t frequencias[],
+                                const unsigned char comprimentos[], int n);
+
+/**
+ * @brief Atribui os códigos canônicos: códigos mais curtos vêm antes e, no
+ * mesmo comprimento, seguem a ordem dos símbolos.
+ *
+ * Também valida os comprimentos: o código precisa ser completo (a não ser
+ * quando existe um único símbolo, de 1 bit) e nenhum comprimento pode passar
+ * de MAX_COMPRIMENTO_CODIGO.
+ *
+ * @param comprimentos Comprimento de cada símbolo (0 = ausente).
+ * @param n Quantidade de símbolos do alfabeto.
+ * @param codigos Saída com o código de cada símbolo.
+ * @return 0 em caso de sucesso, -1 se os comprimentos forem inválidos.
+ */
+int geraCodigosCanonicos(const unsigned char comprimentos[], int n,
+                         uint64_t codigos[]);
+
+/**
+ * @brief Monta a tabela de códigos canônicos usada na escrita.
+ * @param comprimentos Comprimento de cada símbolo (0 = ausente).
+ * @param n Quantidade de símbolos do alfabeto.
+ * @param tabela Saída com o código e o comprimento de cada símbolo.
+ * @return 0 em caso de sucesso, -1 se os comprimentos forem inválidos.
+ */
+int montaTabelaCodigos(const unsigned char comprimentos[], int n,
+                       CodigoHuffman tabela[]);
+
+/**
+ * @brief Escreve os comprimentos no mapa de bits, codificados por
+ * comprimento de corrida e por um segundo código de Huffman.
+ * @param bm Mapa de bits de saída.
+ * @param comprimentos Comprimento de cada símbolo.
+ * @param n Quantidade de símbolos do alfabeto.
+ */
+void escreveComprimentos(bitmap *bm, const unsigned char comprimentos[],
+                         int n);
+
+/**
+ * @brief Lê os comprimentos escritos por escreveComprimentos.
+ * @param l Leitor posicionado no início dos comprimentos.
+ * @param comprimentos Saída com n posições.
+ * @param n Quantidade de símbolos do alfabeto.
+ * @return 0 em caso de sucesso, -1 se o cabeçalho for inválido.
+ */
+int leComprimentos(LeitorBits *l, unsigned char comprimentos[], int n);
+
+#endif // HUFFMAN_H
@@ -0,0 +1,112 @@
+/*
+ *
+ * Tad LeitorBits
+ * Leitura bufferizada de bits (do mais significativo para o menos
+ * significativo) usando um acumulador de 64 bits
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "leitor.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TAMANHO_AREA_LEITURA (64 * 1024)
+
+static void iniciaLeitor(LeitorBits *l) {
+  l->buffer = 0;
+  l->bitsNoBuffer = 0;
+  l->pos = NULL;
+  l->fim = NULL;
+  l->arq = NULL;
+  l->dadosArq = NULL;
+  l->bytesAlemDoFim = 0;
+}
+
+void iniciaLeitorArquivo(LeitorBits *l, FILE *arq) {
+  iniciaLeitor(l);
+  l->arq = arq;
+  l->dadosArq = malloc(TAMANHO_AREA_LEITURA);
+  if (l->dadosArq == NULL) {
+    exit(1);
+  }
+  l->pos = l->dadosArq;
+  l->fim = l->dadosArq;
+}
+
+void iniciaLeitorMemoria(LeitorBits *l, const unsigned char *dados,
+                         size_t tamanho) {
+  iniciaLeitor(l);
+  l->pos = dados;
+  l->fim = dados + tamanho;
+}
+
+void finalizaLeitor(LeitorBits *l) {
+  free(l->dadosArq);
+  l->dadosArq = NULL;
+}
+
+// busca mais dados no arquivo, retorna 0 se não há mais nada para ler
+static int reabasteceLeitor(LeitorBits *l) {
+  if (l->arq == NULL) {
+    return 0;
+  }
+
+  size_t lidos = fread(l->dadosArq, 1, TAMANHO_AREA_LEITURA, l->arq);
+  l->pos = l->dadosArq;
+  l->fim = l->dadosArq + lidos;
+
+  return lidos > 0;
+}
+
+void recarregaLeitorLento(LeitorBits *l) {
+  while (l->bitsNoBuffer <= 56) {
+    if (l->pos == l->fim && !reabasteceLeitor(l)) {
+      // acabou a entrada: completa com zeros e registra quantos foram usados
+      l->bytesAlemDoFim++;
+      l->bitsNoBuffer += 8;
+      continue;
+    }
+    l->buffer |= (uint64_t)*l->pos++ << (56 - l->bitsNoBuffer);
+    l->bitsNoBuffer += 8;
+  }
+}
+
+size_t leBytes(LeitorBits *l, unsigned char *destino, size_t n) {
+  size_t lidos = 0;
+
+  // primeiro os bytes que já estão no acumulador, sem contar os zeros
+  // inventados depois do fim da entrada
+  size_t noBuffer = l->bitsNoBuffer / 8;
+  size_t reais = noBuffer > l->bytesAlemDoFim ? noBuffer - l->bytesAlemDoFim : 0;
+  while (lidos < n && reais > 0) {
+    destino[lidos++] = (unsigned char)(l->buffer >> 56);
+    consomeBits(l, 8);
+    reais--;
+  }
+
+  if (lidos == n) {
+    return lidos;
+  }
+
+  // o acumulador ficou vazio (ou só com zeros inventados após o fim); ele pode
+  // guardar restos de bytes parcialmente copiados, que não valem mais
+  if (l->bytesAlemDoFim > 0) {
+    return lidos;
+  }
+  l->buffer = 0;
+  l->bitsNoBuffer = 0;
+
+  while (lidos < n) {
+    if (l->pos == l->fim && !reabasteceLeitor(l)) {
+      break;
+    }
+    size_t disponivel = (size_t)(l->fim - l->pos);
+    size_t copia = n - lidos < disponivel ? n - lidos : disponivel;
+    memcpy(destino + lidos, l->pos, copia);
+    l->pos += copia;
+    lidos += copia;
+  }
+
+  return lidos;
+}
@@ -0,0 +1,147 @@
+/*
+ *
+ * Tad LeitorBits
+ * Leitura bufferizada de bits (do mais significativo para o menos
+ * significativo) usando um acumulador de 64 bits
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef LEITOR_H
+#define LEITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Estrutura do leitor de bits.
+ *
+ * Diferente dos outros TADs, a estrutura é exposta aqui para que as funções do
+ * caminho crítico da decodificação (espiar, consumir e recarregar bits) possam
+ * ser expandidas inline pelo compilador.
+ */
+typedef struct leitorBits {
+  uint64_t buffer;           // próximos bits, alinhados à esquerda
+  unsigned int bitsNoBuffer; // quantos bits do buffer são válidos
+  const unsigned char *pos;  // próximo byte ainda não carregado no buffer
+  const unsigned char *fim;  // fim dos bytes disponíveis
+  FILE *arq;                 // NULL quando a leitura é feita da memória
+  unsigned char *dadosArq;   // área de leitura usada quando arq != NULL
+  size_t bytesAlemDoFim;     // bytes zerados inseridos após o fim da entrada
+} LeitorBits;
+
+/**
+ * @brief Inicializa um leitor que consome um arquivo aberto em modo binário.
+ * @param l Ponteiro para o leitor.
+ * @param arq Arquivo de onde os bits serão lidos.
+ */
+void iniciaLeitorArquivo(LeitorBits *l, FILE *arq);
+
+/**
+ * @brief Inicializa um leitor sobre uma região de memória.
+ * @param l Ponteiro para o leitor.
+ * @param dados Início da região (não é copiada).
+ * @param tamanho Tamanho da região em bytes.
+ */
+void iniciaLeitorMemoria(LeitorBits *l, const unsigned char *dados,
+                         size_t tamanho);
+
+/**
+ * @brief Libera os recursos internos do leitor (não fecha o arquivo).
+ * @param l Ponteiro para o leitor.
+ */
+void finalizaLeitor(LeitorBits *l);
+
+/**
+ * @brief Recarrega o buffer byte a byte, buscando mais dados no arquivo
+ * quando necessário. Depois do fim da entrada, completa o buffer com zeros.
+ * @param l Ponteiro para o leitor.
+ */
+void recarregaLeitorLento(LeitorBits *l);
+
+/**
+ * @brief Garante ao menos 57 bits válidos no buffer.
+ * @param l Ponteiro para o leitor.
+ */
+static inline void recarregaLeitor(LeitorBits *l) {
+  if (l->bitsNoBuffer > 56) {
+    return;
+  }
+  if (l->fim - l->pos >= 8) {
+    const unsigned char *p = l->pos;
+    uint64_t v = ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+                 ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+                 ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+                 ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+    // os bits do byte parcialmente copiado serão copiados de novo, iguais,
+    // na próxima recarga
+    l->buffer |= v >> l->bitsNoBuffer;
+    l->pos += (63 - l->bitsNoBuffer) >> 3;
+    l->bitsNoBuffer |= 56;
+  } else {
+    recarregaLeitorLento(l);
+  }
+}
+
+/**
+ * @brief Retorna os próximos n bits sem consumi-los.
+ * @param l Ponteiro para o leitor.
+ * @param n Quantidade de bits (1 a 57, já presentes no buffer).
+ */
+static inline uint32_t espiaBits(const LeitorBits *l, unsigned int n) {
+  return (uint32_t)(l->buffer >> (64 - n));
+}
+
+/**
+ * @brief Descarta os próximos n bits do buffer.
+ * @param l Ponteiro para o leitor.
+ * @param n Quantidade de bits (no máximo bitsNoBuffer).
+ */
+static inline void consomeBits(LeitorBits *l, unsigned int n) {
+  l->buffer <<= n;
+  l->bitsNoBuffer -= n;
+}
+
+/**
+ * @brief Lê e consome os próximos n bits.
+ * @param l Ponteiro para o leitor.
+ * @param n Quantidade de bits (1 a 32).
+ * @return Os bits lidos, o primeiro deles na posição mais significativa.
+ */
+static inline uint32_t leBits(LeitorBits *l, unsigned int n) {
+  recarregaLeitor(l);
+  uint32_t v = espiaBits(l, n);
+  consomeBits(l, n);
+  return v;
+}
+
+/**
+ * @brief Descarta os bits que faltam para chegar ao próximo limite de byte.
+ * @param l Ponteiro para o leitor.
+ */
+static inline void alinhaLeitor(LeitorBits *l) {
+  consomeBits(l, l->bitsNoBuffer % 8);
+}
+
+/**
+ * @brief Lê bytes inteiros, a partir de uma posição alinhada, sem passar
+ * pelo acumulador de bits.
+ * @param l Ponteiro para o leitor (alinhado com alinhaLeitor).
+ * @param destino Área que recebe os bytes.
+ * @param n Quantidade de bytes a ler.
+ * @return Quantidade de bytes efetivamente lidos (menor que n no fim).
+ */
+size_t leBytes(LeitorBits *l, unsigned char *destino, size_t n);
+
+/**
+ * @brief Indica se já foram consumidos bits inventados além do fim da
+ * entrada, o que acontece quando o fluxo está truncado ou corrompido.
+ * @param l Ponteiro para o leitor.
+ * @return 1 se a entrada acabou antes do esperado, 0 caso contrário.
+ */
+static inline int leitorEstourou(const LeitorBits *l) {
+  return l->bytesAlemDoFim * 8 > l->bitsNoBuffer;
+}
+
+#endif // LEITOR_H
@@ -0,0 +1,250 @@
+/*
+ *
+ * Processamento em lote
+ * Compacta ou descompacta vários arquivos em um único processo, com um
+ * conjunto de trabalhadores que reaproveitam as suas estruturas de um
+ * arquivo para o outro
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "lote.h"
+#include "compactador.h"
+#include "descompactador.h"
+#include "pool.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// lista de caminhos que cresce conforme os arquivos são encontrados
+typedef struct {
+  char **caminhos;
+  int quantidade;
+  int capacidade;
+} ListaArquivos;
+
+typedef struct {
+  const OpcoesLote *op;
+  ListaArquivos *lista;
+  int proximo; // próximo arquivo a ser entregue
+  int falhas;  // arquivos que não puderam ser processados
+  Estatisticas *porTrabalhador; // somadas no fim, sem disputa entre threads
+} ContextoLote;
+
+static void adicionaArquivo(ListaArquivos *lista, const char *caminho) {
+  if (lista->quantidade == lista->capacidade) {
+    lista->capacidade = lista->capacidade ? 2 * lista->capacidade : 64;
+    lista->caminhos =
+        realloc(lista->caminhos, lista->capacidade * sizeof(char *));
+    if (lista->caminhos == NULL) {
+      exit(1);
+    }
+  }
+
+  lista->caminhos[lista->quantidade] = strdup(caminho);
+  if (lista->caminhos[lista->quantidade] == NULL) {
+    exit(1);
+  }
+  lista->quantidade++;
+}
+
+static int terminaEmComp(const char *caminho) {
+  size_t len = strlen(caminho);
+  return len > 5 && strcmp(caminho + len - 5, ".comp") == 0;
+}
+
+// percorre o diretório e os seus subdiretórios; os links simbólicos não são
+// seguidos, para não sair da árvore nem entrar em ciclos
+static int percorreDiretorio(const char *diretorio, int descompactar,
+                             ListaArquivos *lista) {
+  DIR *dir = opendir(diretorio);
+  if (dir == NULL) {
+    fprintf(stderr, "erro: %s\n", diretorio);
+    return -1;
+  }
+
+  int resultado = 0;
+  struct dirent *entrada;
+  while ((entrada = readdir(dir)) != NULL) {
+    if (strcmp(entrada->d_name, ".") == 0 ||
+        strcmp(entrada->d_name, "..") == 0) {
+      continue;
+    }
+
+    size_t tamanho = strlen(diretorio) + strlen(entrada->d_name) + 2;
+    char *caminho = malloc(tamanho);
+    if (caminho == NULL) {
+      exit(1);
+    }
+    snprintf(caminho, tamanho, "%s/%s", diretorio, entrada->d_name);
+
+    struct stat info;
+    if (lstat(caminho, &info) != 0) {
+      fprintf(stderr, "erro: %s\n", caminho);
+      resultado = -1;
+    } else if (S_ISDIR(info.st_mode)) {
+      if (percorreDiretorio(caminho, descompactar, lista) != 0) {
+        resultado = -1;
+      }
+    } else if (S_ISREG(info.st_mode) &&
+               terminaEmComp(caminho) == descompactar) {
+      adicionaArquivo(lista, caminho);
+    }
+    free(caminho);
+  }
+
+  closedir(dir);
+  return resultado;
+}
+
+// lê um caminho por linha; linhas vazias são ignoradas
+static void leListaArquivos(FILE *arq, ListaArquivos *lista) {
+  char *linha = NULL;
+  size_t capacidade = 0;
+  ssize_t lidos;
+
+  while ((lidos = getline(&linha, &capacidade, arq)) != -1) {
+    while (lidos > 0 &&
+           (linha[lidos - 1] == '\n' || linha[lidos - 1] == '\r')) {
+      linha[--lidos] = '\0';
+    }
+    if (lidos > 0) {
+      adicionaArquivo(lista, linha);
+    }
+  }
+
+  free(linha);
+}
+
+// cada trabalhador pega o próximo arquivo da lista até ela acabar, sempre
+// com o mesmo compactador ou descompactador
+static void executaTrabalhador(void *contexto, int indice) {
+  ContextoLote *ctx = contexto;
+  const OpcoesLote *op = ctx->op;
+  Estatisticas *total = &ctx->porTrabalhador[indice];
+  Compactador *c = NULL;
+  Descompactador *d = NULL;
+
+  for (;;) {
+    int i = __atomic_fetch_add(&ctx->proximo, 1, __ATOMIC_RELAXED);
+    if (i >= ctx->lista->quantidade) {
+      break;
+    }
+    const char *caminho = ctx->lista->caminhos[i];
+
+    int resultado;
+    if (op->descompactar) {
+      if (!terminaEmComp(caminho)) {
+        resultado = -1;
+      } else {
+        if (d == NULL) {
+          d = criaDescompactador(caminho);
+          defineThreadsDescompactacao(d, 1);
+          defineDicionarioDescompactacao(d, op->dicionario);
+        } else {
+          defineArquivoDescompactacao(d, caminho);
+        }
+        resultado = executaDescompactacao(d);
+        somaEstatisticas(total, getEstatisticasDescompactacao(d));
+      }
+    } else {
+      if (c == NULL) {
+        c = criaCompactador(caminho);
+        defineLimiteBits(c, op->limiteBits);
+        defineTamanhoBloco(c, op->tamanhoBloco);
+        defineNumThreads(c, 1);
+        defineNumFluxos(c, op->numFluxos);
+        defineAdaptativo(c, op->adaptativo);
+        defineContexto(c, op->contexto);
+        defineNivelLZ(c, op->nivelLZ);
+        defineTamanhoBlocoBWT(c, op->tamanhoBlocoBWT);
+        defineDicionario(c, op->dicionario);
+      } else {
+        defineArquivoCompactacao(c, caminho);
+      }
+      resultado = executaCompactacao(c);
+      somaEstatisticas(total, getEstatisticasCompactacao(c));
+    }
+
+    if (resultado != 0) {
+      fprintf(stderr, "erro: %s\n", caminho);
+      __atomic_fetch_add(&ctx->falhas, 1, __ATOMIC_RELAXED);
+    }
+  }
+
+  if (c != NULL) {
+    liberaCompactador(c);
+  }
+  if (d != NULL) {
+    liberaDescompactador(d);
+  }
+}
+
+int processaLote(const char *origem, const OpcoesLote *op,
+                 Estatisticas *total) {
+  Cronometro inicio;
+  iniciaCronometroProcesso(&inicio);
+
+  ListaArquivos lista = {NULL, 0, 0};
+  int falhasOrigem = 0;
+
+  struct stat info;
+  if (strcmp(origem, "-") == 0) {
+    leListaArquivos(stdin, &lista);
+  } else if (stat(origem, &info) != 0) {
+    return -1;
+  } else if (S_ISDIR(info.st_mode)) {
+    // entradas ilegíveis do diretório contam como uma falha, mas os arquivos
+    // encontrados são processados mesmo assim
+    if (percorreDiretorio(origem, op->descompactar, &lista) != 0) {
+      falhasOrigem = 1;
+    }
+  } else {
+    FILE *arq = fopen(origem, "r");
+    if (arq == NULL) {
+      return -1;
+    }
+    leListaArquivos(arq, &lista);
+    fclose(arq);
+  }
+
+  int numTrabalhadores = op->numTrabalhadores > 1 ? op->numTrabalhadores : 1;
+  if (numTrabalhadores > lista.quantidade) {
+    numTrabalhadores = lista.quantidade > 0 ? lista.quantidade : 1;
+  }
+
+  ContextoLote ctx;
+  ctx.op = op;
+  ctx.lista = &lista;
+  ctx.proximo = 0;
+  ctx.falhas = 0;
+  ctx.porTrabalhador = calloc(numTrabalhadores, sizeof(Estatisticas));
+  if (ctx.porTrabalhador == NULL) {
+    exit(1);
+  }
+
+  Pool *pool = numTrabalhadores > 1 ? criaPool(numTrabalhadores) : NULL;
+  executaNoPool(pool, numTrabalhadores, executaTrabalhador, &ctx);
+  liberaPool(pool);
+
+  if (total != NULL) {
+    memset(total, 0, sizeof(Estatisticas));
+    for (int i = 0; i < numTrabalhadores; i++) {
+      somaEstatisticas(total, &ctx.porTrabalhador[i]);
+    }
+    finalizaEstatisticas(total, &inicio);
+  }
+
+  fprintf(stderr, "%d arquivo(s), %d falha(s)\n", lista.quantidade,
+          ctx.falhas + falhasOrigem);
+
+  for (int i = 0; i < lista.quantidade; i++) {
+    free(lista.caminhos[i]);
+  }
+  free(lista.caminhos);
+  free(ctx.porTrabalhador);
+
+  return ctx.falhas + falhasOrigem;
+}
@@ -0,0 +1,57 @@
+/*
+ *
+ * Processamento em lote
+ * Compacta ou descompacta vários arquivos em um único processo, com um
+ * conjunto de trabalhadores que reaproveitam as suas estruturas de um
+ * arquivo para o outro
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef LOTE_H
+#define LOTE_H
+
+#include "dicionario.h"
+#include "estatisticas.h"
+#include <stddef.h>
+
+/**
+ * @brief Opções aplicadas a todos os arquivos do lote.
+ */
+typedef struct {
+  int descompactar;     // 0 = compactar, 1 = descompactar
+  int limiteBits;       // comprimento máximo dos códigos (0 = sem limite)
+  size_t tamanhoBloco;  // 0 = fluxo único
+  int numFluxos;        // fluxos intercalados por bloco
+  int adaptativo;       // Huffman adaptativo, em uma única passada
+  int contexto;         // modelo de contexto de ordem 1
+  int nivelLZ;          // esforço da etapa LZ77 (0 = sem a etapa)
+  size_t tamanhoBlocoBWT; // blocos da etapa BWT (0 = sem a etapa)
+  const Dicionario *dicionario; // tabela treinada, ou NULL
+  int numTrabalhadores; // arquivos processados ao mesmo tempo
+} OpcoesLote;
+
+/**
+ * @brief Processa todos os arquivos de uma origem.
+ *
+ * A origem pode ser um diretório, percorrido recursivamente (sem seguir
+ * links simbólicos), um arquivo com um caminho por linha, ou "-" para ler
+ * a lista da entrada padrão. Ao compactar, os arquivos .comp de um diretório
+ * são ignorados; ao descompactar, só eles são considerados.
+ *
+ * Cada trabalhador tem o seu próprio compactador ou descompactador, usado
+ * em todos os arquivos que pega, e processa cada arquivo em uma única
+ * thread. Um arquivo que falha é informado na saída de erro e não
+ * interrompe os demais.
+ *
+ * @param origem Diretório, arquivo com a lista ou "-".
+ * @param op Opções do lote.
+ * @param total Se não for NULL, recebe a soma das estatísticas de todos os
+ * arquivos.
+ * @return A quantidade de arquivos que falharam, ou -1 se a origem não
+ * puder ser lida.
+ */
+int processaLote(const char *origem, const OpcoesLote *op,
+                 Estatisticas *total);
+
+#endif // LOTE_H
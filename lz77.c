@@ -0,0 +1,355 @@
+/*
+ *
+ * Tad BuscadorLZ
+ * Etapa LZ77 antes do Huffman: encontra, por cadeias de hash, trechos que
+ * repetem bytes anteriores e os troca por pares (comprimento, distância)
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "lz77.h"
+#include "estatisticas.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BITS_HASH_MAXIMO 17
+#define BITS_HASH_MINIMO 10
+
+// custos em dezesseis avos de bit; os códigos da classe de comprimento e da
+// classe de distância de uma cópia somam, em média, uns 8 bits
+#define UNIDADES_POR_BIT 16
+#define CUSTO_CODIGOS_COPIA (8 * UNIDADES_POR_BIT)
+
+// as posições nas cadeias são guardadas como posição - base + 1 (0 = vazio)
+// e a base avança antes que elas deixem de caber em 32 bits
+#define LIMITE_POSICAO ((uint64_t)1 << 31)
+
+// sequências só de literais são cortadas nesse tamanho, com folga para o
+// contador de 32 bits
+#define MAXIMO_LITERAIS ((uint64_t)1 << 31)
+
+// maior salto da busca em um trecho sem cópias
+#define PASSO_MAXIMO 32
+
+// Parâmetros de cada nível, nos moldes dos do zlib. Os níveis baixos
+// procuram só nos últimos 64 KiB, para que as cadeias e os dados consultados
+// continuem na cache; a janela inteira fica para os mais altos.
+typedef struct {
+  int cadeia;     // candidatos examinados por posição
+  int boa;        // com uma cópia desse tamanho, a busca seguinte é mais curta
+  int preguica;   // escolha preguiçosa só para cópias mais curtas que isso; no
+                  // modo guloso, maior cópia cujas posições entram nas cadeias
+  int suficiente; // cópia que encerra a busca
+  int preguicoso; // compara com a cópia que começa no byte seguinte
+  int bitsJanela; // alcance da busca (até BITS_JANELA_LZ)
+  int aceleracao; // a cada 2^aceleracao literais seguidos, a busca salta um
+                  // byte a mais (0 = busca em todas as posições)
+} ParametrosNivel;
+
+static const ParametrosNivel parametrosNivel[NIVEL_LZ_MAXIMO + 1] = {
+    {0, 0, 0, 0, 0, 0, 0},
+    {4, 4, 4, 8, 0, 16, 5},
+    {8, 4, 5, 16, 0, 16, 5},
+    {32, 4, 6, 32, 0, 16, 6},
+    {16, 4, 4, 16, 1, 16, 6},
+    {32, 8, 16, 32, 1, 16, 7},
+    {128, 8, 16, 128, 1, 16, 7},
+    {256, 8, 32, 128, 1, 18, 8},
+    {64, 16, 32, 258, 1, 20, 9},
+    {256, 32, 258, COMPRIMENTO_MAXIMO_LZ, 1, 20, 0},
+};
+
+struct buscadorLZ {
+  uint32_t *cabeca;   // posição mais recente de cada hash
+  uint32_t *anterior; // posição anterior com o mesmo hash, pela posição na
+                      // janela
+  unsigned int bitsHash;
+  uint64_t base;
+  ParametrosNivel p;
+  uint32_t custoLiteral[256]; // pelo histograma do bloco
+  uint32_t custoMedio;        // custo médio de um literal
+  SequenciaLZ *seq;           // sequências do bloco, reaproveitadas
+  size_t capacidade;
+};
+
+BuscadorLZ *criaBuscadorLZ(int nivel) {
+  BuscadorLZ *b = calloc(1, sizeof(BuscadorLZ));
+  if (b == NULL) {
+    exit(1);
+  }
+  b->cabeca = malloc(((size_t)1 << BITS_HASH_MAXIMO) * sizeof(uint32_t));
+  b->anterior = malloc(JANELA_LZ * sizeof(uint32_t));
+  b->capacidade = 1024;
+  b->seq = malloc(b->capacidade * sizeof(SequenciaLZ));
+  if (b->cabeca == NULL || b->anterior == NULL || b->seq == NULL) {
+    exit(1);
+  }
+  b->p = parametrosNivel[nivel];
+  return b;
+}
+
+static inline uint32_t hashLZ(const BuscadorLZ *b, const unsigned char *p) {
+  uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+  return (v * 2654435761u) >> (32 - b->bitsHash);
+}
+
+// põe a posição no início da cadeia do seu hash (precisa de 3 bytes)
+static inline void inserePosicao(BuscadorLZ *b, const unsigned char *dados,
+                                 uint64_t pos) {
+  uint32_t h = hashLZ(b, dados + pos);
+  b->anterior[pos & (JANELA_LZ - 1)] = b->cabeca[h];
+  b->cabeca[h] = (uint32_t)(pos - b->base + 1);
+}
+
+// avança a base até a janela atual, esquecendo as posições mais antigas
+static void avancaBase(BuscadorLZ *b, uint64_t pos) {
+  uint32_t delta = (uint32_t)(pos - b->base - JANELA_LZ);
+  size_t tamanhoHash = (size_t)1 << b->bitsHash;
+  for (size_t i = 0; i < tamanhoHash; i++) {
+    b->cabeca[i] = b->cabeca[i] > delta ? b->cabeca[i] - delta : 0;
+  }
+  for (size_t i = 0; i < JANELA_LZ; i++) {
+    b->anterior[i] = b->anterior[i] > delta ? b->anterior[i] - delta : 0;
+  }
+  b->base += delta;
+}
+
+// quantos bytes a e b têm em comum, até o limite
+static inline uint32_t comprimentoComum(const unsigned char *a,
+                                        const unsigned char *b,
+                                        uint32_t limite) {
+  uint32_t n = 0;
+  while (n + 8 <= limite) {
+    uint64_t x, y;
+    memcpy(&x, a + n, sizeof(x));
+    memcpy(&y, b + n, sizeof(y));
+    if (x != y) {
+      break;
+    }
+    n += 8;
+  }
+  while (n < limite && a[n] == b[n]) {
+    n++;
+  }
+  return n;
+}
+
+// custo dos literais de ordem 0 de cada byte, pelo histograma do bloco
+static void calculaCustosLiterais(BuscadorLZ *b, const uint64_t frequencias[],
+                                  uint64_t n) {
+  // nenhum código de Huffman tem menos de 1 bit
+  double total = log2Inteiro(n);
+  double soma = 0;
+  for (int s = 0; s < 256; s++) {
+    double bits =
+        frequencias[s] > 0 ? total - log2Inteiro(frequencias[s]) : 0;
+    b->custoLiteral[s] =
+        (uint32_t)((bits > 1 ? bits : 1) * UNIDADES_POR_BIT);
+    soma += (double)frequencias[s] * b->custoLiteral[s];
+  }
+  b->custoMedio = (uint32_t)(soma / (double)n);
+}
+
+// custo estimado de uma cópia: os códigos das classes e os bits extras
+static inline uint32_t custoCopia(uint32_t comprimento, uint32_t distancia) {
+  return CUSTO_CODIGOS_COPIA +
+         UNIDADES_POR_BIT *
+             (bitsExtrasDaClasse(
+                  classeDoValor(comprimento - COMPRIMENTO_MINIMO_LZ)) +
+              bitsExtrasDaClasse(classeDoValor(distancia - 1)));
+}
+
+// economia estimada de uma cópia em relação aos literais médios
+static inline int64_t ganhoCopia(const BuscadorLZ *b, uint32_t comprimento,
+                                 uint32_t distancia) {
+  return (int64_t)comprimento * b->custoMedio -
+         custoCopia(comprimento, distancia);
+}
+
+// uma cópia só vale a pena se custar menos que os seus bytes como literais
+static int copiaCompensa(const BuscadorLZ *b, const unsigned char *dados,
+                         uint32_t comprimento, uint32_t distancia) {
+  uint32_t custo = custoCopia(comprimento, distancia);
+
+  uint32_t literais = 0;
+  for (uint32_t i = 0; i < comprimento && literais <= custo; i++) {
+    literais += b->custoLiteral[dados[i]];
+  }
+  return literais > custo;
+}
+
+// procura na cadeia a cópia mais longa para a posição, examinando até
+// 'cadeia' candidatos; retorna o comprimento (0 se não houver cópia que
+// valha a pena)
+static uint32_t buscaCopia(const BuscadorLZ *b, const unsigned char *dados,
+                           uint64_t n, uint64_t pos, int cadeia,
+                           uint32_t *distancia) {
+  uint32_t limite = n - pos < COMPRIMENTO_MAXIMO_LZ ? (uint32_t)(n - pos)
+                                                    : COMPRIMENTO_MAXIMO_LZ;
+  if (limite < COMPRIMENTO_MINIMO_LZ) {
+    return 0;
+  }
+
+  const unsigned char *atual = dados + pos;
+  uint32_t melhor = COMPRIMENTO_MINIMO_LZ - 1;
+  uint32_t melhorDistancia = 0;
+  uint32_t candidato = b->cabeca[hashLZ(b, atual)];
+  uint64_t janela = (uint64_t)1 << b->p.bitsJanela;
+
+  for (int restantes = cadeia; candidato != 0 && restantes > 0; restantes--) {
+    uint64_t c = b->base + candidato - 1;
+    uint64_t d = pos - c;
+    if (d > janela) {
+      break;
+    }
+
+    // o byte que tornaria a cópia mais longa que a melhor decide primeiro
+    if (dados[c + melhor] == atual[melhor]) {
+      uint32_t comprimento = comprimentoComum(dados + c, atual, limite);
+      if (comprimento > melhor) {
+        melhor = comprimento;
+        melhorDistancia = (uint32_t)d;
+        if (comprimento >= (uint32_t)b->p.suficiente || comprimento == limite) {
+          break;
+        }
+      }
+    }
+    candidato = b->anterior[c & (JANELA_LZ - 1)];
+  }
+
+  if (melhorDistancia == 0 ||
+      !copiaCompensa(b, atual, melhor, melhorDistancia)) {
+    return 0;
+  }
+  *distancia = melhorDistancia;
+  return melhor;
+}
+
+// acrescenta uma sequência ao vetor do buscador, dobrando-o quando enche; o
+// vetor fica com o tamanho do maior bloco analisado
+static void acrescentaSequencia(BuscadorLZ *b, size_t *quantidade,
+                                uint64_t literais, uint32_t comprimento,
+                                uint32_t distancia) {
+  if (*quantidade == b->capacidade) {
+    b->capacidade *= 2;
+    b->seq = realloc(b->seq, b->capacidade * sizeof(SequenciaLZ));
+    if (b->seq == NULL) {
+      exit(1);
+    }
+  }
+  b->seq[*quantidade].literais = (uint32_t)literais;
+  b->seq[*quantidade].comprimento = comprimento;
+  b->seq[*quantidade].distancia = distancia;
+  (*quantidade)++;
+}
+
+const SequenciaLZ *analisaLZ(BuscadorLZ *b, const unsigned char *dados,
+                             uint64_t inicio, uint64_t fim,
+                             const uint64_t frequencias[],
+                             size_t *quantidade) {
+  *quantidade = 0;
+  if (fim <= inicio) {
+    return NULL;
+  }
+
+  // uma nova entrada esvazia as cadeias; a tabela de hash acompanha o
+  // tamanho do primeiro bloco, para que arquivos pequenos não paguem por
+  // zerá-la inteira
+  if (inicio == 0) {
+    b->bitsHash = BITS_HASH_MINIMO;
+    while (b->bitsHash < BITS_HASH_MAXIMO &&
+           ((uint64_t)1 << b->bitsHash) < fim) {
+      b->bitsHash++;
+    }
+    memset(b->cabeca, 0, ((size_t)1 << b->bitsHash) * sizeof(uint32_t));
+    b->base = 0;
+  }
+  calculaCustosLiterais(b, frequencias, fim - inicio);
+
+  uint64_t inicioLiterais = inicio;
+  uint64_t pos = inicio;
+  while (pos < fim) {
+    if (pos - b->base >= LIMITE_POSICAO) {
+      avancaBase(b, pos);
+    }
+    if (pos - inicioLiterais >= MAXIMO_LITERAIS) {
+      acrescentaSequencia(b, quantidade, pos - inicioLiterais, 0, 0);
+      inicioLiterais = pos;
+    }
+
+    uint32_t distancia;
+    uint32_t comprimento = buscaCopia(b, dados, fim, pos, b->p.cadeia, &distancia);
+    if (fim - pos >= COMPRIMENTO_MINIMO_LZ) {
+      inserePosicao(b, dados, pos);
+    }
+    if (comprimento == 0) {
+      // quanto mais longo o trecho sem cópias, mais bytes a busca salta; os
+      // saltados ainda entram nas cadeias
+      uint64_t passo = 1;
+      if (b->p.aceleracao > 0) {
+        passo += (pos - inicioLiterais) >> b->p.aceleracao;
+        passo = passo < PASSO_MAXIMO ? passo : PASSO_MAXIMO;
+      }
+      uint64_t fimSalto = fim - pos > passo ? pos + passo : fim;
+      for (pos++; pos < fimSalto; pos++) {
+        if (fim - pos >= COMPRIMENTO_MINIMO_LZ) {
+          inserePosicao(b, dados, pos);
+        }
+      }
+      continue;
+    }
+
+    // escolha preguiçosa: enquanto a cópia do byte seguinte economizar mais,
+    // mesmo pagando o byte atual como literal, ele vira literal
+    if (b->p.preguicoso) {
+      while (comprimento < (uint32_t)b->p.preguica) {
+        int cadeia = comprimento >= (uint32_t)b->p.boa ? b->p.cadeia / 4
+                                                       : b->p.cadeia;
+        uint32_t distanciaSeguinte;
+        uint32_t seguinte =
+            buscaCopia(b, dados, fim, pos + 1, cadeia, &distanciaSeguinte);
+        if (seguinte <= comprimento ||
+            ganhoCopia(b, seguinte, distanciaSeguinte) -
+                    b->custoLiteral[dados[pos]] <=
+                ganhoCopia(b, comprimento, distancia)) {
+          break;
+        }
+        pos++;
+        inserePosicao(b, dados, pos);
+        comprimento = seguinte;
+        distancia = distanciaSeguinte;
+      }
+    }
+
+    acrescentaSequencia(b, quantidade, pos - inicioLiterais, comprimento,
+                        distancia);
+
+    // as posições cobertas pela cópia também entram nas cadeias, a não ser
+    // nas cópias longas do modo guloso
+    uint64_t fimCopia = pos + comprimento;
+    if (b->p.preguicoso || comprimento <= (uint32_t)b->p.preguica) {
+      for (pos++; pos < fimCopia; pos++) {
+        if (fim - pos >= COMPRIMENTO_MINIMO_LZ) {
+          inserePosicao(b, dados, pos);
+        }
+      }
+    }
+    pos = fimCopia;
+    inicioLiterais = pos;
+  }
+
+  if (inicioLiterais < fim) {
+    acrescentaSequencia(b, quantidade, fim - inicioLiterais, 0, 0);
+  }
+
+  return b->seq;
+}
+
+void liberaBuscadorLZ(BuscadorLZ *b) {
+  if (b != NULL) {
+    free(b->cabeca);
+    free(b->anterior);
+    free(b->seq);
+    free(b);
+  }
+}
@@ -0,0 +1,140 @@
+/*
+ *
+ * Tad BuscadorLZ
+ * Etapa LZ77 antes do Huffman: encontra, por cadeias de hash, trechos que
+ * repetem bytes anteriores e os troca por pares (comprimento, distância)
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef LZ77_H
+#define LZ77_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// versão com a etapa LZ77: assinatura, versão, tamanho máximo dos blocos em
+// 32 bits e os blocos, terminados por um bloco de tamanho 0. Cada bloco tem
+// o tamanho em 32 bits e o tipo em 2 bits, seguidos dos comprimentos dos
+// alfabetos de literais e comprimentos e de distâncias e dos códigos até o
+// EOF (com cópias), dos comprimentos e dos códigos dos bytes (direto) ou dos
+// bytes alinhados (armazenado). As cópias alcançam os blocos anteriores.
+#define VERSAO_LZ77 9
+
+#define NIVEL_LZ_MINIMO 1
+#define NIVEL_LZ_MAXIMO 9
+#define NIVEL_LZ_PADRAO 6
+
+// as cópias alcançam até 1 MiB para trás
+#define BITS_JANELA_LZ 20
+#define JANELA_LZ ((size_t)1 << BITS_JANELA_LZ)
+
+// A entrada é analisada e codificada um bloco por vez, cada um com as suas
+// tabelas: a memória das sequências não cresce com o arquivo. O
+// descompactador aceita blocos de até TAMANHO_BLOCO_LZ_MAXIMO.
+#define TAMANHO_BLOCO_LZ ((uint32_t)JANELA_LZ)
+#define TAMANHO_BLOCO_LZ_MAXIMO ((uint32_t)8 * 1024 * 1024)
+
+// cada bloco escolhe a forma mais curta: literais e cópias, o Huffman direto
+// dos bytes (quando as cópias não compensam) ou os bytes sem compactação
+#define BLOCO_LZ_COPIAS 0
+#define BLOCO_LZ_DIRETO 1
+#define BLOCO_LZ_ARMAZENADO 2
+
+#define COMPRIMENTO_MINIMO_LZ 3
+#define COMPRIMENTO_MAXIMO_LZ 1026
+
+// Comprimentos e distâncias são divididos em classes: os valores de 0 a 3
+// têm uma classe cada, e cada potência de 2 acima disso é dividida em duas
+// classes, identificadas pelo bit seguinte ao mais significativo. Os bits
+// restantes vão depois do código da classe, sem codificação.
+#define NUM_CLASSES_COMPRIMENTO 20 // comprimento - 3, de 0 a 1023
+#define NUM_DISTANCIAS_LZ 40       // distância - 1, de 0 a 2^20 - 1
+
+// alfabeto dos literais e comprimentos: os 256 bytes, o EOF (fim do bloco) e
+// uma classe de comprimento em cada símbolo seguinte
+#define PRIMEIRO_COMPRIMENTO_LZ 257
+#define NUM_LITERAIS_LZ (PRIMEIRO_COMPRIMENTO_LZ + NUM_CLASSES_COMPRIMENTO)
+
+typedef struct buscadorLZ BuscadorLZ;
+
+/**
+ * @brief Uma sequência da análise: 'literais' bytes copiados da entrada,
+ * seguidos de uma cópia de 'comprimento' bytes de 'distancia' bytes atrás
+ * (comprimento 0 = só os literais).
+ */
+typedef struct {
+  uint32_t literais;
+  uint32_t comprimento;
+  uint32_t distancia;
+} SequenciaLZ;
+
+/**
+ * @brief Classe de um valor (comprimento - 3 ou distância - 1).
+ * @param v Valor (menor que 2^31).
+ * @return A classe.
+ */
+static inline unsigned int classeDoValor(uint32_t v) {
+  if (v < 4) {
+    return v;
+  }
+  unsigned int b = 31 - (unsigned int)__builtin_clz(v);
+  return 2 * b + ((v >> (b - 1)) & 1);
+}
+
+/**
+ * @brief Quantidade de bits que seguem o código da classe.
+ * @param classe Classe do valor.
+ */
+static inline unsigned int bitsExtrasDaClasse(unsigned int classe) {
+  return classe < 4 ? 0 : classe / 2 - 1;
+}
+
+/**
+ * @brief Menor valor da classe.
+ * @param classe Classe do valor.
+ */
+static inline uint32_t baseDaClasse(unsigned int classe) {
+  if (classe < 4) {
+    return classe;
+  }
+  return (uint32_t)(2 | (classe & 1)) << (classe / 2 - 1);
+}
+
+/**
+ * @brief Cria o buscador, com as cadeias de hash da janela inteira e o vetor
+ * das sequências de um bloco. Pode ser reaproveitado por vários arquivos.
+ * @param nivel Esforço da busca, de NIVEL_LZ_MINIMO a NIVEL_LZ_MAXIMO: mais
+ * candidatos por posição, uma janela maior, menos saltos nos trechos sem
+ * cópias e, a partir do nível 4, a escolha preguiçosa (a cópia que começa no
+ * byte seguinte ganha se economizar mais bits).
+ * @return Ponteiro para o buscador.
+ */
+BuscadorLZ *criaBuscadorLZ(int nivel);
+
+/**
+ * @brief Divide um bloco da entrada em sequências de literais e cópias. Os
+ * blocos são analisados em ordem, e as cópias alcançam os bytes dos blocos
+ * anteriores que ainda estão na janela.
+ * @param b Ponteiro para o buscador.
+ * @param dados Bytes da entrada inteira.
+ * @param inicio Posição do bloco (0 começa uma nova entrada).
+ * @param fim Posição seguinte ao último byte do bloco.
+ * @param frequencias Histograma dos 256 bytes do bloco, que dá o custo de
+ * cada literal: uma cópia só entra se custar menos que os seus bytes.
+ * @param quantidade Recebe a quantidade de sequências.
+ * @return Vetor com as sequências, do buscador e válido até a próxima
+ * chamada, ou NULL se o bloco for vazio.
+ */
+const SequenciaLZ *analisaLZ(BuscadorLZ *b, const unsigned char *dados,
+                             uint64_t inicio, uint64_t fim,
+                             const uint64_t frequencias[],
+                             size_t *quantidade);
+
+/**
+ * @brief Libera o buscador.
+ * @param b Ponteiro para o buscador (pode ser NULL).
+ */
+void liberaBuscadorLZ(BuscadorLZ *b);
+
+#endif // LZ77_H
@@ -1,53 +1,385 @@
+#include "bloco.h"
+#include "bwt.h"
 #include "compactador.h"
 #include "descompactador.h"
+#include "dicionario.h"
+#include "huffman.h"
+#include "lote.h"
+#include "lz77.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-// Função para verificar se um arquivo existe
+// Função para verificar se um arquivo existe (e pode ser lido); não abre o
+// arquivo, porque abrir e fechar uma pipe nomeada só para testar deixaria o
+// processo que escreve nela sem leitor
 int arquivo_existe(const char *nome_arquivo) {
-  FILE *arq = fopen(nome_arquivo, "rb");
-  if (arq) {
-    fclose(arq);
-    return 1; // Existe
+  return access(nome_arquivo, R_OK) == 0;
+}
+
+// converte tamanhos como 4096, 128K ou 4M em bytes; retorna 0 se inválido
+static size_t le_tamanho(const char *texto) {
+  char *fim;
+  unsigned long long valor = strtoull(texto, &fim, 10);
+
+  if (*fim == 'k' || *fim == 'K') {
+    valor *= 1024;
+    fim++;
+  } else if (*fim == 'm' || *fim == 'M') {
+    valor *= 1024 * 1024;
+    fim++;
+  }
+
+  return *fim == '\0' ? (size_t)valor : 0;
+}
+
+// menor limite de bits em que cabem os códigos de um alfabeto
+static int bits_minimos(int simbolos) {
+  int bits = 0;
+  while ((1 << bits) < simbolos) {
+    bits++;
+  }
+  return bits;
+}
+
+// escreve na saída padrão o intervalo pedido, em pedaços de 1 MiB
+static int extrai_intervalo(const char *nome_arquivo,
+                            unsigned long long inicio,
+                            unsigned long long quantidade) {
+  size_t tamanhoPedaco = 1024 * 1024;
+  unsigned char *pedaco = malloc(tamanhoPedaco);
+  if (pedaco == NULL) {
+    return 1;
+  }
+
+  Descompactador *descompactador = criaDescompactador(nome_arquivo);
+  int resultado = 0;
+
+  while (quantidade > 0) {
+    size_t pedido = quantidade < tamanhoPedaco ? quantidade : tamanhoPedaco;
+    long long extraidos =
+        extraiIntervalo(descompactador, inicio, pedaco, pedido);
+    if (extraidos == EXTRACAO_SEM_INDICE) {
+      fprintf(stderr,
+              "erro: %s não tem índice de blocos; a extração exige um "
+              "arquivo compactado com -b\n",
+              nome_arquivo);
+      resultado = 1;
+      break;
+    }
+    if (extraidos < 0) {
+      resultado = 1;
+      break;
+    }
+    if (extraidos == 0) {
+      break;
+    }
+    fwrite(pedaco, 1, (size_t)extraidos, stdout);
+    inicio += (unsigned long long)extraidos;
+    quantidade -= (unsigned long long)extraidos;
+  }
+
+  liberaDescompactador(descompactador);
+  free(pedaco);
+
+  return resultado;
+}
+
+// mostra as estatísticas na saída de erro no formato pedido (0 = nenhum)
+static void imprime_estatisticas(const Estatisticas *e, const char *operacao,
+                                 int formato) {
+  if (formato == 1) {
+    imprimeEstatisticas(e, operacao, stderr);
+  } else if (formato == 2) {
+    imprimeEstatisticasJson(e, operacao, stderr);
   }
-  return 0; // Não existe
 }
 
 int main(int argc, char *argv[]) {
 
-  // espera 3 argumentos -> ./programa <opcao> <arquivo>
-  if (argc != 3) {
+  // espera ao menos 3 argumentos ->
+  // ./programa <opcao> [-l bits] [-b tamanho] [-T threads] [-f fluxos] [-a]
+  // [-o] [-z nivel] [-w bloco] [--table dicionario] [--stats | --stats=json]
+  // [-L] <arquivo>
+  // -l limita o comprimento dos códigos: ao menos 9 bits no fluxo único e
+  // nas etapas, que têm o EOF, e 8 bits nos blocos (-b, -f, -T ou "-")
+  // -a usa o Huffman adaptativo, em uma única passada pela entrada
+  // -o usa o modelo de contexto de ordem 1 (tabela escolhida pelo byte
+  // anterior)
+  // -z passa a entrada pela etapa LZ77 antes do Huffman, com o esforço da
+  // busca de 1 a 9
+  // -w passa a entrada pela etapa BWT (Burrows-Wheeler, move-to-front e
+  // corridas de zeros) antes do Huffman, em blocos desse tamanho (ex.: 900K)
+  // --table usa a tabela de um dicionário treinado, sem árvore nem cabeçalho;
+  // se ela não deixar a entrada menor, os bytes são só copiados
+  // com "-" no lugar do arquivo, lê da entrada padrão e grava na saída padrão;
+  // com -L o arquivo é a origem de um lote: um diretório, uma lista de
+  // caminhos ou "-" para ler a lista da entrada padrão
+  // -x <inicio> <quantidade> <arquivo.comp> só funciona em arquivos
+  // compactados com -b (com ou sem -f), os únicos com índice de blocos
+  if (argc < 3) {
     return 1;
   }
 
   const char *opcao = argv[1];
-  const char *nome_arquivo = argv[2];
+  const char *nome_arquivo = argv[argc - 1];
+
+  // ./programa -x <inicio> <quantidade> <arquivo.comp>: extrai um intervalo
+  // do arquivo original para a saída padrão
+  if (strcmp(opcao, "-x") == 0) {
+    if (argc != 5 || !arquivo_existe(nome_arquivo)) {
+      return 1;
+    }
+    return extrai_intervalo(nome_arquivo, strtoull(argv[2], NULL, 10),
+                            strtoull(argv[3], NULL, 10));
+  }
+
+  // ./programa -t <dicionario> <amostra> [amostra...]: treina um dicionário
+  // com as amostras
+  if (strcmp(opcao, "-t") == 0) {
+    if (argc < 4) {
+      return 1;
+    }
+    return treinaDicionario(argv[2], argv + 3, argc - 3) != 0 ? 1 : 0;
+  }
+
+  int limiteBits = 0;
+  size_t tamanhoBloco = 0;
+  int numThreads = 1;
+  int numFluxos = 1;
+  int estatisticas = 0; // 1 = tabela, 2 = JSON
+  int lote = 0;
+  int adaptativo = 0;
+  int contexto = 0;
+  int nivelLZ = 0;
+  size_t tamanhoBlocoBWT = 0;
+  const char *caminhoDicionario = NULL;
+
+  // opções extras entre a operação e o arquivo
+  for (int i = 2; i < argc - 1; i++) {
+    if (strcmp(argv[i], "-l") == 0 && i + 1 < argc - 1) {
+      limiteBits = atoi(argv[++i]);
+      if (limiteBits < 1 || limiteBits > 64) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc - 1) {
+      tamanhoBloco = le_tamanho(argv[++i]);
+      if (tamanhoBloco < TAMANHO_BLOCO_MINIMO ||
+          tamanhoBloco > TAMANHO_BLOCO_MAXIMO) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc - 1) {
+      numThreads = atoi(argv[++i]);
+      if (numThreads < 1 || numThreads > 1024) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc - 1) {
+      numFluxos = atoi(argv[++i]);
+      if (numFluxos < 1 || numFluxos > MAX_FLUXOS) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--stats") == 0) {
+      estatisticas = 1;
+    } else if (strcmp(argv[i], "--stats=json") == 0) {
+      estatisticas = 2;
+    } else if (strcmp(argv[i], "-L") == 0) {
+      lote = 1;
+    } else if (strcmp(argv[i], "-a") == 0) {
+      adaptativo = 1;
+    } else if (strcmp(argv[i], "-o") == 0) {
+      contexto = 1;
+    } else if (strcmp(argv[i], "-z") == 0 && i + 1 < argc - 1) {
+      nivelLZ = atoi(argv[++i]);
+      if (nivelLZ < NIVEL_LZ_MINIMO || nivelLZ > NIVEL_LZ_MAXIMO) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc - 1) {
+      tamanhoBlocoBWT = le_tamanho(argv[++i]);
+      if (tamanhoBlocoBWT < TAMANHO_BLOCO_BWT_MINIMO ||
+          tamanhoBlocoBWT > TAMANHO_BLOCO_BWT_MAXIMO) {
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--table") == 0 && i + 1 < argc - 1) {
+      caminhoDicionario = argv[++i];
+    } else {
+      return 1;
+    }
+  }
+
+  // o modo adaptativo é um fluxo único, sem blocos nem limite
+  if (adaptativo && (limiteBits > 0 || tamanhoBloco > 0 || numFluxos > 1 ||
+                     (numThreads > 1 && !lote))) {
+    return 1;
+  }
+
+  // o modelo de contexto também é um fluxo único, e precisa de duas passadas
+  // pelo arquivo
+  if (contexto && (adaptativo || tamanhoBloco > 0 || numFluxos > 1 ||
+                   (numThreads > 1 && !lote) ||
+                   strcmp(nome_arquivo, "-") == 0)) {
+    return 1;
+  }
+
+  // o dicionário já traz a tabela, usada em um fluxo único
+  if (caminhoDicionario != NULL &&
+      (adaptativo || contexto || limiteBits > 0 || tamanhoBloco > 0 ||
+       numFluxos > 1 || (numThreads > 1 && !lote))) {
+    return 1;
+  }
+
+  // a etapa LZ77 lê o arquivo mapeado, com as cópias alcançando os blocos
+  // anteriores, em um fluxo único
+  if (nivelLZ > 0 &&
+      (adaptativo || contexto || caminhoDicionario != NULL ||
+       tamanhoBloco > 0 || numFluxos > 1 || (numThreads > 1 && !lote) ||
+       strcmp(nome_arquivo, "-") == 0)) {
+    return 1;
+  }
+
+  // a etapa BWT tem os seus próprios blocos, lidos em sequência, então
+  // também funciona com a entrada padrão
+  if (tamanhoBlocoBWT > 0 &&
+      (adaptativo || contexto || caminhoDicionario != NULL || nivelLZ > 0 ||
+       tamanhoBloco > 0 || numFluxos > 1 || (numThreads > 1 && !lote))) {
+    return 1;
+  }
+
+  // o limite precisa comportar o alfabeto do modo escolhido: os blocos só
+  // têm os 256 bytes, o fluxo único tem também o EOF, e as etapas LZ77 e BWT
+  // têm os seus próprios símbolos. Conferido aqui, antes de qualquer arquivo.
+  if (limiteBits > 0 && strcmp(opcao, "-c") == 0) {
+    int simbolos = NUM_SIMBOLOS;
+    if (nivelLZ > 0) {
+      simbolos = NUM_LITERAIS_LZ;
+    } else if (tamanhoBlocoBWT > 0) {
+      simbolos = NUM_SIMBOLOS_BWT;
+    } else if (!contexto &&
+               (tamanhoBloco > 0 || numFluxos > 1 ||
+                (numThreads > 1 && !lote) ||
+                (!lote && strcmp(nome_arquivo, "-") == 0))) {
+      simbolos = 256;
+    }
+    if (limiteBits < bits_minimos(simbolos)) {
+      fprintf(stderr, "erro: -l %d não comporta os %d símbolos do modo "
+                      "(mínimo de %d bits)\n",
+              limiteBits, simbolos, bits_minimos(simbolos));
+      return 1;
+    }
+  }
+
+  // carregado uma única vez, com as tabelas de decodificação já montadas,
+  // e compartilhado por todos os arquivos
+  Dicionario *dicionario = NULL;
+  if (caminhoDicionario != NULL &&
+      (dicionario = carregaDicionario(caminhoDicionario)) == NULL) {
+    return 1;
+  }
+
+  // no lote, -T é a quantidade de arquivos processados ao mesmo tempo
+  if (lote) {
+    OpcoesLote op;
+    op.descompactar = strcmp(opcao, "-d") == 0;
+    op.limiteBits = limiteBits;
+    op.tamanhoBloco = tamanhoBloco;
+    op.numFluxos = numFluxos;
+    op.adaptativo = adaptativo;
+    op.contexto = contexto;
+    op.nivelLZ = nivelLZ;
+    op.tamanhoBlocoBWT = tamanhoBlocoBWT;
+    op.dicionario = dicionario;
+    op.numTrabalhadores = numThreads;
+    if (!op.descompactar && strcmp(opcao, "-c") != 0) {
+      liberaDicionario(dicionario);
+      return 1;
+    }
+
+    Estatisticas total;
+    int falhas = processaLote(nome_arquivo, &op, &total);
+    liberaDicionario(dicionario);
+    if (falhas < 0) {
+      return 1;
+    }
+    imprime_estatisticas(&total,
+                         op.descompactar ? "descompactacao" : "compactacao",
+                         estatisticas);
+    return falhas != 0 ? 1 : 0;
+  }
+
+  // "-": entrada e saída padrão, em uma única passada
+  int fluxoPadrao = strcmp(nome_arquivo, "-") == 0;
+
+  // o formato gravado em fluxo não tem fluxos intercalados
+  if (fluxoPadrao && numFluxos > 1) {
+    liberaDicionario(dicionario);
+    return 1;
+  }
 
   // verifica se o arquivo de entrada fornecido existe
-  if (!arquivo_existe(nome_arquivo)) {
+  if (!fluxoPadrao && !arquivo_existe(nome_arquivo)) {
+    liberaDicionario(dicionario);
     return 1;
   }
 
   // decide a ação com base na opção (-c ou -d)
+  int codigo = 0;
   if (strcmp(opcao, "-c") == 0) {
     Compactador *compactador = criaCompactador(nome_arquivo);
-    executaCompactacao(compactador);
+    defineLimiteBits(compactador, limiteBits);
+    defineTamanhoBloco(compactador, tamanhoBloco);
+    defineNumThreads(compactador, numThreads);
+    defineNumFluxos(compactador, numFluxos);
+    defineAdaptativo(compactador, adaptativo);
+    defineContexto(compactador, contexto);
+    defineNivelLZ(compactador, nivelLZ);
+    defineTamanhoBlocoBWT(compactador, tamanhoBlocoBWT);
+    defineDicionario(compactador, dicionario);
+    int resultado = fluxoPadrao
+                        ? executaCompactacaoFluxo(compactador, stdin, stdout)
+                        : executaCompactacao(compactador);
+    if (resultado != 0) {
+      codigo = 1;
+    } else if (limiteBits > 0) {
+      // informa quanto o limite custou em relação ao código sem limite
+      unsigned long long sem = getBitsSemLimite(compactador);
+      unsigned long long com = getBitsComLimite(compactador);
+      fprintf(stderr, "limite de %d bits: %llu -> %llu bits (+%.4f%%)\n",
+              limiteBits, sem, com,
+              sem ? 100.0 * (double)(com - sem) / (double)sem : 0.0);
+    }
+
+    if (codigo == 0) {
+      imprime_estatisticas(getEstatisticasCompactacao(compactador),
+                           "compactacao", estatisticas);
+    }
     liberaCompactador(compactador);
 
   } else if (strcmp(opcao, "-d") == 0) {
     // verifica se o arquivo tem a extensão .comp
     int len = strlen(nome_arquivo);
-    if (len < 5 || strcmp(nome_arquivo + len - 5, ".comp") != 0) {
-      return 1;
+    if (!fluxoPadrao &&
+        (len < 5 || strcmp(nome_arquivo + len - 5, ".comp") != 0)) {
+      codigo = 1;
+    } else {
+      Descompactador *descompactador = criaDescompactador(nome_arquivo);
+      defineThreadsDescompactacao(descompactador, numThreads);
+      defineDicionarioDescompactacao(descompactador, dicionario);
+      int resultado = fluxoPadrao ? executaDescompactacaoFluxo(
+                                        descompactador, stdin, stdout)
+                                  : executaDescompactacao(descompactador);
+      if (resultado != 0) {
+        codigo = 1;
+      } else {
+        imprime_estatisticas(getEstatisticasDescompactacao(descompactador),
+                             "descompactacao", estatisticas);
+      }
+      liberaDescompactador(descompactador);
     }
 
-    Descompactador *descompactador = criaDescompactador(nome_arquivo);
-    executaDescompactacao(descompactador);
-    liberaDescompactador(descompactador);
-
   } else {
-    return 1;
+    codigo = 1;
   }
 
-  return 0;
-}
\ No newline at end of file
+  liberaDicionario(dicionario);
+  return codigo;
+}
@@ -0,0 +1,248 @@
+/*
+ *
+ * Tad ContextoMemoria
+ * Compactação e descompactação entre áreas de memória do chamador, sem
+ * passar pelo sistema de arquivos
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "memoria.h"
+#include "bitmap.h"
+#include "bloco.h"
+#include "huffman.h"
+#include "leitor.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct contextoMemoria {
+  size_t tamanhoBloco;
+  int limiteBits;
+  int numFluxos;
+  bitmap *bm; // recebe cada bloco antes da cópia para o destino
+  TabelaDecodificacao *tabela; // remontada a cada bloco descompactado
+  Estatisticas est;
+};
+
+ContextoMemoria *criaContextoMemoria(size_t tamanhoBloco, int limiteBits,
+                                     int numFluxos) {
+  if (tamanhoBloco == 0) {
+    tamanhoBloco = TAMANHO_BLOCO_PADRAO;
+  }
+
+  // abaixo de 8 bits os 256 símbolos podem não caber no limite, e o erro só
+  // apareceria no meio da compactação
+  if (tamanhoBloco < TAMANHO_BLOCO_MINIMO ||
+      tamanhoBloco > TAMANHO_BLOCO_MAXIMO ||
+      (limiteBits != 0 && (limiteBits < 8 || limiteBits > 64)) ||
+      numFluxos < 1 || numFluxos > MAX_FLUXOS) {
+    return NULL;
+  }
+
+  ContextoMemoria *ctx = calloc(1, sizeof(ContextoMemoria));
+  if (ctx == NULL) {
+    return NULL;
+  }
+  ctx->tamanhoBloco = tamanhoBloco;
+  ctx->limiteBits = limiteBits;
+  ctx->numFluxos = numFluxos;
+  ctx->bm =
+      bitmapTentaInit(((uint64_t)tamanhoBloco + FOLGA_BLOCO_COMPACTADO) * 8);
+  ctx->tabela = criaTabelaDecodificacao();
+  if (ctx->bm == NULL || ctx->tabela == NULL) {
+    liberaContextoMemoria(ctx);
+    return NULL;
+  }
+
+  return ctx;
+}
+
+size_t limiteCompactado(size_t n, size_t tamanhoBloco) {
+  if (tamanhoBloco == 0) {
+    tamanhoBloco = TAMANHO_BLOCO_PADRAO;
+  }
+
+  // nenhum bloco compactado passa do seu tamanho original mais a folga
+  size_t numBlocos = (n + tamanhoBloco - 1) / tamanhoBloco;
+  return (size_t)tamanhoCabecalhoIndexado((uint32_t)numBlocos) + n +
+         numBlocos * FOLGA_BLOCO_COMPACTADO;
+}
+
+long long compactaMemoria(ContextoMemoria *ctx, const unsigned char *origem,
+                          size_t n, unsigned char *destino,
+                          size_t capacidade) {
+  Cronometro inicio;
+  iniciaCronometroProcesso(&inicio);
+  memset(&ctx->est, 0, sizeof(Estatisticas));
+
+  uint64_t numBlocos =
+      ((uint64_t)n + ctx->tamanhoBloco - 1) / ctx->tamanhoBloco;
+  if ((origem == NULL && n > 0) || destino == NULL ||
+      numBlocos > UINT32_MAX) {
+    return ERRO_MEMORIA_PARAMETRO;
+  }
+
+  uint64_t deslocamento = tamanhoCabecalhoIndexado((uint32_t)numBlocos);
+  if (deslocamento > capacidade) {
+    return ERRO_MEMORIA_DESTINO_PEQUENO;
+  }
+
+  // o índice vai direto para o destino, uma entrada por bloco
+  montaCabecalhoIndexado(destino,
+                         ctx->numFluxos > 1 ? VERSAO_BLOCOS_INTERCALADOS
+                                            : VERSAO_BLOCOS_INDEXADOS,
+                         (uint32_t)ctx->tamanhoBloco, NULL,
+                         (uint32_t)numBlocos, n);
+
+  for (uint32_t i = 0; i < numBlocos; i++) {
+    size_t posicao = (size_t)i * ctx->tamanhoBloco;
+    size_t tamanho = n - posicao < ctx->tamanhoBloco ? n - posicao
+                                                     : ctx->tamanhoBloco;
+
+    bitmapReinicia(ctx->bm);
+    int codificado =
+        ctx->numFluxos > 1
+            ? compactaBlocoIntercalado(origem + posicao, tamanho,
+                                       ctx->limiteBits, ctx->numFluxos,
+                                       ctx->bm, &ctx->est)
+            : compactaBloco(origem + posicao, tamanho, ctx->limiteBits,
+                            ctx->bm, &ctx->est);
+    if (codificado != 0) {
+      return ERRO_MEMORIA_PARAMETRO;
+    }
+
+    uint32_t totalBytes = (uint32_t)((bitmapGetLength(ctx->bm) + 7) / 8);
+    if (totalBytes > capacidade - deslocamento) {
+      return ERRO_MEMORIA_DESTINO_PEQUENO;
+    }
+    memcpy(destino + deslocamento, bitmapGetContents(ctx->bm), totalBytes);
+
+    EntradaIndice e;
+    e.deslocamento = deslocamento;
+    e.tamanhoCompactado = totalBytes;
+    e.tamanhoOriginal = (uint32_t)tamanho;
+    montaEntradaIndice(destino, i, &e);
+    deslocamento += totalBytes;
+  }
+
+  ctx->est.bytesEntrada = n;
+  ctx->est.bytesSaida = deslocamento;
+  finalizaEstatisticas(&ctx->est, &inicio);
+
+  return (long long)deslocamento;
+}
+
+// confere a assinatura e a versão e lê a parte fixa do cabeçalho; retorna a
+// versão, ou -1 se não for o formato indexado
+static int leInicioIndexado(LeitorBits *l, size_t n, uint32_t *tamanhoBloco,
+                            uint32_t *numBlocos, uint64_t *tamanhoOriginal) {
+  recarregaLeitor(l);
+  if (leBits(l, 32) != ASSINATURA_FORMATO) {
+    return -1;
+  }
+  int versao = (int)leBits(l, 8);
+  if ((versao != VERSAO_BLOCOS_INDEXADOS &&
+       versao != VERSAO_BLOCOS_INTERCALADOS) ||
+      leCabecalhoIndexadoFixo(l, n, tamanhoBloco, numBlocos,
+                              tamanhoOriginal) != 0) {
+    return -1;
+  }
+  return versao;
+}
+
+long long tamanhoOriginalMemoria(const unsigned char *origem, size_t n) {
+  if (origem == NULL) {
+    return ERRO_MEMORIA_PARAMETRO;
+  }
+
+  LeitorBits leitor;
+  iniciaLeitorMemoria(&leitor, origem, n);
+
+  uint32_t tamanhoBloco, numBlocos;
+  uint64_t tamanhoOriginal;
+  int versao = leInicioIndexado(&leitor, n, &tamanhoBloco, &numBlocos,
+                                &tamanhoOriginal);
+  finalizaLeitor(&leitor);
+
+  if (versao < 0 || tamanhoOriginal > (uint64_t)INT64_MAX) {
+    return ERRO_MEMORIA_CORROMPIDO;
+  }
+  return (long long)tamanhoOriginal;
+}
+
+long long descompactaMemoria(ContextoMemoria *ctx, const unsigned char *origem,
+                             size_t n, unsigned char *destino,
+                             size_t capacidade) {
+  Cronometro inicio;
+  iniciaCronometroProcesso(&inicio);
+  memset(&ctx->est, 0, sizeof(Estatisticas));
+
+  if (origem == NULL || destino == NULL) {
+    return ERRO_MEMORIA_PARAMETRO;
+  }
+
+  LeitorBits leitor;
+  iniciaLeitorMemoria(&leitor, origem, n);
+
+  uint32_t tamanhoBloco, numBlocos;
+  uint64_t tamanhoOriginal;
+  int versao = leInicioIndexado(&leitor, n, &tamanhoBloco, &numBlocos,
+                                &tamanhoOriginal);
+  if (versao < 0) {
+    return ERRO_MEMORIA_CORROMPIDO;
+  }
+  if (tamanhoOriginal > capacidade) {
+    return ERRO_MEMORIA_DESTINO_PEQUENO;
+  }
+
+  // as entradas do índice são lidas uma a uma, sem copiar o índice, e cada
+  // bloco é descompactado direto na sua posição do destino
+  uint64_t posicao = 0;
+  for (uint32_t i = 0; i < numBlocos; i++) {
+    EntradaIndice e;
+    if (leEntradaIndice(&leitor, n, tamanhoBloco, numBlocos, posicao, &e) !=
+            0 ||
+        e.tamanhoOriginal > tamanhoOriginal - posicao) {
+      return ERRO_MEMORIA_CORROMPIDO;
+    }
+
+    int resultado =
+        versao == VERSAO_BLOCOS_INTERCALADOS
+            ? descompactaBlocoIntercalado(
+                  origem + e.deslocamento, e.tamanhoCompactado,
+                  destino + posicao, e.tamanhoOriginal, ctx->tabela,
+                  &ctx->est)
+            : descompactaBloco(origem + e.deslocamento, e.tamanhoCompactado,
+                               destino + posicao, e.tamanhoOriginal,
+                               ctx->tabela, &ctx->est);
+    if (resultado != 0) {
+      return ERRO_MEMORIA_CORROMPIDO;
+    }
+    posicao += e.tamanhoOriginal;
+  }
+  finalizaLeitor(&leitor);
+
+  if (posicao != tamanhoOriginal) {
+    return ERRO_MEMORIA_CORROMPIDO;
+  }
+
+  ctx->est.bytesEntrada = n;
+  ctx->est.bytesSaida = posicao;
+  finalizaEstatisticas(&ctx->est, &inicio);
+
+  return (long long)posicao;
+}
+
+const Estatisticas *getEstatisticasMemoria(ContextoMemoria *ctx) {
+  return &ctx->est;
+}
+
+void liberaContextoMemoria(ContextoMemoria *ctx) {
+  if (ctx != NULL) {
+    if (ctx->bm != NULL) {
+      bitmapLibera(ctx->bm);
+    }
+    liberaTabelaDecodificacao(ctx->tabela);
+    free(ctx);
+  }
+}
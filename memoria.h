@@ -0,0 +1,100 @@
+/*
+ *
+ * Tad ContextoMemoria
+ * Compactação e descompactação entre áreas de memória do chamador, sem
+ * passar pelo sistema de arquivos
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef MEMORIA_H
+#define MEMORIA_H
+
+#include "estatisticas.h"
+#include <stddef.h>
+
+// códigos de erro devolvidos pelas funções de compactação e descompactação
+#define ERRO_MEMORIA_PARAMETRO -1       // origem ou destino inválidos
+#define ERRO_MEMORIA_DESTINO_PEQUENO -2 // o resultado não cabe no destino
+#define ERRO_MEMORIA_CORROMPIDO -3      // dados compactados inválidos
+
+typedef struct contextoMemoria ContextoMemoria;
+
+/**
+ * @brief Cria um contexto com as opções de compactação e as áreas de
+ * trabalho, alocadas uma única vez e reaproveitadas em todas as chamadas.
+ *
+ * Um contexto não deve ser usado por duas threads ao mesmo tempo; cada
+ * thread pode ter o seu.
+ *
+ * @param tamanhoBloco Tamanho dos blocos (0 = TAMANHO_BLOCO_PADRAO).
+ * @param limiteBits Comprimento máximo dos códigos (0 = sem limite).
+ * @param numFluxos Fluxos intercalados por bloco (1 a MAX_FLUXOS).
+ * @return Ponteiro para o novo contexto, ou NULL se as opções forem
+ * inválidas ou se faltar memória.
+ */
+ContextoMemoria *criaContextoMemoria(size_t tamanhoBloco, int limiteBits,
+                                     int numFluxos);
+
+/**
+ * @brief Calcula o maior tamanho compactado possível para uma entrada, para
+ * dimensionar o destino de compactaMemoria.
+ * @param n Quantidade de bytes da entrada.
+ * @param tamanhoBloco Tamanho dos blocos (0 = TAMANHO_BLOCO_PADRAO).
+ * @return O tamanho em bytes.
+ */
+size_t limiteCompactado(size_t n, size_t tamanhoBloco);
+
+/**
+ * @brief Compacta uma área de memória no formato em blocos indexado, o mesmo
+ * dos arquivos compactados em blocos.
+ * @param ctx Contexto criado por criaContextoMemoria.
+ * @param origem Bytes a compactar.
+ * @param n Quantidade de bytes.
+ * @param destino Área do chamador que recebe o resultado.
+ * @param capacidade Tamanho do destino (limiteCompactado garante que cabe).
+ * @return Quantidade de bytes gravados no destino, ou um código
+ * ERRO_MEMORIA_* negativo.
+ */
+long long compactaMemoria(ContextoMemoria *ctx, const unsigned char *origem,
+                          size_t n, unsigned char *destino,
+                          size_t capacidade);
+
+/**
+ * @brief Lê do cabeçalho o tamanho original de dados gerados por
+ * compactaMemoria, para dimensionar o destino de descompactaMemoria.
+ * @param origem Dados compactados.
+ * @param n Quantidade de bytes compactados.
+ * @return O tamanho original, ou ERRO_MEMORIA_CORROMPIDO.
+ */
+long long tamanhoOriginalMemoria(const unsigned char *origem, size_t n);
+
+/**
+ * @brief Descompacta uma área de memória gerada por compactaMemoria (ou um
+ * arquivo inteiro no formato em blocos indexado).
+ * @param ctx Contexto criado por criaContextoMemoria.
+ * @param origem Dados compactados.
+ * @param n Quantidade de bytes compactados.
+ * @param destino Área do chamador que recebe os bytes originais.
+ * @param capacidade Tamanho do destino.
+ * @return Quantidade de bytes gravados no destino, ou um código
+ * ERRO_MEMORIA_* negativo.
+ */
+long long descompactaMemoria(ContextoMemoria *ctx, const unsigned char *origem,
+                             size_t n, unsigned char *destino,
+                             size_t capacidade);
+
+/**
+ * @brief Obtém as estatísticas da última chamada feita com o contexto.
+ * @param ctx Contexto criado por criaContextoMemoria.
+ * @return Ponteiro para as estatísticas, válido enquanto o contexto existir.
+ */
+const Estatisticas *getEstatisticasMemoria(ContextoMemoria *ctx);
+
+/**
+ * @brief Libera o contexto e as suas áreas de trabalho.
+ * @param ctx Contexto a ser liberado.
+ */
+void liberaContextoMemoria(ContextoMemoria *ctx);
+
+#endif // MEMORIA_H
@@ -0,0 +1,129 @@
+/*
+ *
+ * Tad Pool
+ * Conjunto fixo de threads que executa um lote de tarefas independentes
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#include "pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+struct pool {
+  pthread_t *threads;
+  int numThreads;
+  pthread_mutex_t trava;
+  pthread_cond_t temTrabalho;
+  pthread_cond_t loteTerminado;
+
+  // lote atual
+  void (*tarefa)(void *contexto, int indice);
+  void *contexto;
+  int proxima;    // próximo índice a ser entregue
+  int total;      // quantidade de tarefas do lote
+  int concluidas; // tarefas já terminadas
+  int encerrar;
+};
+
+static void *executaThread(void *arg) {
+  Pool *p = arg;
+
+  pthread_mutex_lock(&p->trava);
+  for (;;) {
+    while (!p->encerrar && p->proxima >= p->total) {
+      pthread_cond_wait(&p->temTrabalho, &p->trava);
+    }
+    if (p->encerrar) {
+      break;
+    }
+
+    int indice = p->proxima++;
+    pthread_mutex_unlock(&p->trava);
+
+    p->tarefa(p->contexto, indice);
+
+    pthread_mutex_lock(&p->trava);
+    p->concluidas++;
+    if (p->concluidas == p->total) {
+      pthread_cond_signal(&p->loteTerminado);
+    }
+  }
+  pthread_mutex_unlock(&p->trava);
+
+  return NULL;
+}
+
+Pool *criaPool(int numThreads) {
+  Pool *p = calloc(1, sizeof(Pool));
+  if (p == NULL) {
+    exit(1);
+  }
+
+  p->threads = malloc(numThreads * sizeof(pthread_t));
+  if (p->threads == NULL) {
+    exit(1);
+  }
+
+  pthread_mutex_init(&p->trava, NULL);
+  pthread_cond_init(&p->temTrabalho, NULL);
+  pthread_cond_init(&p->loteTerminado, NULL);
+
+  for (int i = 0; i < numThreads; i++) {
+    if (pthread_create(&p->threads[i], NULL, executaThread, p) != 0) {
+      exit(1);
+    }
+    p->numThreads++;
+  }
+
+  return p;
+}
+
+void executaNoPool(Pool *p, int numTarefas,
+                   void (*tarefa)(void *contexto, int indice),
+                   void *contexto) {
+  if (p == NULL) {
+    for (int i = 0; i < numTarefas; i++) {
+      tarefa(contexto, i);
+    }
+    return;
+  }
+
+  if (numTarefas <= 0) {
+    return;
+  }
+
+  pthread_mutex_lock(&p->trava);
+  p->tarefa = tarefa;
+  p->contexto = contexto;
+  p->proxima = 0;
+  p->total = numTarefas;
+  p->concluidas = 0;
+  pthread_cond_broadcast(&p->temTrabalho);
+
+  while (p->concluidas < p->total) {
+    pthread_cond_wait(&p->loteTerminado, &p->trava);
+  }
+  pthread_mutex_unlock(&p->trava);
+}
+
+void liberaPool(Pool *p) {
+  if (p == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&p->trava);
+  p->encerrar = 1;
+  pthread_cond_broadcast(&p->temTrabalho);
+  pthread_mutex_unlock(&p->trava);
+
+  for (int i = 0; i < p->numThreads; i++) {
+    pthread_join(p->threads[i], NULL);
+  }
+
+  pthread_mutex_destroy(&p->trava);
+  pthread_cond_destroy(&p->temTrabalho);
+  pthread_cond_destroy(&p->loteTerminado);
+  free(p->threads);
+  free(p);
+}
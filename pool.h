@@ -0,0 +1,41 @@
+/*
+ *
+ * Tad Pool
+ * Conjunto fixo de threads que executa um lote de tarefas independentes
+ * Autores: Mateus Biancardi e Rafaela Capovilla
+ *
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+typedef struct pool Pool;
+
+/**
+ * @brief Cria o pool e inicia as suas threads, que ficam esperando trabalho.
+ * @param numThreads Quantidade de threads (maior que zero).
+ * @return Ponteiro para o novo Pool.
+ */
+Pool *criaPool(int numThreads);
+
+/**
+ * @brief Executa tarefa(contexto, i) para cada i de 0 a numTarefas - 1,
+ * distribuindo os índices entre as threads. Só retorna quando todas as
+ * tarefas tiverem terminado.
+ * @param p Ponteiro para o Pool (se for NULL, as tarefas rodam em sequência
+ * na própria thread que chamou).
+ * @param numTarefas Quantidade de tarefas.
+ * @param tarefa Função executada para cada índice.
+ * @param contexto Ponteiro repassado para a função.
+ */
+void executaNoPool(Pool *p, int numTarefas,
+                   void (*tarefa)(void *contexto, int indice),
+                   void *contexto);
+
+/**
+ * @brief Encerra as threads e libera o pool.
+ * @param p Ponteiro para o Pool.
+ */
+void liberaPool(Pool *p);
+
+#endif // POOL_H